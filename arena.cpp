@@ -0,0 +1,85 @@
+#include "arena.h"
+#include "runtime.h"
+
+#include <new>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        thread_local Arena* current_arena = nullptr;
+
+        constexpr size_t ALIGNMENT = alignof(max_align_t);
+
+        // Every node is preceded by the arena it came from, nullptr for nodes on the heap
+        constexpr size_t NODE_HEADER = ALIGNMENT;
+        static_assert(sizeof(Arena*) <= NODE_HEADER);
+
+        constexpr size_t AlignUp(size_t size) {
+            return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+        }
+    }  // namespace
+
+    void* Arena::Allocate(size_t size) {
+        size = AlignUp(size);
+        if (static_cast<size_t>(end_ - next_) < size) {
+            // Oversized requests get a block of their own, the current block stays in use
+            const size_t block_size = max(size, BLOCK_SIZE);
+            auto& block = blocks_.emplace_back(new byte[block_size]);
+            if (size > BLOCK_SIZE) {
+                allocated_bytes_ += size;
+                return block.get();
+            }
+            next_ = block.get();
+            end_ = next_ + block_size;
+        }
+        void* result = next_;
+        next_ += size;
+        allocated_bytes_ += size;
+        return result;
+    }
+
+    void Arena::Release() {
+        if (refs_.fetch_sub(1, memory_order_acq_rel) == 1) {
+            delete this;
+        }
+    }
+
+    ArenaScope::ArenaScope() : arena_(new Arena), previous_(current_arena) {
+        current_arena = arena_;
+    }
+
+    ArenaScope::~ArenaScope() {
+        current_arena = previous_;
+        arena_->Release();
+    }
+
+    Arena* ArenaScope::Current() {
+        return current_arena;
+    }
+
+    void* Executable::operator new(size_t size) {
+        Arena* arena = ArenaScope::Current();
+        void* raw = arena ? arena->Allocate(NODE_HEADER + size) : ::operator new(NODE_HEADER + size);
+        if (arena) {
+            arena->AddRef();
+        }
+        *static_cast<Arena**>(raw) = arena;
+        return static_cast<byte*>(raw) + NODE_HEADER;
+    }
+
+    void Executable::operator delete(void* node) {
+        if (!node) {
+            return;
+        }
+        void* raw = static_cast<byte*>(node) - NODE_HEADER;
+        if (Arena* arena = *static_cast<Arena**>(raw)) {
+            arena->Release();
+        }
+        else {
+            ::operator delete(raw);
+        }
+    }
+
+}  // namespace runtime
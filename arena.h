@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace runtime {
+
+    // Bump allocator for the nodes of one parsed program. Nodes created while an ArenaScope is
+    // active on the thread are placed one after another in its blocks, in creation order.
+    // Every node keeps its arena alive, so the blocks are released all at once, after the scope
+    // has ended and the last node of the program has been destroyed
+    class Arena {
+    public:
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        // The result is aligned to std::max_align_t
+        [[nodiscard]] void* Allocate(size_t size);
+
+        void AddRef() {
+            refs_.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void Release();
+
+        [[nodiscard]] size_t GetAllocatedBytes() const {
+            return allocated_bytes_;
+        }
+
+    private:
+        friend class ArenaScope;
+
+        Arena() = default;
+        ~Arena() = default;
+
+        std::vector<std::unique_ptr<std::byte[]>> blocks_;
+        std::byte* next_ = nullptr;
+        std::byte* end_ = nullptr;
+        size_t allocated_bytes_ = 0;
+        std::atomic<size_t> refs_{ 1 };
+    };
+
+    // Makes runtime::Executable nodes created by this thread go to a fresh arena until destroyed.
+    // Scopes nest; the innermost one wins
+    class ArenaScope {
+    public:
+        ArenaScope();
+        ~ArenaScope();
+
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+
+        [[nodiscard]] Arena& GetArena() const {
+            return *arena_;
+        }
+
+        // Arena of the innermost scope of the current thread, nullptr outside of any scope
+        [[nodiscard]] static Arena* Current();
+
+    private:
+        Arena* arena_;
+        Arena* previous_;
+    };
+
+}  // namespace runtime
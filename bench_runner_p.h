@@ -0,0 +1,269 @@
+#pragma once
+
+// Micro-benchmark harness in the manner of test_runner_p.h. A benchmark is a function taking
+// a Bench&: it sets up what it needs and hands the operation to measure to Bench::Run.
+//
+//   void BenchParse(Bench& bench) {
+//       const std::string script = MakeScript();
+//       bench.Run([&] { return Parse(script); });
+//   }
+//
+//   int main(int argc, char* argv[]) {
+//       BenchRunner br(argc, argv);
+//       RUN_BENCH(br, BenchParse);
+//   }
+//
+// Run calls the operation in batches sized to take about a millisecond, first as warmup and
+// then for a number of timed samples, and reports the min, median and p99 time per call over
+// the samples, with the heap allocations per call. Arguments of the binary:
+//   --filter=TEXT   runs only the benchmarks whose names contain TEXT
+//   --samples=N     timed samples per benchmark, 50 by default
+//   --json=PATH     also writes the results to PATH as JSON
+//
+// Allocations are counted by replacing the global operator new, so include this header from
+// the one translation unit of a benchmark binary that has main, and from nowhere else.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace BenchRunnerPrivate {
+    inline std::atomic<std::uint64_t> allocation_count{ 0 };
+
+    inline void* Allocate(std::size_t size) {
+        allocation_count.fetch_add(1, std::memory_order_relaxed);
+        if (void* result = std::malloc(size == 0 ? 1 : size)) {
+            return result;
+        }
+        throw std::bad_alloc();
+    }
+
+    inline std::string JsonString(std::string_view text) {
+        std::string result = "\"";
+        for (const char c : text) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+            }
+            result += c;
+        }
+        return result + '"';
+    }
+}  // namespace BenchRunnerPrivate
+
+void* operator new(std::size_t size) {
+    return BenchRunnerPrivate::Allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return BenchRunnerPrivate::Allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t /*size*/) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t /*size*/) noexcept {
+    std::free(p);
+}
+
+// Keeps the compiler from dropping a computation whose result is otherwise unused
+template <class T>
+void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static const void* volatile sink;
+    sink = &value;
+#endif
+}
+
+class Bench {
+public:
+    struct Result {
+        std::string name;
+        std::uint64_t batch = 0;
+        std::size_t samples = 0;
+        double min_ns = 0;
+        double median_ns = 0;
+        double p99_ns = 0;
+        double allocations = 0;
+        // Items per call when set by SetItemsPerCall, for throughput
+        double items = 0;
+    };
+
+    Bench(std::string name, std::size_t samples)
+        : samples_(samples) {
+        result_.name = std::move(name);
+    }
+
+    // For operations that each process a number of items, like tokens or bytes
+    void SetItemsPerCall(double items) {
+        result_.items = items;
+    }
+
+    // Times the operation; call once per benchmark. A non-void result is kept from the optimizer
+    template <class Operation>
+    void Run(Operation operation) {
+        using Clock = std::chrono::steady_clock;
+        constexpr std::chrono::nanoseconds TARGET_SAMPLE_TIME = std::chrono::milliseconds(1);
+
+        auto run_batch = [&operation](std::uint64_t batch) {
+            const auto start = Clock::now();
+            for (std::uint64_t i = 0; i < batch; ++i) {
+                if constexpr (std::is_void_v<decltype(operation())>) {
+                    operation();
+                }
+                else {
+                    DoNotOptimize(operation());
+                }
+            }
+            return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        };
+
+        // Warmup that also sizes the batches
+        std::uint64_t batch = 1;
+        while (run_batch(batch) < TARGET_SAMPLE_TIME.count() && batch < (std::uint64_t{ 1 } << 40)) {
+            batch *= 2;
+        }
+        run_batch(batch);
+
+        std::vector<double> per_call;
+        per_call.reserve(samples_);
+        const std::uint64_t allocations_before = BenchRunnerPrivate::allocation_count.load();
+        for (std::size_t i = 0; i < samples_; ++i) {
+            per_call.push_back(run_batch(batch) / static_cast<double>(batch));
+        }
+        const std::uint64_t allocations = BenchRunnerPrivate::allocation_count.load() - allocations_before;
+
+        std::sort(per_call.begin(), per_call.end());
+        result_.batch = batch;
+        result_.samples = per_call.size();
+        result_.min_ns = per_call.front();
+        result_.median_ns = per_call[per_call.size() / 2];
+        result_.p99_ns = per_call[(per_call.size() * 99 + 99) / 100 - 1];
+        result_.allocations = static_cast<double>(allocations) / static_cast<double>(batch * samples_);
+        done_ = true;
+    }
+
+    [[nodiscard]] bool IsDone() const {
+        return done_;
+    }
+
+    [[nodiscard]] const Result& GetResult() const {
+        return result_;
+    }
+
+private:
+    std::size_t samples_;
+    Result result_;
+    bool done_ = false;
+};
+
+class BenchRunner {
+public:
+    BenchRunner(int argc, char* argv[]) {
+        for (int i = 1; i < argc; ++i) {
+            const std::string_view arg = argv[i];
+            if (arg.substr(0, 9) == "--filter=") {
+                filter_ = arg.substr(9);
+            }
+            else if (arg.substr(0, 10) == "--samples=") {
+                samples_ = std::max<std::size_t>(1, std::strtoul(argv[i] + 10, nullptr, 10));
+            }
+            else if (arg.substr(0, 7) == "--json=") {
+                json_path_ = arg.substr(7);
+            }
+            else {
+                std::cerr << "Unknown argument " << arg << std::endl;
+                std::exit(2);
+            }
+        }
+    }
+
+    template <class BenchFunc>
+    void RunBench(BenchFunc func, const std::string& bench_name) {
+        if (bench_name.find(filter_) == std::string::npos) {
+            return;
+        }
+        Bench bench(bench_name, samples_);
+        try {
+            func(bench);
+            if (!bench.IsDone()) {
+                throw std::logic_error("the benchmark did not call Bench::Run");
+            }
+        }
+        catch (std::exception& e) {
+            ++fail_count;
+            std::cerr << bench_name << " fail: " << e.what() << std::endl;
+            return;
+        }
+        const Bench::Result& result = bench.GetResult();
+        std::cout << std::left << std::setw(40) << bench_name << std::right << std::fixed << std::setprecision(1)
+                  << " min " << std::setw(10) << result.min_ns << " ns"
+                  << "  median " << std::setw(10) << result.median_ns << " ns"
+                  << "  p99 " << std::setw(10) << result.p99_ns << " ns"
+                  << "  allocs " << std::setprecision(2) << result.allocations;
+        if (result.items > 0) {
+            std::cout << "  " << std::setprecision(1) << result.items / result.median_ns * 1e3 << " M items/s";
+        }
+        std::cout << std::defaultfloat << std::endl;
+        results_.push_back(result);
+    }
+
+    ~BenchRunner() {
+        if (!json_path_.empty()) {
+            std::ofstream output(json_path_);
+            WriteJson(output);
+            if (!output.flush()) {
+                std::cerr << "Cannot write " << json_path_ << std::endl;
+                ++fail_count;
+            }
+        }
+        if (fail_count > 0) {
+            std::cerr << fail_count << " benchmarks failed. Terminate" << std::endl;
+            exit(1);
+        }
+    }
+
+private:
+    void WriteJson(std::ostream& output) const {
+        output << std::setprecision(10) << "{\"benchmarks\": [";
+        for (std::size_t i = 0; i < results_.size(); ++i) {
+            const Bench::Result& result = results_[i];
+            output << (i == 0 ? "\n" : ",\n") << "  {\"name\": " << BenchRunnerPrivate::JsonString(result.name)
+                   << ", \"batch\": " << result.batch << ", \"samples\": " << result.samples
+                   << ", \"min_ns\": " << result.min_ns << ", \"median_ns\": " << result.median_ns
+                   << ", \"p99_ns\": " << result.p99_ns << ", \"allocations\": " << result.allocations
+                   << ", \"items\": " << result.items << "}";
+        }
+        output << "\n]}\n";
+    }
+
+    std::string filter_;
+    std::size_t samples_ = 50;
+    std::string json_path_;
+    std::vector<Bench::Result> results_;
+    int fail_count = 0;
+};
+
+#define RUN_BENCH(br, func) br.RunBench(func, #func)
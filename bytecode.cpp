@@ -0,0 +1,502 @@
+#include "bytecode.h"
+
+
+using namespace std;
+
+namespace bytecode {
+
+    using runtime::Closure;
+    using runtime::Context;
+    using runtime::ObjectHolder;
+
+    namespace {
+        const runtime::Symbol ADD_METHOD{ "__add__" };
+        const runtime::Symbol INIT_METHOD{ "__init__" };
+        const runtime::Symbol SELF{ "self" };
+
+        class Compiler {
+        public:
+            Chunk Compile(runtime::Executable& tree) {
+                CompileNode(tree);
+                Emit(OpCode::Return);
+                return std::move(chunk_);
+            }
+
+        private:
+            size_t Emit(OpCode op, uint32_t a = 0, uint32_t b = 0) {
+                chunk_.code.push_back({ op, a, b });
+                return chunk_.code.size() - 1;
+            }
+
+            void PatchJump(size_t instruction) {
+                chunk_.code[instruction].a = static_cast<uint32_t>(chunk_.code.size());
+            }
+
+            uint32_t AddConstant(ObjectHolder value) {
+                chunk_.constants.push_back(std::move(value));
+                return static_cast<uint32_t>(chunk_.constants.size() - 1);
+            }
+
+            uint32_t AddName(runtime::Symbol name) {
+                if (const auto it = name_indexes_.find(name); it != name_indexes_.end()) {
+                    return it->second;
+                }
+                chunk_.names.push_back(name);
+                const auto index = static_cast<uint32_t>(chunk_.names.size() - 1);
+                name_indexes_[name] = index;
+                return index;
+            }
+
+            void CompileArgs(const vector<unique_ptr<ast::Statement>>& args) {
+                for (const auto& arg : args) {
+                    CompileNode(*arg);
+                }
+            }
+
+            void CompileBoolResult(size_t first_jump, size_t second_jump, bool jumped_value) {
+                Emit(OpCode::PushConst, AddConstant(ObjectHolder::Own(runtime::Bool{ !jumped_value })));
+                const size_t to_end = Emit(OpCode::Jump);
+                PatchJump(first_jump);
+                PatchJump(second_jump);
+                Emit(OpCode::PushConst, AddConstant(ObjectHolder::Own(runtime::Bool{ jumped_value })));
+                PatchJump(to_end);
+            }
+
+            // Every node leaves exactly one value on the stack
+            void CompileNode(runtime::Executable& node) {
+                if (const auto* num = dynamic_cast<const ast::NumericConst*>(&node)) {
+                    Emit(OpCode::PushConst, AddConstant(ObjectHolder::Own(runtime::Number(num->GetValue()))));
+                }
+                else if (const auto* str = dynamic_cast<const ast::StringConst*>(&node)) {
+                    Emit(OpCode::PushConst, AddConstant(ObjectHolder::Own(runtime::String(str->GetValue()))));
+                }
+                else if (const auto* boolean = dynamic_cast<const ast::BoolConst*>(&node)) {
+                    Emit(OpCode::PushConst, AddConstant(ObjectHolder::Own(runtime::Bool(boolean->GetValue()))));
+                }
+                else if (dynamic_cast<const ast::None*>(&node)) {
+                    Emit(OpCode::PushNone);
+                }
+                else if (const auto* var = dynamic_cast<const ast::VariableValue*>(&node)) {
+                    CompileVariable(*var);
+                }
+                else if (const auto* assign = dynamic_cast<const ast::Assignment*>(&node)) {
+                    CompileNode(*assign->GetValue());
+                    if (assign->GetSlot() != ast::NO_SLOT) {
+                        Emit(OpCode::StoreSlot, static_cast<uint32_t>(assign->GetSlot()));
+                    }
+                    else {
+                        Emit(OpCode::StoreVar, AddName(assign->GetName()));
+                    }
+                }
+                else if (const auto* field_assign = dynamic_cast<const ast::FieldAssignment*>(&node)) {
+                    CompileNode(*field_assign->GetValue());
+                    CompileVariable(field_assign->GetObject());
+                    Emit(OpCode::StoreField, AddName(field_assign->GetFieldName()));
+                }
+                else if (const auto* print = dynamic_cast<const ast::Print*>(&node)) {
+                    if (print->GetArgument()) {
+                        CompileNode(*print->GetArgument());
+                        Emit(OpCode::PrintVariable);
+                    }
+                    for (size_t i = 0; i < print->GetArgs().size(); ++i) {
+                        CompileNode(*print->GetArgs()[i]);
+                        Emit(OpCode::PrintValue, i > 0 ? 1U : 0U);
+                    }
+                    Emit(OpCode::PrintEnd);
+                }
+                else if (const auto* call = dynamic_cast<const ast::MethodCall*>(&node)) {
+                    CompileArgs(call->GetArgs());
+                    CompileNode(*call->GetObject());
+                    chunk_.call_sites.push_back({ call->GetMethod(), {} });
+                    Emit(OpCode::CallMethod, static_cast<uint32_t>(chunk_.call_sites.size() - 1),
+                        static_cast<uint32_t>(call->GetArgs().size()));
+                }
+                else if (const auto* new_instance = dynamic_cast<const ast::NewInstance*>(&node)) {
+                    const runtime::Class& cls = new_instance->GetClass();
+                    chunk_.classes.push_back(&cls);
+                    const auto class_index = static_cast<uint32_t>(chunk_.classes.size() - 1);
+                    if (cls.GetMethod(INIT_METHOD)) {
+                        CompileArgs(new_instance->GetArgs());
+                        Emit(OpCode::NewInstance, class_index, static_cast<uint32_t>(new_instance->GetArgs().size()));
+                    }
+                    else {
+                        Emit(OpCode::NewInstance, class_index, NO_INIT);
+                    }
+                }
+                else if (const auto* stringify = dynamic_cast<const ast::Stringify*>(&node)) {
+                    CompileNode(*stringify->GetArgument());
+                    Emit(OpCode::Stringify);
+                }
+                else if (const auto* not_op = dynamic_cast<const ast::Not*>(&node)) {
+                    CompileNode(*not_op->GetArgument());
+                    Emit(OpCode::Not);
+                }
+                else if (const auto* or_op = dynamic_cast<const ast::Or*>(&node)) {
+                    CompileNode(*or_op->GetLhs());
+                    const size_t lhs_jump = Emit(OpCode::JumpIfTrue);
+                    CompileNode(*or_op->GetRhs());
+                    const size_t rhs_jump = Emit(OpCode::JumpIfTrue);
+                    CompileBoolResult(lhs_jump, rhs_jump, true);
+                }
+                else if (const auto* and_op = dynamic_cast<const ast::And*>(&node)) {
+                    CompileNode(*and_op->GetLhs());
+                    const size_t lhs_jump = Emit(OpCode::JumpIfFalse);
+                    CompileNode(*and_op->GetRhs());
+                    const size_t rhs_jump = Emit(OpCode::JumpIfFalse);
+                    CompileBoolResult(lhs_jump, rhs_jump, false);
+                }
+                else if (const auto* cmp = dynamic_cast<const ast::Comparison*>(&node)) {
+                    CompileNode(*cmp->GetLhs());
+                    CompileNode(*cmp->GetRhs());
+                    Emit(OpCode::Compare, static_cast<uint32_t>(cmp->GetComparator()));
+                }
+                else if (const auto* binary = dynamic_cast<const ast::BinaryOperation*>(&node)) {
+                    CompileArithmetic(*binary);
+                }
+                else if (const auto* compound = dynamic_cast<const ast::Compound*>(&node)) {
+                    for (const auto& stmt : compound->GetStatements()) {
+                        CompileNode(*stmt);
+                        Emit(OpCode::Pop);
+                    }
+                    Emit(OpCode::PushNone);
+                }
+                else if (const auto* body = dynamic_cast<const ast::MethodBody*>(&node)) {
+                    CompileNode(*body->GetBody());
+                }
+                else if (const auto* ret = dynamic_cast<const ast::Return*>(&node)) {
+                    CompileNode(*ret->GetStatement());
+                    Emit(OpCode::Return);
+                    Emit(OpCode::PushNone);
+                }
+                else if (const auto* class_def = dynamic_cast<const ast::ClassDefinition*>(&node)) {
+                    Emit(OpCode::DefineClass, AddConstant(class_def->GetClass()), AddName(class_def->GetName()));
+                }
+                else if (const auto* if_else = dynamic_cast<const ast::IfElse*>(&node)) {
+                    CompileNode(*if_else->GetCondition());
+                    const size_t to_else = Emit(OpCode::JumpIfFalse);
+                    CompileNode(*if_else->GetIfBody());
+                    Emit(OpCode::Pop);
+                    const size_t to_end = Emit(OpCode::Jump);
+                    PatchJump(to_else);
+                    if (if_else->GetElseBody()) {
+                        CompileNode(*if_else->GetElseBody());
+                        Emit(OpCode::Pop);
+                    }
+                    PatchJump(to_end);
+                    Emit(OpCode::PushNone);
+                }
+                else {
+                    chunk_.fallbacks.push_back(&node);
+                    Emit(OpCode::Eval, static_cast<uint32_t>(chunk_.fallbacks.size() - 1));
+                }
+            }
+
+            void CompileVariable(const ast::VariableValue& var) {
+                const auto& ids = var.GetDottedIds();
+                if (var.GetSlot() != ast::NO_SLOT) {
+                    Emit(OpCode::LoadSlot, static_cast<uint32_t>(var.GetSlot()));
+                }
+                else {
+                    Emit(OpCode::LoadVar, AddName(ids.front()));
+                }
+                for (size_t i = 1; i < ids.size(); ++i) {
+                    Emit(OpCode::LoadField, AddName(ids[i]));
+                }
+            }
+
+            void CompileArithmetic(const ast::BinaryOperation& node) {
+                OpCode op;
+                if (dynamic_cast<const ast::Add*>(&node)) {
+                    op = OpCode::Add;
+                }
+                else if (dynamic_cast<const ast::Sub*>(&node)) {
+                    op = OpCode::Sub;
+                }
+                else if (dynamic_cast<const ast::Mult*>(&node)) {
+                    op = OpCode::Mult;
+                }
+                else if (dynamic_cast<const ast::Div*>(&node)) {
+                    op = OpCode::Div;
+                }
+                else {
+                    chunk_.fallbacks.push_back(const_cast<ast::BinaryOperation*>(&node));
+                    Emit(OpCode::Eval, static_cast<uint32_t>(chunk_.fallbacks.size() - 1));
+                    return;
+                }
+                CompileNode(*node.GetLhs());
+                CompileNode(*node.GetRhs());
+                Emit(op);
+            }
+
+            Chunk chunk_;
+            unordered_map<runtime::Symbol, uint32_t> name_indexes_;
+        };
+
+        // Keeps the shared value stack balanced when a frame exits by exception
+        class StackGuard {
+        public:
+            StackGuard(vector<ObjectHolder>& stack) : stack_(stack), base_(stack.size()) {
+            }
+
+            ~StackGuard() {
+                stack_.resize(base_);
+            }
+
+        private:
+            vector<ObjectHolder>& stack_;
+            size_t base_;
+        };
+
+        void PrintObject(const ObjectHolder& object, runtime::OutputSink& output, Context& context) {
+            if (!object) {
+                output.Write("None"sv);
+                return;
+            }
+            object->Write(output, context);
+        }
+
+        int IntegerArithmetic(OpCode op, const ObjectHolder& lhs_obj_h, const ObjectHolder& rhs_obj_h) {
+            if (lhs_obj_h.GetKind() != runtime::ObjectKind::Number || rhs_obj_h.GetKind() != runtime::ObjectKind::Number) {
+                throw std::runtime_error("diffrent tipes or nullptr"s);
+            }
+            const auto* lhs = lhs_obj_h.TryAs<runtime::Number>();
+            const auto* rhs = rhs_obj_h.TryAs<runtime::Number>();
+            switch (op) {
+            case OpCode::Sub:
+                return lhs->GetValue() - rhs->GetValue();
+            case OpCode::Mult:
+                return lhs->GetValue() * rhs->GetValue();
+            default:
+                if (rhs->GetValue() == 0) {
+                    throw std::runtime_error("diffrent tipes or nullptr"s);
+                }
+                return lhs->GetValue() / rhs->GetValue();
+            }
+        }
+    }  // namespace
+
+    Chunk Compile(runtime::Executable& tree) {
+        return Compiler{}.Compile(tree);
+    }
+
+    ObjectHolder VirtualMachine::Pop() {
+        ObjectHolder result = std::move(stack_.back());
+        stack_.pop_back();
+        return result;
+    }
+
+    const Chunk& VirtualMachine::GetMethodChunk(const runtime::Method& method) {
+        if (const auto it = methods_.find(&method); it != methods_.end()) {
+            return it->second;
+        }
+        return methods_.emplace(&method, Compile(*method.body)).first->second;
+    }
+
+    ObjectHolder VirtualMachine::CallMethod(runtime::ClassInstance& instance, runtime::Symbol method,
+        const std::vector<ObjectHolder>& actual_args, Context& context) {
+        const runtime::Method* class_method = instance.GetClass().GetMethod(method);
+        if (!class_method) {
+            throw std::runtime_error("undeclareted method"s);
+        }
+        return CallMethod(instance, *class_method, actual_args, context);
+    }
+
+    ObjectHolder VirtualMachine::CallMethod(runtime::ClassInstance& instance, const runtime::Method& method,
+        const std::vector<ObjectHolder>& actual_args, Context& context) {
+        if (method.formal_params.size() != actual_args.size()) {
+            throw std::runtime_error("undeclareted method"s);
+        }
+        Closure closure;
+        if (method.frame_size) {
+            closure.ResizeSlots(method.frame_size);
+            closure.SetSlot(0, ObjectHolder::Share(instance));
+            for (size_t i = 0; i < actual_args.size(); ++i) {
+                closure.SetSlot(i + 1, actual_args[i]);
+            }
+        }
+        else {
+            closure[SELF] = ObjectHolder::Share(instance);
+            for (size_t i = 0; i < method.formal_params.size(); ++i) {
+                closure[method.formal_params[i]] = actual_args[i];
+            }
+        }
+        return Run(GetMethodChunk(method), closure, context);
+    }
+
+    ObjectHolder VirtualMachine::Run(const Chunk& chunk, Closure& closure, Context& context) {
+        StackGuard guard(stack_);
+        size_t pc = 0;
+        for (;;) {
+            const Instruction& instr = chunk.code[pc++];
+            switch (instr.op) {
+            case OpCode::PushConst:
+                stack_.push_back(chunk.constants[instr.a]);
+                break;
+            case OpCode::PushNone:
+                stack_.emplace_back();
+                break;
+            case OpCode::LoadVar: {
+                const auto it = closure.find(chunk.names[instr.a]);
+                if (it == closure.end()) {
+                    throw std::runtime_error("undefined value");
+                }
+                stack_.push_back(it->second);
+                break;
+            }
+            case OpCode::LoadField: {
+                const auto* instance = stack_.back().TryAs<runtime::ClassInstance>();
+                if (!instance) {
+                    throw std::runtime_error("undefined value");
+                }
+                const ObjectHolder* field = instance->Fields().Find(chunk.names[instr.a]);
+                if (!field) {
+                    throw std::runtime_error("undefined value");
+                }
+                // Copied first: the instance may be owned by the slot being overwritten
+                ObjectHolder value = *field;
+                stack_.back() = std::move(value);
+                break;
+            }
+            case OpCode::StoreVar:
+                closure[chunk.names[instr.a]] = stack_.back();
+                break;
+            case OpCode::LoadSlot:
+                stack_.push_back(closure.GetSlot(instr.a));
+                break;
+            case OpCode::StoreSlot:
+                closure.SetSlot(instr.a, stack_.back());
+                break;
+            case OpCode::StoreField: {
+                ObjectHolder object = Pop();
+                auto* instance = object.TryAs<runtime::ClassInstance>();
+                if (!instance) {
+                    throw std::runtime_error("undefined value");
+                }
+                instance->Fields()[chunk.names[instr.a]] = stack_.back();
+                break;
+            }
+            case OpCode::Pop:
+                stack_.pop_back();
+                break;
+            case OpCode::PrintValue: {
+                runtime::OutputSink& output = context.GetOutput();
+                if (instr.a) {
+                    output.Write(' ');
+                }
+                PrintObject(Pop(), output, context);
+                break;
+            }
+            case OpCode::PrintVariable: {
+                ObjectHolder name = Pop();
+                if (const auto* str = name.TryAs<runtime::String>()) {
+                    PrintObject(closure.at(runtime::Symbol(str->GetValue())), context.GetOutput(), context);
+                }
+                break;
+            }
+            case OpCode::PrintEnd:
+                context.GetOutput().Write('\n');
+                stack_.emplace_back();
+                break;
+            case OpCode::CallMethod: {
+                ObjectHolder object = Pop();
+                auto* instance = object.TryAs<runtime::ClassInstance>();
+                if (!instance) {
+                    throw std::runtime_error("method call on a non-instance value"s);
+                }
+                CallSite& site = chunk.call_sites[instr.a];
+                const runtime::Method* method = site.cache.Lookup(instance->GetClass(), site.method);
+                if (!method) {
+                    throw std::runtime_error("undeclareted method"s);
+                }
+                vector<ObjectHolder> args(make_move_iterator(stack_.end() - instr.b), make_move_iterator(stack_.end()));
+                stack_.resize(stack_.size() - instr.b);
+                stack_.push_back(CallMethod(*instance, *method, args, context));
+                break;
+            }
+            case OpCode::NewInstance: {
+                ObjectHolder object = ObjectHolder::Own(runtime::ClassInstance{ *chunk.classes[instr.a] });
+                if (instr.b != NO_INIT) {
+                    vector<ObjectHolder> args(make_move_iterator(stack_.end() - instr.b), make_move_iterator(stack_.end()));
+                    stack_.resize(stack_.size() - instr.b);
+                    CallMethod(*object.TryAs<runtime::ClassInstance>(), INIT_METHOD, args, context);
+                }
+                stack_.push_back(std::move(object));
+                break;
+            }
+            case OpCode::DefineClass: {
+                const ObjectHolder& cls = chunk.constants[instr.a];
+                closure[chunk.names[instr.b]] = cls;
+                stack_.push_back(cls);
+                break;
+            }
+            case OpCode::Stringify:
+                stack_.push_back(runtime::ToString(Pop(), context));
+                break;
+            case OpCode::Add: {
+                ObjectHolder rhs = Pop();
+                ObjectHolder lhs = Pop();
+                const runtime::ObjectKind kind = lhs.GetKind();
+                if (kind == runtime::ObjectKind::Number && rhs.GetKind() == kind) {
+                    stack_.push_back(ObjectHolder::Own(runtime::Number(
+                        lhs.TryAs<runtime::Number>()->GetValue() + rhs.TryAs<runtime::Number>()->GetValue())));
+                }
+                else if (kind == runtime::ObjectKind::String && rhs.GetKind() == kind) {
+                    stack_.push_back(ObjectHolder::Own(runtime::String::Concat(
+                        *lhs.TryAs<runtime::String>(), *rhs.TryAs<runtime::String>())));
+                }
+                else if (auto* instance = lhs.TryAs<runtime::ClassInstance>(); instance && instance->HasMethod(ADD_METHOD, 1U)) {
+                    stack_.push_back(CallMethod(*instance, ADD_METHOD, { rhs }, context));
+                }
+                else {
+                    throw std::runtime_error("diffrent tipes or nullptr"s);
+                }
+                break;
+            }
+            case OpCode::Sub:
+            case OpCode::Mult:
+            case OpCode::Div: {
+                ObjectHolder rhs = Pop();
+                ObjectHolder lhs = Pop();
+                stack_.push_back(ObjectHolder::Own(runtime::Number(IntegerArithmetic(instr.op, lhs, rhs))));
+                break;
+            }
+            case OpCode::Not:
+                stack_.back() = ObjectHolder::Own(runtime::Bool{ !runtime::IsTrue(stack_.back()) });
+                break;
+            case OpCode::Compare: {
+                ObjectHolder rhs = Pop();
+                ObjectHolder lhs = Pop();
+                stack_.push_back(ObjectHolder::Own(runtime::Bool{ runtime::Compare(static_cast<runtime::Comparator>(instr.a), lhs, rhs, context) }));
+                break;
+            }
+            case OpCode::Jump:
+                pc = instr.a;
+                break;
+            case OpCode::JumpIfFalse:
+                if (!runtime::IsTrue(Pop())) {
+                    pc = instr.a;
+                }
+                break;
+            case OpCode::JumpIfTrue:
+                if (runtime::IsTrue(Pop())) {
+                    pc = instr.a;
+                }
+                break;
+            case OpCode::Return:
+                return Pop();
+            case OpCode::Eval:
+                stack_.push_back(chunk.fallbacks[instr.a]->Execute(closure, context));
+                break;
+            }
+        }
+    }
+
+    ObjectHolder RunProgram(runtime::Executable& program, Closure& closure, Context& context, Engine engine) {
+        if (engine == Engine::TreeWalker) {
+            return program.Execute(closure, context);
+        }
+        VirtualMachine vm;
+        return vm.Run(Compile(program), closure, context);
+    }
+
+}  // namespace bytecode
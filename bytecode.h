@@ -0,0 +1,96 @@
+#pragma once
+
+#include "runtime.h"
+#include "statement.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bytecode {
+
+    enum class OpCode : std::uint8_t {
+        PushConst,      // a: constant index
+        PushNone,
+        LoadVar,        // a: name index
+        LoadField,      // a: name index; pops instance
+        StoreVar,       // a: name index; leaves the value on the stack
+        LoadSlot,       // a: frame slot
+        StoreSlot,      // a: frame slot; leaves the value on the stack
+        StoreField,     // a: name index; pops instance and value, pushes value
+        Pop,
+        PrintValue,     // a: 1 if a separating space goes first; pops value
+        PrintVariable,  // pops variable name
+        PrintEnd,       // prints newline, pushes None
+        CallMethod,     // a: call site index, b: argument count; pops arguments and instance
+        NewInstance,    // a: class index, b: argument count or NO_INIT
+        DefineClass,    // a: constant index, b: name index
+        Stringify,
+        Add,
+        Sub,
+        Mult,
+        Div,
+        Not,
+        Compare,        // a: runtime::Comparator
+        Jump,           // a: target
+        JumpIfFalse,    // a: target; pops condition
+        JumpIfTrue,     // a: target; pops condition
+        Return,         // pops result
+        Eval,           // a: fallback index; tree-walks a node unknown to the compiler
+    };
+
+    struct Instruction {
+        OpCode op;
+        std::uint32_t a = 0;
+        std::uint32_t b = 0;
+    };
+
+    inline constexpr std::uint32_t NO_INIT = 0xFFFFFFFFU;
+
+    struct CallSite {
+        runtime::Symbol method;
+        runtime::MethodCache cache;
+    };
+
+    struct Chunk {
+        std::vector<Instruction> code;
+        std::vector<runtime::ObjectHolder> constants;
+        std::vector<runtime::Symbol> names;
+        std::vector<const runtime::Class*> classes;
+        std::vector<runtime::Executable*> fallbacks;
+        // Inline caches are updated while the otherwise immutable chunk runs
+        mutable std::vector<CallSite> call_sites;
+    };
+
+    // Translates an ast::* tree into linear bytecode. The tree must outlive the chunk:
+    // classes and nodes the compiler does not know are referenced, not copied
+    Chunk Compile(runtime::Executable& tree);
+
+    class VirtualMachine {
+    public:
+        runtime::ObjectHolder Run(const Chunk& chunk, runtime::Closure& closure, runtime::Context& context);
+
+        runtime::ObjectHolder CallMethod(runtime::ClassInstance& instance, runtime::Symbol method,
+            const std::vector<runtime::ObjectHolder>& actual_args, runtime::Context& context);
+
+        runtime::ObjectHolder CallMethod(runtime::ClassInstance& instance, const runtime::Method& method,
+            const std::vector<runtime::ObjectHolder>& actual_args, runtime::Context& context);
+
+    private:
+        runtime::ObjectHolder Pop();
+        const Chunk& GetMethodChunk(const runtime::Method& method);
+
+        std::unordered_map<const runtime::Method*, Chunk> methods_;
+        std::vector<runtime::ObjectHolder> stack_;
+    };
+
+    enum class Engine {
+        TreeWalker,
+        Bytecode,
+    };
+
+    runtime::ObjectHolder RunProgram(runtime::Executable& program, runtime::Closure& closure,
+        runtime::Context& context, Engine engine);
+
+}  // namespace bytecode
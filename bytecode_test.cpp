@@ -0,0 +1,170 @@
+#include "bytecode.h"
+#include "lexer.h"
+#include "parse.h"
+
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace bytecode {
+
+    namespace {
+
+        string RunWithEngine(const string& program, Engine engine) {
+            istringstream is(program);
+            parse::Lexer lexer(is);
+            auto tree = ParseProgram(lexer);
+
+            runtime::DummyContext context;
+            runtime::Closure closure;
+            RunProgram(*tree, closure, context, engine);
+            return context.output.str();
+        }
+
+        void AssertSameOutput(const string& program, const string& expected) {
+            ASSERT_EQUAL(RunWithEngine(program, Engine::TreeWalker), expected);
+            ASSERT_EQUAL(RunWithEngine(program, Engine::Bytecode), expected);
+        }
+
+        void TestArithmeticAndPrint() {
+            AssertSameOutput(R"(
+x = 4
+y = 5
+z = "hello, "
+n = "world"
+print x + y, z + n, x * y - 2, y / 2, -x
+print
+print None, True, False
+)"s, "9 hello, world 18 2 -4\n\nNone True False\n"s);
+        }
+
+        void TestLogicalOperations() {
+            AssertSameOutput(R"(
+a = 1
+b = 2
+c = 3
+print a + b > c and a + c > b and b + c > a
+print a < b or c < b, not a, a == 1, b != 2, a <= 1, c >= 4
+print str(a) + str(None) + str(a < b)
+)"s, "False\nTrue False True False True False\n1NoneTrue\n"s);
+        }
+
+        void TestReturnFromIf() {
+            AssertSameOutput(R"(
+class Abs:
+  def calc(n):
+    if n > 0:
+      return n
+    else:
+      return -n
+    print "unreachable"
+
+x = Abs()
+print x.calc(2), x.calc(-3)
+)"s, "2 3\n"s);
+        }
+
+        void TestRecursion() {
+            AssertSameOutput(R"(
+class GCD:
+  def __init__():
+    self.call_count = 0
+
+  def calc(a, b):
+    self.call_count = self.call_count + 1
+    if a < b:
+      return self.calc(b, a)
+    if b == 0:
+      return a
+    return self.calc(a - b, b)
+
+x = GCD()
+print x.calc(510510, 18629977)
+print x.calc(22, 17)
+print x.call_count
+)"s, "17\n1\n115\n"s);
+        }
+
+        void TestClassicalPolymorphism() {
+            AssertSameOutput(R"(
+class Shape:
+  def __str__():
+    return "Shape"
+
+  def area():
+    return 0
+
+class Rect(Shape):
+  def __init__(w, h):
+    self.w = w
+    self.h = h
+
+  def __str__():
+    return "Rect(" + str(self.w) + 'x' + str(self.h) + ')'
+
+  def area():
+    return self.w * self.h
+
+class Circle(Shape):
+  def __init__(r):
+    self.r = r
+
+  def __str__():
+    return 'Circle(' + str(self.r) + ')'
+
+class Sum:
+  def __init__(value):
+    self.value = value
+
+  def __add__(rhs):
+    return self.value + rhs.value
+
+r = Rect(10, 20)
+c = Circle(52)
+print r, c, Shape(), r.area(), c.area(), Sum(1) + Sum(2)
+)"s, "Rect(10x20) Circle(52) Shape 200 0 3\n"s);
+        }
+
+        void TestRuntimeErrors() {
+            const string undefined_variable = "print x\n"s;
+            ASSERT_THROWS(RunWithEngine(undefined_variable, Engine::Bytecode), runtime_error);
+
+            const string division_by_zero = "x = 1 / 0\n"s;
+            ASSERT_THROWS(RunWithEngine(division_by_zero, Engine::Bytecode), runtime_error);
+
+            const string wrong_arity = R"(
+class A:
+  def f(x):
+    return x
+
+A().f()
+)"s;
+            ASSERT_THROWS(RunWithEngine(wrong_arity, Engine::Bytecode), runtime_error);
+        }
+
+        void TestCompiledGlobals() {
+            istringstream is("x = 57\nclass A:\n  def f():\n    return 1\n"s);
+            parse::Lexer lexer(is);
+            auto tree = ParseProgram(lexer);
+
+            runtime::DummyContext context;
+            runtime::Closure closure;
+            RunProgram(*tree, closure, context, Engine::Bytecode);
+
+            ASSERT_EQUAL(closure.at("x").TryAs<runtime::Number>()->GetValue(), 57);
+            ASSERT(closure.at("A").TryAs<runtime::Class>() != nullptr);
+        }
+
+    }  // namespace
+
+    void RunBytecodeTests(TestRunner& tr) {
+        RUN_TEST(tr, bytecode::TestArithmeticAndPrint);
+        RUN_TEST(tr, bytecode::TestLogicalOperations);
+        RUN_TEST(tr, bytecode::TestReturnFromIf);
+        RUN_TEST(tr, bytecode::TestRecursion);
+        RUN_TEST(tr, bytecode::TestClassicalPolymorphism);
+        RUN_TEST(tr, bytecode::TestRuntimeErrors);
+        RUN_TEST(tr, bytecode::TestCompiledGlobals);
+    }
+
+}  // namespace bytecode
@@ -0,0 +1,175 @@
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "workload.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <streambuf>
+#include <string>
+
+using namespace std;
+using namespace std::literals;
+
+// Lexing, parsing and running generated programs of 1 KiB to 100 MiB (workload.h) one phase
+// at a time. For every phase: the best time over a few runs, source bytes per second and the
+// peak resident set while it ran, with the growth over the resident set it started with. Peak
+// RSS is per phase on Linux, where the high-water mark can be reset; elsewhere it is left out.
+// Build with -O2 and run without arguments, or with the largest size in bytes to stop at.
+
+namespace {
+
+    constexpr size_t SIZES[] = { 1 << 10, 10 << 10, 100 << 10, 1 << 20, 10 << 20, 100 << 20 };
+    // Small inputs are run until about this much source has gone through a phase
+    constexpr size_t BYTES_PER_PHASE = 64 << 20;
+    constexpr int MAX_RUNS = 200;
+
+    // Output that is thrown away without a call per character
+    class DiscardBuffer : public streambuf {
+    public:
+        DiscardBuffer() {
+            setp(buffer_, buffer_ + sizeof(buffer_));
+        }
+
+    protected:
+        int overflow(int c) override {
+            setp(buffer_, buffer_ + sizeof(buffer_));
+            return c;
+        }
+
+    private:
+        char buffer_[4096];
+    };
+
+    // Resident set in KiB, 0 where it is not known
+    struct Rss {
+        size_t current = 0;
+        size_t peak = 0;
+    };
+
+#ifdef __linux__
+    // Makes the peak resident set restart from the current one
+    void ResetPeakRss() {
+        ofstream("/proc/self/clear_refs"s) << '5';
+    }
+
+    Rss ReadRss() {
+        Rss rss;
+        ifstream status("/proc/self/status"s);
+        string line;
+        while (getline(status, line)) {
+            if (line.rfind("VmRSS:"sv, 0) == 0) {
+                rss.current = stoull(line.substr(6));
+            }
+            else if (line.rfind("VmHWM:"sv, 0) == 0) {
+                rss.peak = stoull(line.substr(6));
+            }
+        }
+        return rss;
+    }
+#else
+    void ResetPeakRss() {
+    }
+
+    Rss ReadRss() {
+        return {};
+    }
+#endif
+
+    struct PhaseResult {
+        double best_ms = 0;
+        Rss start;
+        Rss end;
+    };
+
+    // The first run is the one whose memory is measured. Prepare runs before each run, untimed
+    template <typename Action, typename Prepare>
+    PhaseResult RunPhase(int runs, Action action, Prepare prepare) {
+        PhaseResult result;
+        ResetPeakRss();
+        result.start = ReadRss();
+        for (int run = 0; run < runs; ++run) {
+            prepare();
+            const auto start = chrono::steady_clock::now();
+            action();
+            const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+            if (run == 0) {
+                result.end = ReadRss();
+            }
+            if (run == 0 || elapsed.count() < result.best_ms) {
+                result.best_ms = elapsed.count();
+            }
+        }
+        return result;
+    }
+
+    template <typename Action>
+    PhaseResult RunPhase(int runs, Action action) {
+        return RunPhase(runs, action, []() {
+        });
+    }
+
+    void Report(string_view phase, size_t source_size, const PhaseResult& result) {
+        const double mib = 1024.0 * 1024.0;
+        cout << setw(10) << phase << fixed << setprecision(3) << setw(14) << result.best_ms
+             << setprecision(1) << setw(12) << static_cast<double>(source_size) / mib / result.best_ms * 1e3;
+        if (result.end.peak != 0) {
+            cout << setw(12) << static_cast<double>(result.end.peak) / 1024.0 << setw(12)
+                 << static_cast<double>(result.end.peak - min(result.start.current, result.end.peak)) / 1024.0;
+        }
+        cout << defaultfloat << endl;
+    }
+
+    void RunSize(size_t target_size) {
+        workload::ProgramShape shape;
+        shape.target_size = target_size;
+        string source = workload::GenerateProgram(shape);
+        const int runs = static_cast<int>(clamp<size_t>(BYTES_PER_PHASE / source.size(), 1, MAX_RUNS));
+
+        cout << endl << source.size() << " bytes of source, best of "sv << runs << endl;
+        cout << setw(10) << "phase"sv << setw(14) << "ms"sv << setw(12) << "MiB/s"sv << setw(12)
+             << "peak MiB"sv << setw(12) << "+MiB"sv << endl;
+
+        size_t tokens = 0;
+        Report("lex"sv, source.size(), RunPhase(runs, [&]() {
+            parse::Lexer lexer(source);
+            tokens = 0;
+            while (!lexer.NextToken().Is<parse::token_type::Eof>()) {
+                ++tokens;
+            }
+        }));
+
+        unique_ptr<runtime::Executable> program;
+        Report("parse"sv, source.size(), RunPhase(runs, [&]() {
+            parse::Lexer lexer(source);
+            program = ParseProgram(lexer);
+        }, [&]() {
+            // Freeing the tree of the last run is not part of parsing
+            program.reset();
+        }));
+
+        DiscardBuffer buffer;
+        ostream output(&buffer);
+        Report("execute"sv, source.size(), RunPhase(runs, [&]() {
+            runtime::Closure globals;
+            runtime::SimpleContext context(output);
+            program->Execute(globals, context);
+        }));
+        cout << tokens << " tokens"sv << endl;
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t max_size = argc > 1 ? stoull(argv[1]) : SIZES[size(SIZES) - 1];
+    for (const size_t target_size : SIZES) {
+        if (target_size <= max_size) {
+            RunSize(target_size);
+        }
+    }
+}
@@ -0,0 +1,359 @@
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include "bench_runner_p.h"
+
+#include <algorithm>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::literals;
+
+// First suite on the RUN_BENCH harness: lexing and parsing a mid-sized script, method calls,
+// arithmetic nodes, comparisons and printing. Build with -O2; see bench_runner_p.h for the
+// arguments it takes.
+
+namespace {
+
+    constexpr int SCRIPT_CLASSES = 40;
+
+    // About 12 KB: classes with a constructor, arithmetic, conditions and string building
+    string MakeScript() {
+        string script;
+        for (int i = 0; i < SCRIPT_CLASSES; ++i) {
+            const string n = to_string(i);
+            script += "class Item"s + n + ":\n"s;
+            script += "  def __init__(value, name):\n"s;
+            script += "    self.value = value * "s + n + " + 17\n"s;
+            script += "    self.name = 'item "s + n + "'\n"s;
+            script += "  def scaled(factor):\n"s;
+            script += "    result = self.value * factor\n"s;
+            script += "    if result >= 100 and not result == 200:\n"s;
+            script += "      return result - 100\n"s;
+            script += "    return result\n"s;
+            script += "  def __str__():\n"s;
+            script += "    return self.name + ': ' + str(self.scaled(2))\n\n"s;
+        }
+        script += "x = Item0(3, \"x\")\nprint x\n"s;
+        return script;
+    }
+
+    unique_ptr<runtime::Executable> Parse(string_view script) {
+        parse::Lexer lexer(script);
+        return ParseProgram(lexer);
+    }
+
+    // Output that is thrown away without a call per character
+    class DiscardBuffer : public streambuf {
+    public:
+        DiscardBuffer() {
+            setp(buffer_, buffer_ + sizeof(buffer_));
+        }
+
+    protected:
+        int overflow(int c) override {
+            setp(buffer_, buffer_ + sizeof(buffer_));
+            return c;
+        }
+
+    private:
+        char buffer_[4096];
+    };
+
+    // A program's classes and globals, kept alive for benchmarks that call into them
+    struct Script {
+        explicit Script(string_view text)
+            : program(Parse(text)) {
+            program->Execute(globals, context);
+        }
+
+        runtime::ClassInstance& Instance(runtime::Symbol name) {
+            return *globals.at(name).TryAs<runtime::ClassInstance>();
+        }
+
+        unique_ptr<runtime::Executable> program;
+        runtime::Closure globals;
+        runtime::DummyContext context;
+    };
+
+    const string_view METHODS_SCRIPT = R"(
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  def shifted(dx):
+    return self.x + dx
+
+  def __eq__(other):
+    return self.x == other.x and self.y == other.y
+
+  def __lt__(other):
+    return self.x < other.x
+
+  def __str__():
+    return 'Point(' + str(self.x) + ', ' + str(self.y) + ')'
+
+p = Point(1, 2)
+q = Point(1, 3)
+)"sv;
+
+    // str() of a number at every level of a recursion
+    const string_view RECURSIVE_STR_SCRIPT = R"(
+class Digits:
+  def run(n):
+    if n > 0:
+      text = str(n * 7919)
+      return self.run(n - 1)
+    return 0
+
+d = Digits()
+)"sv;
+
+    constexpr int RECURSIVE_STR_DEPTH = 100;
+
+    constexpr int APPENDS_PER_CALL = 100;
+    constexpr int APPEND_CALLS = 1000;
+
+    constexpr int COPIED_HOLDERS = 64;
+
+    constexpr int LONG_LINE_TERMS = 40'000;
+
+    // 100k appends of 100 bytes, through a field, then one print of the 10 MB result
+    string MakeAppendScript() {
+        string script = R"(
+class Builder:
+  def __init__():
+    self.text = ''
+
+  def add(n):
+    if n > 0:
+      self.text = self.text + ')"s + string(99, '.') + R"(\n'
+      self.add(n - 1)
+
+b = Builder()
+)"s;
+        for (int i = 0; i < APPEND_CALLS; ++i) {
+            script += "b.add("s + to_string(APPENDS_PER_CALL) + ")\n"s;
+        }
+        return script + "print b.text\n"s;
+    }
+
+    void BenchLexerNextToken(Bench& bench) {
+        const string script = MakeScript();
+        size_t tokens = 0;
+        parse::Lexer counter(script);
+        while (!counter.CurrentToken().Is<parse::token_type::Eof>()) {
+            counter.NextToken();
+            ++tokens;
+        }
+        bench.SetItemsPerCall(static_cast<double>(tokens));
+        bench.Run([&script] {
+            parse::Lexer lexer(script);
+            size_t count = 0;
+            while (!lexer.NextToken().Is<parse::token_type::Eof>()) {
+                ++count;
+            }
+            return count;
+        });
+    }
+
+    void BenchParseProgram(Bench& bench) {
+        const string script = MakeScript();
+        bench.SetItemsPerCall(static_cast<double>(script.size()));
+        bench.Run([&script] {
+            return Parse(script);
+        });
+    }
+
+    // One 160 KB line, x = 1 + 1 + ...: the span of every node has to be found without going
+    // back over the line
+    void BenchParseLongLine(Bench& bench) {
+        string script = "x = 1"s;
+        for (int i = 1; i < LONG_LINE_TERMS; ++i) {
+            script += " + 1"sv;
+        }
+        script += '\n';
+        bench.SetItemsPerCall(static_cast<double>(script.size()));
+        bench.Run([&script] {
+            return Parse(script);
+        });
+    }
+
+    void BenchClassInstanceCall(Bench& bench) {
+        Script script(METHODS_SCRIPT);
+        runtime::ClassInstance& point = script.Instance("p");
+        const runtime::Symbol shifted = "shifted";
+        const vector<runtime::ObjectHolder> args{ runtime::ObjectHolder::Own(runtime::Number{ 5 }) };
+        bench.Run([&] {
+            return point.Call(shifted, args, script.context);
+        });
+    }
+
+    // Taking and dropping references to heap objects, as passing arguments and reading variables do
+    void BenchCopyHolders(Bench& bench) {
+        vector<runtime::ObjectHolder> holders;
+        for (int i = 0; i < COPIED_HOLDERS; ++i) {
+            holders.push_back(runtime::ObjectHolder::Own(runtime::String(to_string(i))));
+        }
+        vector<runtime::ObjectHolder> copies(holders.size());
+        bench.SetItemsPerCall(COPIED_HOLDERS);
+        bench.Run([&] {
+            copy(holders.begin(), holders.end(), copies.begin());
+            fill(copies.begin(), copies.end(), runtime::ObjectHolder());
+            return copies.size();
+        });
+    }
+
+    void BenchArithmeticNodes(Bench& bench) {
+        // (x + 3) * (x - 1) / 2
+        ast::Div expression(
+            make_unique<ast::Mult>(
+                make_unique<ast::Add>(make_unique<ast::VariableValue>("x"), make_unique<ast::NumericConst>(3)),
+                make_unique<ast::Sub>(make_unique<ast::VariableValue>("x"), make_unique<ast::NumericConst>(1))),
+            make_unique<ast::NumericConst>(2));
+        runtime::Closure closure;
+        closure["x"] = runtime::ObjectHolder::Own(runtime::Number{ 7 });
+        runtime::DummyContext context;
+        bench.Run([&] {
+            return expression.Execute(closure, context);
+        });
+    }
+
+    void BenchStringConcatenation(Bench& bench) {
+        ast::Add expression(make_unique<ast::StringConst>("left, "s), make_unique<ast::StringConst>("right"s));
+        runtime::Closure closure;
+        runtime::DummyContext context;
+        bench.Run([&] {
+            return expression.Execute(closure, context);
+        });
+    }
+
+    void BenchEqualNumbers(Bench& bench) {
+        const auto lhs = runtime::ObjectHolder::Own(runtime::Number{ 3 });
+        const auto rhs = runtime::ObjectHolder::Own(runtime::Number{ 4 });
+        runtime::DummyContext context;
+        bench.Run([&] {
+            return runtime::Equal(lhs, rhs, context);
+        });
+    }
+
+    void BenchLessStrings(Bench& bench) {
+        const auto lhs = runtime::ObjectHolder::Own(runtime::String{ "interpreter"s });
+        const auto rhs = runtime::ObjectHolder::Own(runtime::String{ "interpreted"s });
+        runtime::DummyContext context;
+        bench.Run([&] {
+            return runtime::Less(lhs, rhs, context);
+        });
+    }
+
+    void BenchEqualInstances(Bench& bench) {
+        Script script(METHODS_SCRIPT);
+        const auto lhs = runtime::ObjectHolder::Share(script.Instance("p"));
+        const auto rhs = runtime::ObjectHolder::Share(script.Instance("q"));
+        bench.Run([&] {
+            return runtime::Equal(lhs, rhs, script.context);
+        });
+    }
+
+    void BenchLessInstances(Bench& bench) {
+        Script script(METHODS_SCRIPT);
+        const auto lhs = runtime::ObjectHolder::Share(script.Instance("p"));
+        const auto rhs = runtime::ObjectHolder::Share(script.Instance("q"));
+        bench.Run([&] {
+            return runtime::Less(lhs, rhs, script.context);
+        });
+    }
+
+    void BenchPrint(Bench& bench) {
+        Script script(METHODS_SCRIPT);
+        vector<unique_ptr<ast::Statement>> args;
+        args.push_back(make_unique<ast::NumericConst>(12345));
+        args.push_back(make_unique<ast::StringConst>("text"s));
+        args.push_back(make_unique<ast::BoolConst>(runtime::Bool{ true }));
+        args.push_back(make_unique<ast::None>());
+        args.push_back(make_unique<ast::VariableValue>("p"));
+        ast::Print print(std::move(args));
+        DiscardBuffer buffer;
+        ostream output(&buffer);
+        runtime::SimpleContext context(output);
+        bench.Run([&] {
+            return print.Execute(script.globals, context);
+        });
+    }
+
+    void BenchPrintValues(Bench& bench) {
+        vector<unique_ptr<ast::Statement>> args;
+        args.push_back(make_unique<ast::NumericConst>(-12345));
+        args.push_back(make_unique<ast::StringConst>("text"s));
+        args.push_back(make_unique<ast::NumericConst>(7));
+        args.push_back(make_unique<ast::BoolConst>(runtime::Bool{ false }));
+        ast::Print print(std::move(args));
+        runtime::Closure closure;
+        DiscardBuffer buffer;
+        ostream output(&buffer);
+        runtime::SimpleContext context(output);
+        bench.Run([&] {
+            return print.Execute(closure, context);
+        });
+    }
+
+    void BenchRecursiveStrOfNumbers(Bench& bench) {
+        Script script(RECURSIVE_STR_SCRIPT);
+        runtime::ClassInstance& digits = script.Instance("d");
+        const runtime::Symbol run = "run";
+        const vector<runtime::ObjectHolder> args{ runtime::ObjectHolder::Own(runtime::Number{ RECURSIVE_STR_DEPTH }) };
+        bench.SetItemsPerCall(RECURSIVE_STR_DEPTH);
+        bench.Run([&] {
+            return digits.Call(run, args, script.context);
+        });
+    }
+
+    void BenchBuildStringByAppends(Bench& bench) {
+        const unique_ptr<runtime::Executable> program = Parse(MakeAppendScript());
+        DiscardBuffer buffer;
+        ostream output(&buffer);
+        bench.SetItemsPerCall(APPENDS_PER_CALL * APPEND_CALLS);
+        bench.Run([&] {
+            runtime::Closure globals;
+            runtime::SimpleContext context(output);
+            return program->Execute(globals, context);
+        });
+    }
+
+    void BenchStringify(Bench& bench) {
+        Script script(METHODS_SCRIPT);
+        ast::Stringify number(make_unique<ast::NumericConst>(-1234567));
+        ast::Stringify instance(make_unique<ast::VariableValue>("p"));
+        bench.Run([&] {
+            number.Execute(script.globals, script.context);
+            return instance.Execute(script.globals, script.context);
+        });
+    }
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    BenchRunner br(argc, argv);
+    RUN_BENCH(br, BenchLexerNextToken);
+    RUN_BENCH(br, BenchParseProgram);
+    RUN_BENCH(br, BenchParseLongLine);
+    RUN_BENCH(br, BenchClassInstanceCall);
+    RUN_BENCH(br, BenchCopyHolders);
+    RUN_BENCH(br, BenchArithmeticNodes);
+    RUN_BENCH(br, BenchStringConcatenation);
+    RUN_BENCH(br, BenchEqualNumbers);
+    RUN_BENCH(br, BenchLessStrings);
+    RUN_BENCH(br, BenchEqualInstances);
+    RUN_BENCH(br, BenchLessInstances);
+    RUN_BENCH(br, BenchPrint);
+    RUN_BENCH(br, BenchPrintValues);
+    RUN_BENCH(br, BenchStringify);
+    RUN_BENCH(br, BenchRecursiveStrOfNumbers);
+    RUN_BENCH(br, BenchBuildStringByAppends);
+}
@@ -1,276 +1,383 @@
-#include "lexer.h"
-
-#include <algorithm>
-#include <charconv>
-#include <unordered_map>
-
-using namespace std;
-
-namespace parse {
-
-    bool operator==(const Token& lhs, const Token& rhs) {
-        using namespace token_type;
-
-        if (lhs.index() != rhs.index()) {
-            return false;
-        }
-        if (lhs.Is<Char>()) {
-            return lhs.As<Char>().value == rhs.As<Char>().value;
-        }
-        if (lhs.Is<Number>()) {
-            return lhs.As<Number>().value == rhs.As<Number>().value;
-        }
-        if (lhs.Is<String>()) {
-            return lhs.As<String>().value == rhs.As<String>().value;
-        }
-        if (lhs.Is<Id>()) {
-            return lhs.As<Id>().value == rhs.As<Id>().value;
-        }
-        return true;
-    }
-
-    bool operator!=(const Token& lhs, const Token& rhs) {
-        return !(lhs == rhs);
-    }
-
-    std::ostream& operator<<(std::ostream& os, const Token& rhs) {
-        using namespace token_type;
-
-#define VALUED_OUTPUT(type) \
-    if (auto p = rhs.TryAs<type>()) return os << #type << '{' << p->value << '}';
-
-        VALUED_OUTPUT(Number);
-        VALUED_OUTPUT(Id);
-        VALUED_OUTPUT(String);
-        VALUED_OUTPUT(Char);
-
-#undef VALUED_OUTPUT
-
-#define UNVALUED_OUTPUT(type) \
-    if (rhs.Is<type>()) return os << #type;
-
-        UNVALUED_OUTPUT(Class);
-        UNVALUED_OUTPUT(Return);
-        UNVALUED_OUTPUT(If);
-        UNVALUED_OUTPUT(Else);
-        UNVALUED_OUTPUT(Def);
-        UNVALUED_OUTPUT(Newline);
-        UNVALUED_OUTPUT(Print);
-        UNVALUED_OUTPUT(Indent);
-        UNVALUED_OUTPUT(Dedent);
-        UNVALUED_OUTPUT(And);
-        UNVALUED_OUTPUT(Or);
-        UNVALUED_OUTPUT(Not);
-        UNVALUED_OUTPUT(Eq);
-        UNVALUED_OUTPUT(NotEq);
-        UNVALUED_OUTPUT(LessOrEq);
-        UNVALUED_OUTPUT(GreaterOrEq);
-        UNVALUED_OUTPUT(None);
-        UNVALUED_OUTPUT(True);
-        UNVALUED_OUTPUT(False);
-        UNVALUED_OUTPUT(Eof);
-
-#undef UNVALUED_OUTPUT
-
-        return os << "Unknown token :("sv;
-    }
-
-    Lexer::Lexer(std::istream& input) : input_(input) {
-        ScipToBegin();
-        current_token_ = NextToken();
-    }
-
-    const Token& Lexer::CurrentToken() const {
-        return current_token_;
-    }
-
-    Token Lexer::NextToken() {
-        if (new_line_) {
-            static size_t space_count = 0;
-            CalcSpaceCount(space_count);
-            size_t dent_count = space_count / 2;
-
-            if (Token* token = GetIndentOrDedentToken(dent_count); token) {
-                return *token;
-            }
-            space_count = 0;
-        }
-
-        char peek = input_.get();
-
-        while (peek == ' ') {
-            peek = input_.get();
-        }
-        if (std::isdigit(peek)) {
-            return current_token_ =  GetDigitToken(peek);
-        }
-        else if (std::isalpha(peek) || peek == '_') {
-            return current_token_ = GetIdToken(peek);
-        }
-        else if (peek == '\"' || peek == '\'') {
-            return current_token_ = GetStringToken(peek);
-        }
-        else if (peek == '#') {
-            ScipComments();
-            return current_token_ = NextToken();
-        }
-        else if (peek == '\n') {
-            return current_token_ = GetNewLineToken();
-        }
-        else if (input_.eof()) {
-            return current_token_ = GetEofToken();
-        }
-        else {
-            return current_token_ = GetCharToken(peek);
-        };
-    }
-
-    Token Lexer::GetDigitToken(char peek) {
-        empty_line_ = false;
-        int number = atoi(&peek);
-        while (std::isdigit(input_.peek())) {
-            peek = input_.get();
-            number = number * 10 + atoi(&peek);
-        }
-        return token_type::Number{ number };;
-    }
-
-    Token Lexer::GetIdToken(char peek) {
-        empty_line_ = false;
-        std::string id;
-        id.push_back(peek);
-        while (std::isalpha(input_.peek()) || std::isdigit(input_.peek()) || input_.peek() == '_') {
-            id.push_back(input_.get());
-        }
-        if (key_words_.find(id) != key_words_.cend()) {
-            return key_words_.at(id);
-        }
-        else {
-            return token_type::Id{ id };
-        }
-    }
-
-    Token Lexer::GetStringToken(char peek) {
-        empty_line_ = false;
-        if (peek == '\"') {
-            return GetStringTokenChoseQuote(peek, '\"');
-        }
-        else {
-            return GetStringTokenChoseQuote(peek, '\'');
-        }
-    }
-
-    Token Lexer::GetStringTokenChoseQuote(char peek, char quote) {
-        const std::unordered_map<char, char> escape_sequences{ {'n','\n'}, {'t','\t'}, {'\'','\''}, {'\"','\"'} };
-        string str;
-        bool escaped = false;
-        peek = input_.get();
-        for (; !input_.eof() && !(!escaped && peek == quote); peek = input_.get()) {
-            if (!escaped) {
-                if (peek == '\\') {
-                    escaped = true;
-                }
-                else {
-                    str.push_back(peek);
-                }
-            }
-            else {
-                if (const auto it = escape_sequences.find(peek); it != escape_sequences.end()) {
-                    str.push_back(it->second);
-                }
-                escaped = false;
-            }
-        }
-        return token_type::String{ str };
-    }
-
-    Token Lexer::GetCharToken(char peek) {
-        empty_line_ = false;
-        string str;
-        str.push_back(peek);
-        str.push_back(input_.peek());
-        if (key_words_.find(str) != key_words_.cend()) {
-            input_.get();
-            return key_words_.at(str);
-        }
-        else {
-            return token_type::Char{ peek };
-        }
-    }
-
-    Token Lexer::GetNewLineToken() {
-        new_line_ = true;
-        if (!empty_line_) {
-            empty_line_ = true;
-            return token_type::Newline{};
-        }
-        return NextToken();
-    }
-
-    Token Lexer::GetEofToken() {
-        if (!empty_line_) {
-            empty_line_ = true;
-            return token_type::Newline{};
-        }
-        return token_type::Eof{};
-    }
-
-    Token* Lexer::GetIndentOrDedentToken(size_t dent_count) {
-        if (dent_count > dent_count_) {
-            size_t indent_count = dent_count - dent_count_;
-            if (indent_count > 0) {
-                ++dent_count_;
-                current_token_ = token_type::Indent{};
-                return &current_token_;
-            }
-        }
-        else if (dent_count < dent_count_) {
-            size_t dedent_count = dent_count_ - dent_count;
-            if (dedent_count > 0) {
-                --dent_count_;
-                current_token_ = token_type::Dedent{};
-                return &current_token_;
-            }
-        }
-        new_line_ = false;
-        return nullptr;
-    }
-
-    void Lexer::ScipToBegin() {
-        while (input_.peek() == ' ' || input_.peek() == '\n' || input_.peek() == '#') {
-            if (input_.peek() == '#') {
-                while (input_.peek() != '\n' && !input_.eof()) {
-                    input_.get();
-                }
-            }
-            while (input_.peek() == ' ' || input_.peek() == '\n') {
-                input_.get();
-            }
-        }
-    }
-
-    void Lexer::CalcSpaceCount(size_t& space_count) {
-        bool new_line_flag;
-        do {
-            while (input_.peek() == ' ') {
-                ++space_count;
-                input_.get();
-            }
-            new_line_flag = false;
-            if (input_.peek() == '\n') {
-                input_.get();
-                space_count = 0;
-                new_line_flag = true;
-            }
-        } while (new_line_flag);
-    }
-
-    void Lexer::ScipComments() {
-        while (input_.peek() != '\n' && !input_.eof()) {
-            input_.get();
-        }
-    }
-
-}  // namespace parse
-
-
+#include "lexer.h"
+#include "scan.h"
+
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <type_traits>
+
+using namespace std;
+
+namespace parse {
+
+    // Tokens are copied freely by the lexer and the parser
+    static_assert(std::is_trivially_copyable_v<Token>);
+
+    bool operator==(const Token& lhs, const Token& rhs) {
+        using namespace token_type;
+
+        if (lhs.index() != rhs.index()) {
+            return false;
+        }
+        if (lhs.Is<Char>()) {
+            return lhs.As<Char>().value == rhs.As<Char>().value;
+        }
+        if (lhs.Is<Number>()) {
+            return lhs.As<Number>().value == rhs.As<Number>().value;
+        }
+        if (lhs.Is<String>()) {
+            return lhs.As<String>().value == rhs.As<String>().value;
+        }
+        if (lhs.Is<Id>()) {
+            return lhs.As<Id>().value == rhs.As<Id>().value;
+        }
+        return true;
+    }
+
+    bool operator!=(const Token& lhs, const Token& rhs) {
+        return !(lhs == rhs);
+    }
+
+    std::ostream& operator<<(std::ostream& os, const Token& rhs) {
+        using namespace token_type;
+
+#define VALUED_OUTPUT(type) \
+    if (auto p = rhs.TryAs<type>()) return os << #type << '{' << p->value << '}';
+
+        VALUED_OUTPUT(Number);
+        VALUED_OUTPUT(Id);
+        VALUED_OUTPUT(String);
+        VALUED_OUTPUT(Char);
+
+#undef VALUED_OUTPUT
+
+#define UNVALUED_OUTPUT(type) \
+    if (rhs.Is<type>()) return os << #type;
+
+        UNVALUED_OUTPUT(Class);
+        UNVALUED_OUTPUT(Return);
+        UNVALUED_OUTPUT(If);
+        UNVALUED_OUTPUT(Else);
+        UNVALUED_OUTPUT(Def);
+        UNVALUED_OUTPUT(Newline);
+        UNVALUED_OUTPUT(Print);
+        UNVALUED_OUTPUT(Indent);
+        UNVALUED_OUTPUT(Dedent);
+        UNVALUED_OUTPUT(And);
+        UNVALUED_OUTPUT(Or);
+        UNVALUED_OUTPUT(Not);
+        UNVALUED_OUTPUT(Eq);
+        UNVALUED_OUTPUT(NotEq);
+        UNVALUED_OUTPUT(LessOrEq);
+        UNVALUED_OUTPUT(GreaterOrEq);
+        UNVALUED_OUTPUT(None);
+        UNVALUED_OUTPUT(True);
+        UNVALUED_OUTPUT(False);
+        UNVALUED_OUTPUT(Eof);
+
+#undef UNVALUED_OUTPUT
+
+        return os << "Unknown token :("sv;
+    }
+
+    namespace {
+        bool IsDigit(char c) {
+            return c >= '0' && c <= '9';
+        }
+
+        bool IsIdStart(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+        }
+
+        // Keywords are told apart by length first, so an identifier costs at most three compares
+        constexpr std::optional<Token> FindKeyword(string_view id) {
+            switch (id.size()) {
+            case 2:
+                if (id == "if"sv) return token_type::If{};
+                if (id == "or"sv) return token_type::Or{};
+                break;
+            case 3:
+                if (id == "def"sv) return token_type::Def{};
+                if (id == "and"sv) return token_type::And{};
+                if (id == "not"sv) return token_type::Not{};
+                break;
+            case 4:
+                if (id == "else"sv) return token_type::Else{};
+                if (id == "None"sv) return token_type::None{};
+                if (id == "True"sv) return token_type::True{};
+                break;
+            case 5:
+                if (id == "class"sv) return token_type::Class{};
+                if (id == "print"sv) return token_type::Print{};
+                if (id == "False"sv) return token_type::False{};
+                break;
+            case 6:
+                if (id == "return"sv) return token_type::Return{};
+                break;
+            default:
+                break;
+            }
+            return std::nullopt;
+        }
+
+        static_assert(FindKeyword("return"sv)->Is<token_type::Return>());
+        static_assert(!FindKeyword("returns"sv));
+    }  // namespace
+
+    Lexer::Lexer(std::istream& input)
+        : owned_source_(istreambuf_iterator<char>(input), istreambuf_iterator<char>()),
+        pos_(owned_source_.data()),
+        end_(owned_source_.data() + owned_source_.size()),
+        token_begin_(pos_),
+        counted_(pos_),
+        line_begin_(pos_) {
+        ScipToBegin();
+        current_token_ = NextToken();
+    }
+
+    Lexer::Lexer(std::string_view source)
+        : pos_(source.data()),
+        end_(source.data() + source.size()),
+        token_begin_(pos_),
+        counted_(pos_),
+        line_begin_(pos_) {
+        ScipToBegin();
+        current_token_ = NextToken();
+    }
+
+    const Token& Lexer::CurrentToken() const {
+        return current_token_;
+    }
+
+    Token Lexer::NextToken() {
+        previous_token_end_ = token_span_.end;
+        Token token = ReadToken();
+        const SourcePosition begin = CountTo(token_begin_);
+        token_span_ = { begin, CountTo(pos_) };
+        return token;
+    }
+
+    SourceSpan Lexer::GetTokenSpan() const {
+        return token_span_;
+    }
+
+    SourcePosition Lexer::GetPreviousTokenEnd() const {
+        return previous_token_end_;
+    }
+
+    // Tokens only move forward through the source, so every character is looked at once however
+    // long its line is
+    SourcePosition Lexer::CountTo(const char* p) {
+        for (const char* newline = scan::FindNewline(counted_, p); newline != p;
+            newline = scan::FindNewline(newline + 1, p)) {
+            line_begin_ = newline + 1;
+            ++line_;
+        }
+        counted_ = p;
+        return { line_, static_cast<uint32_t>(p - line_begin_ + 1) };
+    }
+
+    Token Lexer::ReadToken() {
+        if (new_line_) {
+            CalcSpaceCount();
+            size_t dent_count = space_count_ / 2;
+
+            token_begin_ = pos_;
+            if (Token* token = GetIndentOrDedentToken(dent_count); token) {
+                return *token;
+            }
+            space_count_ = 0;
+        }
+
+        // Usually a single space separates tokens, which is not worth a kernel call
+        if (pos_ != end_ && *pos_ == ' ') {
+            pos_ = scan::SkipSpaces(pos_ + 1, end_);
+        }
+        token_begin_ = pos_;
+        if (pos_ == end_) {
+            return current_token_ = GetEofToken();
+        }
+
+        const char peek = *pos_++;
+        if (IsDigit(peek)) {
+            return current_token_ = GetDigitToken(pos_ - 1);
+        }
+        else if (IsIdStart(peek)) {
+            return current_token_ = GetIdToken(pos_ - 1);
+        }
+        else if (peek == '\"' || peek == '\'') {
+            return current_token_ = GetStringToken(peek);
+        }
+        else if (peek == '#') {
+            ScipComments();
+            return current_token_ = ReadToken();
+        }
+        else if (peek == '\n') {
+            return current_token_ = GetNewLineToken();
+        }
+        else {
+            return current_token_ = GetCharToken(peek);
+        };
+    }
+
+    Token Lexer::GetDigitToken(const char* begin) {
+        empty_line_ = false;
+        while (pos_ != end_ && IsDigit(*pos_)) {
+            ++pos_;
+        }
+        int number = 0;
+        if (from_chars(begin, pos_, number).ec != errc{}) {
+            throw LexerError("number "s + string(begin, pos_) + " is out of range"s);
+        }
+        return token_type::Number{ number };
+    }
+
+    Token Lexer::GetIdToken(const char* begin) {
+        empty_line_ = false;
+        pos_ = scan::SkipIdChars(pos_, end_);
+        const string_view id(begin, pos_ - begin);
+        if (const std::optional<Token> keyword = FindKeyword(id)) {
+            return *keyword;
+        }
+        return token_type::Id{ id };
+    }
+
+    Token Lexer::GetStringToken(char quote) {
+        empty_line_ = false;
+        // A literal without escapes is a view of the source
+        const char* begin = pos_;
+        while (pos_ != end_ && *pos_ != quote && *pos_ != '\\') {
+            ++pos_;
+        }
+        if (pos_ == end_ || *pos_ == quote) {
+            const string_view view(begin, pos_ - begin);
+            if (pos_ != end_) {
+                ++pos_;  // closing quote
+            }
+            return token_type::String{ view };
+        }
+        string& str = decoded_strings_.emplace_back(begin, pos_);
+        while (pos_ != end_ && *pos_ != quote) {
+            if (*pos_ == '\\') {
+                if (++pos_ == end_) {
+                    break;
+                }
+                switch (*pos_) {
+                case 'n':
+                    str.push_back('\n');
+                    break;
+                case 't':
+                    str.push_back('\t');
+                    break;
+                case '\'':
+                case '\"':
+                    str.push_back(*pos_);
+                    break;
+                default:
+                    // Unknown escape sequences are dropped
+                    break;
+                }
+            }
+            else {
+                str.push_back(*pos_);
+            }
+            ++pos_;
+        }
+        if (pos_ != end_) {
+            ++pos_;  // closing quote
+        }
+        return token_type::String{ str };
+    }
+
+    Token Lexer::GetCharToken(char peek) {
+        empty_line_ = false;
+        if (pos_ != end_ && *pos_ == '=') {
+            switch (peek) {
+            case '=':
+                ++pos_;
+                return token_type::Eq{};
+            case '!':
+                ++pos_;
+                return token_type::NotEq{};
+            case '<':
+                ++pos_;
+                return token_type::LessOrEq{};
+            case '>':
+                ++pos_;
+                return token_type::GreaterOrEq{};
+            default:
+                break;
+            }
+        }
+        return token_type::Char{ peek };
+    }
+
+    Token Lexer::GetNewLineToken() {
+        new_line_ = true;
+        if (!empty_line_) {
+            empty_line_ = true;
+            return token_type::Newline{};
+        }
+        return ReadToken();
+    }
+
+    Token Lexer::GetEofToken() {
+        if (!empty_line_) {
+            empty_line_ = true;
+            return token_type::Newline{};
+        }
+        return token_type::Eof{};
+    }
+
+    Token* Lexer::GetIndentOrDedentToken(size_t dent_count) {
+        if (dent_count > dent_count_) {
+            size_t indent_count = dent_count - dent_count_;
+            if (indent_count > 0) {
+                ++dent_count_;
+                current_token_ = token_type::Indent{};
+                return &current_token_;
+            }
+        }
+        else if (dent_count < dent_count_) {
+            size_t dedent_count = dent_count_ - dent_count;
+            if (dedent_count > 0) {
+                --dent_count_;
+                current_token_ = token_type::Dedent{};
+                return &current_token_;
+            }
+        }
+        new_line_ = false;
+        return nullptr;
+    }
+
+    void Lexer::ScipToBegin() {
+        while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\n' || *pos_ == '#')) {
+            if (*pos_ == '#') {
+                ScipComments();
+            }
+            while (pos_ != end_ && (*pos_ == ' ' || *pos_ == '\n')) {
+                ++pos_;
+            }
+        }
+    }
+
+    void Lexer::CalcSpaceCount() {
+        bool new_line_flag;
+        do {
+            const char* indent_end = scan::SkipSpaces(pos_, end_);
+            space_count_ += indent_end - pos_;
+            pos_ = indent_end;
+            new_line_flag = false;
+            if (pos_ != end_ && *pos_ == '\n') {
+                ++pos_;
+                space_count_ = 0;
+                new_line_flag = true;
+            }
+        } while (new_line_flag);
+    }
+
+    void Lexer::ScipComments() {
+        pos_ = scan::FindNewline(pos_, end_);
+    }
+
+}  // namespace parse
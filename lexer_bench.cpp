@@ -0,0 +1,181 @@
+#include "lexer.h"
+#include "scan.h"
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using namespace std;
+using namespace std::literals;
+
+// Lexer throughput on generated corpora of about 16 MB: classes with nested
+// blocks, comments, string literals and arithmetic, then deeply indented code
+// with long names and long comments for every scan kernel level. Then the
+// fixed cost of a Lexer and the cost of classifying an identifier as a
+// keyword or a name.
+// Build with -O2 and run without arguments.
+
+namespace {
+
+    constexpr size_t CORPUS_SIZE = 16 * 1024 * 1024;
+    constexpr int RUNS = 3;
+    constexpr int CONSTRUCTIONS = 1'000'000;
+    constexpr int IDENTIFIER_ROUNDS = 200'000;
+
+    string MakeCorpus() {
+        string corpus;
+        corpus.reserve(CORPUS_SIZE + 1024);
+        for (int i = 0; corpus.size() < CORPUS_SIZE; ++i) {
+            const string n = to_string(i);
+            corpus += "# class number "s + n + '\n';
+            corpus += "class Item"s + n + ":\n"s;
+            corpus += "  def __init__(value, name):\n"s;
+            corpus += "    self.value = value * "s + n + " + 17  # scaled\n"s;
+            corpus += "    self.name = 'item \\'"s + n + "\\''\n"s;
+            corpus += "  def __str__():\n"s;
+            corpus += "    if self.value >= 100 and not self.value == 200:\n"s;
+            corpus += "      return self.name + \" big\"\n"s;
+            corpus += "    return self.name\n\n"s;
+            corpus += "x"s + n + " = Item"s + n + "(3, \"x\")\nprint x"s + n + '\n';
+        }
+        return corpus;
+    }
+
+    string MakeIndentedCorpus() {
+        string corpus;
+        corpus.reserve(CORPUS_SIZE + 1024);
+        for (int i = 0; corpus.size() < CORPUS_SIZE; ++i) {
+            const string n = to_string(i);
+            corpus += "class Component"s + n + ":\n"s;
+            corpus += "  def update_simulation_state_for_frame(current_frame_index, elapsed_time):\n"s;
+            string indent = "    "s;
+            for (int depth = 0; depth < 8; ++depth) {
+                corpus += indent + "# step "s + to_string(depth)
+                    + ": propagate the accumulated transform to every child node of the scene graph\n"s;
+                corpus += indent + "if current_frame_index > "s + to_string(depth) + ":\n"s;
+                indent += "  "s;
+            }
+            corpus += indent + "self.accumulated_transformation_matrix = elapsed_time\n\n"s;
+        }
+        return corpus;
+    }
+
+    size_t CountTokens(parse::Lexer& lexer) {
+        size_t count = 1;
+        while (!lexer.CurrentToken().Is<parse::token_type::Eof>()) {
+            lexer.NextToken();
+            ++count;
+        }
+        return count;
+    }
+
+    template <typename MakeLexer>
+    void Measure(const string& name, const string& corpus, MakeLexer make_lexer) {
+        double best_ms = 0;
+        size_t tokens = 0;
+        for (int run = 0; run < RUNS; ++run) {
+            const auto start = chrono::steady_clock::now();
+            tokens = make_lexer(corpus, CountTokens);
+            const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+            if (run == 0 || elapsed.count() < best_ms) {
+                best_ms = elapsed.count();
+            }
+        }
+        const double megabytes = static_cast<double>(corpus.size()) / (1024 * 1024);
+        cout << name << ": "sv << megabytes / (best_ms / 1000) << " MB/s, "sv
+             << tokens << " tokens in "sv << best_ms << " ms"sv << endl;
+    }
+
+    // Kernel alone: walks the corpus line by line, skipping the indentation of each line
+    void MeasureKernels(const string& name, const string& corpus) {
+        double best_ms = 0;
+        size_t lines = 0;
+        for (int run = 0; run < RUNS; ++run) {
+            lines = 0;
+            const auto start = chrono::steady_clock::now();
+            const char* end = corpus.data() + corpus.size();
+            for (const char* p = corpus.data(); p != end; ++lines) {
+                p = parse::scan::FindNewline(parse::scan::SkipSpaces(p, end), end);
+                if (p != end) {
+                    ++p;
+                }
+            }
+            const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+            if (run == 0 || elapsed.count() < best_ms) {
+                best_ms = elapsed.count();
+            }
+        }
+        const double megabytes = static_cast<double>(corpus.size()) / (1024 * 1024);
+        cout << name << ": "sv << megabytes / (best_ms / 1000) << " MB/s, "sv << lines << " lines"sv << endl;
+    }
+
+    void MeasureConstruction() {
+        const string_view source = "x\n"sv;
+        size_t tokens = 0;
+        const auto start = chrono::steady_clock::now();
+        for (int i = 0; i < CONSTRUCTIONS; ++i) {
+            parse::Lexer lexer(source);
+            tokens += lexer.CurrentToken().Is<parse::token_type::Id>();
+        }
+        const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        cout << "Lexer construction: "sv << elapsed.count() / CONSTRUCTIONS << " ns"sv
+             << " ("sv << tokens << " lexers)"sv << endl;
+    }
+
+    void MeasureIdentifiers() {
+        // Half keywords, half names that share a length or a prefix with one
+        const string line = "class classy return returns if iff else elsewhere print printer "
+                            "and andy or order not note def deft None Nones True Truth False Falsey\n"s;
+        string source;
+        for (int i = 0; i < IDENTIFIER_ROUNDS; ++i) {
+            source += line;
+        }
+        const size_t identifiers = static_cast<size_t>(IDENTIFIER_ROUNDS) * 24;
+
+        const auto start = chrono::steady_clock::now();
+        parse::Lexer lexer(string_view{ source });
+        const size_t tokens = CountTokens(lexer);
+        const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+        cout << "Identifier classification: "sv << elapsed.count() / identifiers << " ns per identifier"sv
+             << " ("sv << tokens << " tokens)"sv << endl;
+    }
+
+}  // namespace
+
+int main() {
+    const string corpus = MakeCorpus();
+
+    Measure("std::istream"s, corpus, [](const string& source, auto count) {
+        istringstream input(source);
+        parse::Lexer lexer(input);
+        return count(lexer);
+    });
+    Measure("std::string_view"s, corpus, [](const string& source, auto count) {
+        parse::Lexer lexer(string_view{ source });
+        return count(lexer);
+    });
+
+    const string indented = MakeIndentedCorpus();
+    const parse::scan::Level best = parse::scan::GetBestSupportedLevel();
+    for (const auto level : { parse::scan::Level::Scalar, parse::scan::Level::Sse2, parse::scan::Level::Avx2 }) {
+        if (level > best) {
+            continue;
+        }
+        parse::scan::SetLevel(level);
+        const string level_name(parse::scan::GetLevelName(level));
+        Measure("mixed, "s + level_name, corpus, [](const string& source, auto count) {
+            parse::Lexer lexer(string_view{ source });
+            return count(lexer);
+        });
+        Measure("indented and commented, "s + level_name, indented, [](const string& source, auto count) {
+            parse::Lexer lexer(string_view{ source });
+            return count(lexer);
+        });
+        MeasureKernels("line kernels only, "s + level_name, indented);
+    }
+    parse::scan::SetLevel(parse::scan::Level::Sse2);
+
+    MeasureConstruction();
+    MeasureIdentifiers();
+}
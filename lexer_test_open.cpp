@@ -1,372 +1,533 @@
-#include "lexer.h"
-#include "test_runner_p.h"
-
-#include <sstream>
-#include <string>
-
-using namespace std;
-
-namespace parse {
-
-    namespace {
-        void TestSimpleAssignment() {
-            istringstream input("x = 42\n"s);
-            Lexer lexer(input);
-
-            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 42 }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-        }
-
-        void TestKeywords() {
-            istringstream input("class return if else def print or None and not True False"s);
-            Lexer lexer(input);
-
-            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Class{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Return{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::If{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Else{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Def{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Print{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Or{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::None{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::And{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Not{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::True{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::False{}));
-        }
-
-        void TestNumbers() {
-            istringstream input("42 15 -53"s);
-            Lexer lexer(input);
-
-            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Number{ 42 }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 15 }));
-            // Отрицательные числа формируются на этапе синтаксического анализа
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '-' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 53 }));
-        }
-
-        void TestIds() {
-            istringstream input("x    _42 big_number   Return Class  dEf"s);
-            Lexer lexer(input);
-
-            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "_42"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "big_number"s }));
-            ASSERT_EQUAL(lexer.NextToken(),
-                Token(token_type::Id{ "Return"s }));  // keywords are case-sensitive
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "Class"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "dEf"s }));
-        }
-
-        void TestStrings() {
-            istringstream input(
-                R"('word' "two words" 'long string with a double quote " inside' "another long string with single quote ' inside")"s);
-            Lexer lexer(input);
-
-            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::String{ "word"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ "two words"s }));
-            ASSERT_EQUAL(lexer.NextToken(),
-                Token(token_type::String{ "long string with a double quote \" inside"s }));
-            ASSERT_EQUAL(lexer.NextToken(),
-                Token(token_type::String{ "another long string with single quote ' inside"s }));
-        }
-
-        void TestOperations() {
-            istringstream input("+-*/= > < != == <> <= >="s);
-            Lexer lexer(input);
-
-            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Char{ '+' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '-' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '*' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '/' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '>' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '<' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::NotEq{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eq{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '<' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '>' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::LessOrEq{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::GreaterOrEq{}));
-        }
-
-        void TestIndentsAndNewlines() {
-            istringstream input(R"(
-no_indent
-  indent_one
-    indent_two
-      indent_three
-      indent_three
-      indent_three
-    indent_two
-  indent_one
-    indent_two
-no_indent
-)"s);
-
-            Lexer lexer(input);
-
-            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "no_indent"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_one"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_two"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_three"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_three"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_three"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_two"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_one"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_two"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "no_indent"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-        }
-
-        void TestEmptyLinesAreIgnored() {
-            istringstream input(R"(
-x = 1
-  y = 2
-
-  z = 3
-
-
-)"s);
-            Lexer lexer(input);
-
-            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 1 }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 2 }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            // Пустая строка, состоящая только из пробельных символов не меняет текущий отступ,
-            // поэтому следующая лексема — это Id, а не Dedent
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "z"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 3 }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-        }
-
-        void TestMythonProgram() {
-            istringstream input(R"(
-x = 4
-y = "hello"
-
-class Point:
-  def __init__(self, x, y):
-    self.x = x
-    self.y = y
-
-  def __str__(self):
-    return str(x) + ' ' + str(y)
-
-p = Point(1, 2)
-print str(p)
-)"s);
-            Lexer lexer(input);
-
-            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 4 }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ "hello"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Class{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "Point"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ':' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Def{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "__init__"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "self"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ',' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "x"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ',' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ':' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "self"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '.' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "x"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "x"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "self"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '.' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Def{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "__str__"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "self"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ':' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Return{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "str"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "x"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '+' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ " "s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '+' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "str"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "p"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "Point"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 1 }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ',' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 2 }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Print{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "str"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "p"s }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-        }
-
-        void TestExpect() {
-            istringstream is("bugaga"s);
-            Lexer lex(is);
-
-            ASSERT_DOESNT_THROW(lex.Expect<token_type::Id>());
-            ASSERT_EQUAL(lex.Expect<token_type::Id>().value, "bugaga"s);
-            ASSERT_DOESNT_THROW(lex.Expect<token_type::Id>("bugaga"s));
-            ASSERT_THROWS(lex.Expect<token_type::Id>("widget"s), LexerError);
-            ASSERT_THROWS(lex.Expect<token_type::Return>(), LexerError);
-        }
-
-        void TestExpectNext() {
-            istringstream is("+ bugaga + def 52"s);
-            Lexer lex(is);
-
-            ASSERT_EQUAL(lex.CurrentToken(), Token(token_type::Char{ '+' }));
-            ASSERT_DOESNT_THROW(lex.ExpectNext<token_type::Id>());
-            ASSERT_DOESNT_THROW(lex.ExpectNext<token_type::Char>('+'));
-            ASSERT_THROWS(lex.ExpectNext<token_type::Newline>(), LexerError);
-            ASSERT_THROWS(lex.ExpectNext<token_type::Number>(57), LexerError);
-        }
-
-        void TestAlwaysEmitsNewlineAtTheEndOfNonemptyLine() {
-            {
-                istringstream is("a b"s);
-                Lexer lexer(is);
-
-                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "a"s }));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "b"s }));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-            }
-            {
-                istringstream is("+"s);
-                Lexer lexer(is);
-
-                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Char{ '+' }));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-            }
-        }
-        void TestCommentsAreIgnored() {
-            {
-                istringstream is(R"(# comment
-)"s);
-                Lexer lexer(is);
-
-                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Eof{}));
-            }
-            {
-                istringstream is(R"(# comment
-
-)"s);
-                Lexer lexer(is);
-                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Eof{}));
-            }
-            {
-                istringstream is(R"(# comment
-x #another comment
-abc#
-'#'
-"#123"
-#)"s);
-
-                Lexer lexer(is);
-                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "abc"s }));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ "#"s }));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ "#123"s }));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
-                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
-            }
-        }
-    }  // namespace
-
-    void RunOpenLexerTests(TestRunner& tr) {
-        RUN_TEST(tr, parse::TestSimpleAssignment);
-        RUN_TEST(tr, parse::TestKeywords);
-        RUN_TEST(tr, parse::TestNumbers);
-        RUN_TEST(tr, parse::TestIds);
-        RUN_TEST(tr, parse::TestStrings);
-        RUN_TEST(tr, parse::TestOperations);
-        RUN_TEST(tr, parse::TestIndentsAndNewlines);
-        RUN_TEST(tr, parse::TestEmptyLinesAreIgnored);
-        RUN_TEST(tr, parse::TestExpect);
-        RUN_TEST(tr, parse::TestExpectNext);
-        RUN_TEST(tr, parse::TestMythonProgram);
-        RUN_TEST(tr, parse::TestAlwaysEmitsNewlineAtTheEndOfNonemptyLine);
-        RUN_TEST(tr, parse::TestCommentsAreIgnored);
-    }
-
+#include "lexer.h"
+#include "scan.h"
+#include "source_file.h"
+#include "test_runner_p.h"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace parse {
+
+    namespace {
+        void TestSimpleAssignment() {
+            istringstream input("x = 42\n"s);
+            Lexer lexer(input);
+
+            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 42 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+        }
+
+        void TestKeywords() {
+            istringstream input("class return if else def print or None and not True False"s);
+            Lexer lexer(input);
+
+            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Class{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Return{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::If{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Else{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Def{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Print{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Or{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::None{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::And{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Not{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::True{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::False{}));
+        }
+
+        void TestNumbers() {
+            istringstream input("42 15 -53"s);
+            Lexer lexer(input);
+
+            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Number{ 42 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 15 }));
+            // Отрицательные числа формируются на этапе синтаксического анализа
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '-' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 53 }));
+        }
+
+        void TestIds() {
+            istringstream input("x    _42 big_number   Return Class  dEf"s);
+            Lexer lexer(input);
+
+            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "_42"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "big_number"s }));
+            ASSERT_EQUAL(lexer.NextToken(),
+                Token(token_type::Id{ "Return"s }));  // keywords are case-sensitive
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "Class"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "dEf"s }));
+        }
+
+        void TestStrings() {
+            istringstream input(
+                R"('word' "two words" 'long string with a double quote " inside' "another long string with single quote ' inside")"s);
+            Lexer lexer(input);
+
+            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::String{ "word"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ "two words"s }));
+            ASSERT_EQUAL(lexer.NextToken(),
+                Token(token_type::String{ "long string with a double quote \" inside"s }));
+            ASSERT_EQUAL(lexer.NextToken(),
+                Token(token_type::String{ "another long string with single quote ' inside"s }));
+        }
+
+        void TestOperations() {
+            istringstream input("+-*/= > < != == <> <= >="s);
+            Lexer lexer(input);
+
+            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Char{ '+' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '-' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '*' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '/' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '>' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '<' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::NotEq{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eq{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '<' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '>' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::LessOrEq{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::GreaterOrEq{}));
+        }
+
+        void TestIndentsAndNewlines() {
+            istringstream input(R"(
+no_indent
+  indent_one
+    indent_two
+      indent_three
+      indent_three
+      indent_three
+    indent_two
+  indent_one
+    indent_two
+no_indent
+)"s);
+
+            Lexer lexer(input);
+
+            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "no_indent"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_one"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_two"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_three"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_three"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_three"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_two"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_one"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "indent_two"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "no_indent"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+        }
+
+        void TestEmptyLinesAreIgnored() {
+            istringstream input(R"(
+x = 1
+  y = 2
+
+  z = 3
+
+
+)"s);
+            Lexer lexer(input);
+
+            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 1 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 2 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            // Пустая строка, состоящая только из пробельных символов не меняет текущий отступ,
+            // поэтому следующая лексема — это Id, а не Dedent
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "z"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 3 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+        }
+
+        void TestMythonProgram() {
+            istringstream input(R"(
+x = 4
+y = "hello"
+
+class Point:
+  def __init__(self, x, y):
+    self.x = x
+    self.y = y
+
+  def __str__(self):
+    return str(x) + ' ' + str(y)
+
+p = Point(1, 2)
+print str(p)
+)"s);
+            Lexer lexer(input);
+
+            ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 4 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ "hello"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Class{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "Point"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ':' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Def{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "__init__"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "self"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ',' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "x"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ',' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ':' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "self"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '.' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "x"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "x"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "self"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '.' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Def{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "__str__"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "self"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ':' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Return{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "str"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "x"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '+' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ " "s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '+' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "str"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "y"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Dedent{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "p"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "Point"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 1 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ',' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Number{ 2 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Print{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "str"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '(' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "p"s }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ ')' }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+        }
+
+        void TestExpect() {
+            istringstream is("bugaga"s);
+            Lexer lex(is);
+
+            ASSERT_DOESNT_THROW(lex.Expect<token_type::Id>());
+            ASSERT_EQUAL(lex.Expect<token_type::Id>().value, "bugaga"s);
+            ASSERT_DOESNT_THROW(lex.Expect<token_type::Id>("bugaga"s));
+            ASSERT_THROWS(lex.Expect<token_type::Id>("widget"s), LexerError);
+            ASSERT_THROWS(lex.Expect<token_type::Return>(), LexerError);
+        }
+
+        void TestExpectNext() {
+            istringstream is("+ bugaga + def 52"s);
+            Lexer lex(is);
+
+            ASSERT_EQUAL(lex.CurrentToken(), Token(token_type::Char{ '+' }));
+            ASSERT_DOESNT_THROW(lex.ExpectNext<token_type::Id>());
+            ASSERT_DOESNT_THROW(lex.ExpectNext<token_type::Char>('+'));
+            ASSERT_THROWS(lex.ExpectNext<token_type::Newline>(), LexerError);
+            ASSERT_THROWS(lex.ExpectNext<token_type::Number>(57), LexerError);
+        }
+
+        void TestAlwaysEmitsNewlineAtTheEndOfNonemptyLine() {
+            {
+                istringstream is("a b"s);
+                Lexer lexer(is);
+
+                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "a"s }));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "b"s }));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+            }
+            {
+                istringstream is("+"s);
+                Lexer lexer(is);
+
+                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Char{ '+' }));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+            }
+        }
+        void TestCommentsAreIgnored() {
+            {
+                istringstream is(R"(# comment
+)"s);
+                Lexer lexer(is);
+
+                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Eof{}));
+            }
+            {
+                istringstream is(R"(# comment
+
+)"s);
+                Lexer lexer(is);
+                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Eof{}));
+            }
+            {
+                istringstream is(R"(# comment
+x #another comment
+abc#
+'#'
+"#123"
+#)"s);
+
+                Lexer lexer(is);
+                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "abc"s }));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ "#"s }));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ "#123"s }));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+            }
+        }
+
+        vector<Token> LexAll(Lexer& lexer) {
+            vector<Token> tokens{ lexer.CurrentToken() };
+            while (!tokens.back().Is<token_type::Eof>()) {
+                tokens.push_back(lexer.NextToken());
+            }
+            return tokens;
+        }
+
+        void TestBufferInput() {
+            const string program = R"(# header
+class Point:
+  def __init__(x, y):
+    self.x = x  # trailing
+    self.y = y
+
+p = Point(10, 2)
+if p.x >= 10 and p.y != 3:
+  print 'it\'s', "a\tpoint\n", p.x <= 7, p.x == 1
+)"s;
+            istringstream input(program);
+            Lexer stream_lexer(input);
+            Lexer buffer_lexer(string_view{ program });
+            ASSERT_EQUAL(LexAll(buffer_lexer), LexAll(stream_lexer));
+
+            // The buffer does not have to be null-terminated
+            const string_view prefix = string_view{ "x = 12345" }.substr(0, 7);
+            Lexer prefix_lexer(prefix);
+            ASSERT_EQUAL(LexAll(prefix_lexer), (vector<Token>{ token_type::Id{ "x"s }, token_type::Char{ '=' },
+                token_type::Number{ 123 }, token_type::Newline{}, token_type::Eof{} }));
+
+            Lexer overflow_lexer(string_view{ "x = 99999999999\n" });
+            ASSERT_THROWS(LexAll(overflow_lexer), LexerError);
+        }
+
+        void TestSourceFile() {
+            const auto path = (filesystem::temp_directory_path() / "mython_source_file_test.my").string();
+            {
+                ofstream file(path, ios::binary);
+                file << "x = 'mapped'\nprint x\n"s;
+            }
+            {
+                SourceFile source(path);
+                ASSERT_EQUAL(source.GetContents(), "x = 'mapped'\nprint x\n"sv);
+
+                Lexer lexer(source.GetContents());
+                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Id{ "x"s }));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Char{ '=' }));
+                ASSERT_EQUAL(lexer.NextToken(), Token(token_type::String{ "mapped"s }));
+            }
+            {
+                ofstream file(path, ios::binary | ios::trunc);
+            }
+            {
+                SourceFile source(path);
+                ASSERT(source.GetContents().empty());
+                Lexer lexer(source.GetContents());
+                ASSERT_EQUAL(lexer.CurrentToken(), Token(token_type::Eof{}));
+            }
+            filesystem::remove(path);
+            ASSERT_THROWS(SourceFile{ path }, SourceFileError);
+        }
+
+        void TestTokenPayloadsViewSource() {
+            const string source = "name = 'plain' + \"esc\\taped\"\n"s;
+            Lexer lexer(string_view{ source });
+            auto points_into_source = [&source](string_view view) {
+                return view.data() >= source.data() && view.data() + view.size() <= source.data() + source.size();
+            };
+
+            const string_view name = lexer.CurrentToken().As<token_type::Id>().value;
+            ASSERT_EQUAL(name, "name"sv);
+            ASSERT(points_into_source(name));
+
+            lexer.NextToken();
+            const string_view plain = lexer.NextToken().As<token_type::String>().value;
+            ASSERT_EQUAL(plain, "plain"sv);
+            ASSERT(points_into_source(plain));
+
+            lexer.NextToken();
+            const string_view escaped = lexer.NextToken().As<token_type::String>().value;
+            ASSERT_EQUAL(escaped, "esc\taped"sv);
+            ASSERT(!points_into_source(escaped));
+
+            // Decoded literals stay valid while the lexer lives
+            lexer.NextToken();
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Eof{}));
+            ASSERT_EQUAL(escaped, "esc\taped"sv);
+        }
+
+        void TestTokenSpans() {
+            const string source = "x = 'a b'\nif x:\n  # note\n  print x\n"s;
+            Lexer lexer(string_view{ source });
+            auto span_of = [&lexer]() {
+                const SourceSpan span = lexer.GetTokenSpan();
+                return vector<uint32_t>{ span.begin.line, span.begin.column, span.end.line, span.end.column };
+            };
+
+            ASSERT_EQUAL(span_of(), (vector<uint32_t>{ 1, 1, 1, 2 }));
+            lexer.NextToken();
+            lexer.NextToken();
+            ASSERT_EQUAL(span_of(), (vector<uint32_t>{ 1, 5, 1, 10 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Newline{}));
+            ASSERT_EQUAL(span_of(), (vector<uint32_t>{ 1, 10, 2, 1 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::If{}));
+            ASSERT_EQUAL(span_of(), (vector<uint32_t>{ 2, 1, 2, 3 }));
+            lexer.NextToken();
+            lexer.NextToken();
+            lexer.NextToken();
+            // The indent is taken at the comment that starts the block
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Indent{}));
+            ASSERT_EQUAL(span_of(), (vector<uint32_t>{ 3, 3, 3, 3 }));
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Print{}));
+            ASSERT_EQUAL(span_of(), (vector<uint32_t>{ 4, 3, 4, 8 }));
+            // Positions may be asked for out of order
+            ASSERT_EQUAL(lexer.GetPreviousTokenEnd().line, 3U);
+            ASSERT_EQUAL(lexer.GetPreviousTokenEnd().column, 3U);
+            ASSERT_EQUAL(lexer.NextToken(), Token(token_type::Id{ "x"s }));
+            ASSERT_EQUAL(span_of(), (vector<uint32_t>{ 4, 9, 4, 10 }));
+            ASSERT_EQUAL(lexer.GetPreviousTokenEnd().column, 8U);
+        }
+
+        void TestScanKernels() {
+            // Runs of every length around the vector widths, ending at every kind of byte
+            string buffer;
+            for (size_t run = 0; run < 70; ++run) {
+                buffer += string(run, ' ') + "a_Z9"s + string(run, 'x') + "\n#\x80 \t"s + string(run % 7, '_') + '\n';
+            }
+            const char* begin = buffer.data();
+            const char* end = buffer.data() + buffer.size();
+
+            const scan::Level initial = scan::GetLevel();
+            scan::SetLevel(scan::Level::Scalar);
+            vector<const char*> spaces, newlines, ids;
+            for (const char* p = begin; p <= end; ++p) {
+                spaces.push_back(scan::SkipSpaces(p, end));
+                newlines.push_back(scan::FindNewline(p, end));
+                ids.push_back(scan::SkipIdChars(p, end));
+            }
+
+            for (scan::Level level : { scan::Level::Sse2, scan::Level::Avx2 }) {
+                scan::SetLevel(level);
+                for (const char* p = begin; p <= end; ++p) {
+                    const size_t i = p - begin;
+                    ASSERT(scan::SkipSpaces(p, end) == spaces[i]);
+                    ASSERT(scan::FindNewline(p, end) == newlines[i]);
+                    ASSERT(scan::SkipIdChars(p, end) == ids[i]);
+                }
+            }
+            scan::SetLevel(initial);
+        }
+    }  // namespace
+
+    void RunOpenLexerTests(TestRunner& tr) {
+        RUN_TEST(tr, parse::TestSimpleAssignment);
+        RUN_TEST(tr, parse::TestKeywords);
+        RUN_TEST(tr, parse::TestNumbers);
+        RUN_TEST(tr, parse::TestIds);
+        RUN_TEST(tr, parse::TestStrings);
+        RUN_TEST(tr, parse::TestOperations);
+        RUN_TEST(tr, parse::TestIndentsAndNewlines);
+        RUN_TEST(tr, parse::TestEmptyLinesAreIgnored);
+        RUN_TEST(tr, parse::TestExpect);
+        RUN_TEST(tr, parse::TestExpectNext);
+        RUN_TEST(tr, parse::TestMythonProgram);
+        RUN_TEST(tr, parse::TestAlwaysEmitsNewlineAtTheEndOfNonemptyLine);
+        RUN_TEST(tr, parse::TestCommentsAreIgnored);
+        RUN_TEST(tr, parse::TestBufferInput);
+        RUN_TEST(tr, parse::TestSourceFile);
+        RUN_TEST(tr, parse::TestTokenPayloadsViewSource);
+        RUN_TEST(tr, parse::TestTokenSpans);
+        RUN_TEST(tr, parse::TestScanKernels);
+    }
+
 }  // namespace parse
\ No newline at end of file
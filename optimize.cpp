@@ -0,0 +1,251 @@
+#include "optimize.h"
+
+#include "statement.h"
+
+#include <ostream>
+
+using namespace std;
+
+namespace ast {
+
+    namespace {
+        template <typename Visit>
+        void ForEachChild(Statement& node, Visit visit) {
+            auto visit_if_present = [&visit](unique_ptr<Statement>& child) {
+                if (child) {
+                    visit(child);
+                }
+            };
+            auto visit_all = [&visit](vector<unique_ptr<Statement>>& nodes) {
+                for (auto& child : nodes) {
+                    visit(child);
+                }
+            };
+            if (auto* assign = dynamic_cast<Assignment*>(&node)) {
+                visit(assign->GetValue());
+            }
+            else if (auto* field_assign = dynamic_cast<FieldAssignment*>(&node)) {
+                visit(field_assign->GetValue());
+            }
+            else if (auto* print = dynamic_cast<Print*>(&node)) {
+                visit_if_present(print->GetArgument());
+                visit_all(print->GetArgs());
+            }
+            else if (auto* call = dynamic_cast<MethodCall*>(&node)) {
+                visit(call->GetObject());
+                visit_all(call->GetArgs());
+            }
+            else if (auto* new_instance = dynamic_cast<NewInstance*>(&node)) {
+                visit_all(new_instance->GetArgs());
+            }
+            else if (auto* unary = dynamic_cast<UnaryOperation*>(&node)) {
+                visit(unary->GetArgument());
+            }
+            else if (auto* binary = dynamic_cast<BinaryOperation*>(&node)) {
+                visit(binary->GetLhs());
+                visit(binary->GetRhs());
+            }
+            else if (auto* compound = dynamic_cast<Compound*>(&node)) {
+                visit_all(compound->GetStatements());
+            }
+            else if (auto* body = dynamic_cast<MethodBody*>(&node)) {
+                visit(body->GetBody());
+            }
+            else if (auto* ret = dynamic_cast<Return*>(&node)) {
+                visit_if_present(ret->GetStatement());
+            }
+            else if (auto* if_else = dynamic_cast<IfElse*>(&node)) {
+                visit(if_else->GetCondition());
+                visit(if_else->GetIfBody());
+                visit_if_present(if_else->GetElseBody());
+            }
+        }
+
+        // Whether the subtree holds a node of type T, not looking into the methods of classes
+        template <typename T>
+        bool Contains(Statement& node) {
+            if (dynamic_cast<T*>(&node)) {
+                return true;
+            }
+            bool found = false;
+            ForEachChild(node, [&found](unique_ptr<Statement>& child) {
+                found = found || Contains<T>(*child);
+            });
+            return found;
+        }
+
+        bool IsLiteral(const Statement& node) {
+            return dynamic_cast<const NumericConst*>(&node) || dynamic_cast<const StringConst*>(&node)
+                || dynamic_cast<const BoolConst*>(&node) || dynamic_cast<const None*>(&node);
+        }
+
+        size_t CountNodes(Statement& node) {
+            size_t count = 1;
+            if (auto* class_def = dynamic_cast<ClassDefinition*>(&node)) {
+                for (runtime::Method& method : class_def->GetClass().TryAs<runtime::Class>()->GetMethods()) {
+                    count += CountNodes(*method.body);
+                }
+            }
+            ForEachChild(node, [&count](unique_ptr<Statement>& child) {
+                count += CountNodes(*child);
+            });
+            return count;
+        }
+
+        class Optimizer {
+        public:
+            void Visit(unique_ptr<Statement>& node) {
+                ForEachChild(*node, [this](unique_ptr<Statement>& child) {
+                    Visit(child);
+                });
+
+                if (auto* class_def = dynamic_cast<ClassDefinition*>(node.get())) {
+                    for (runtime::Method& method : class_def->GetClass().TryAs<runtime::Class>()->GetMethods()) {
+                        Visit(method.body);
+                    }
+                }
+                else if (auto* compound = dynamic_cast<Compound*>(node.get())) {
+                    SimplifyCompound(*compound);
+                }
+                else if (auto* if_else = dynamic_cast<IfElse*>(node.get())) {
+                    SimplifyIfElse(node, *if_else);
+                }
+                else if (auto* disjunction = dynamic_cast<Or*>(node.get())) {
+                    FoldLogical(node, *disjunction, true);
+                }
+                else if (auto* conjunction = dynamic_cast<And*>(node.get())) {
+                    FoldLogical(node, *conjunction, false);
+                }
+                else if (auto* unary = dynamic_cast<UnaryOperation*>(node.get())) {
+                    if (IsLiteral(*unary->GetArgument())) {
+                        Fold(node);
+                    }
+                }
+                else if (auto* binary = dynamic_cast<BinaryOperation*>(node.get())) {
+                    if (IsLiteral(*binary->GetLhs()) && IsLiteral(*binary->GetRhs())) {
+                        Fold(node);
+                    }
+                }
+            }
+
+        private:
+            runtime::ObjectHolder Evaluate(Statement& node) {
+                runtime::Closure closure;
+                return node.Execute(closure, context_);
+            }
+
+            static unique_ptr<Statement> MakeLiteral(const runtime::ObjectHolder& value) {
+                if (!value) {
+                    return make_unique<None>();
+                }
+                if (const auto* number = value.TryAs<runtime::Number>()) {
+                    return make_unique<NumericConst>(number->GetValue());
+                }
+                if (const auto* str = value.TryAs<runtime::String>()) {
+                    return make_unique<StringConst>(str->GetValue());
+                }
+                if (const auto* boolean = value.TryAs<runtime::Bool>()) {
+                    return make_unique<BoolConst>(boolean->GetValue());
+                }
+                return nullptr;
+            }
+
+            // Replaces a node whose operands are all literals with the literal of its value
+            void Fold(unique_ptr<Statement>& node) {
+                try {
+                    if (auto literal = MakeLiteral(Evaluate(*node))) {
+                        literal->SetSpan(node->GetSpan());
+                        node = std::move(literal);
+                    }
+                }
+                catch (const runtime_error&) {
+                    // Left as it is to fail when it runs
+                }
+            }
+
+            // and/or skip their right operand once the left one decides the result
+            void FoldLogical(unique_ptr<Statement>& node, BinaryOperation& operation, bool is_or) {
+                if (!IsLiteral(*operation.GetLhs())) {
+                    return;
+                }
+                if (runtime::IsTrue(Evaluate(*operation.GetLhs())) == is_or) {
+                    auto literal = make_unique<BoolConst>(is_or);
+                    literal->SetSpan(node->GetSpan());
+                    node = std::move(literal);
+                }
+                else if (IsLiteral(*operation.GetRhs())) {
+                    Fold(node);
+                }
+            }
+
+            // A class lives as long as its definition node, which NewInstance nodes elsewhere rely on,
+            // so code holding a class definition is never dropped, even where it cannot run
+            void SimplifyIfElse(unique_ptr<Statement>& node, IfElse& if_else) {
+                if (!IsLiteral(*if_else.GetCondition())) {
+                    return;
+                }
+                const bool condition = runtime::IsTrue(Evaluate(*if_else.GetCondition()));
+                unique_ptr<Statement>& taken = condition ? if_else.GetIfBody() : if_else.GetElseBody();
+                unique_ptr<Statement>& skipped = condition ? if_else.GetElseBody() : if_else.GetIfBody();
+                if (skipped && Contains<ClassDefinition>(*skipped)) {
+                    return;
+                }
+                if (taken) {
+                    node = std::move(taken);
+                }
+                else {
+                    auto none = make_unique<None>();
+                    none->SetSpan(node->GetSpan());
+                    node = std::move(none);
+                }
+            }
+
+            static void Keep(vector<unique_ptr<Statement>>& kept, unique_ptr<Statement>& stmt, bool& returned) {
+                if (returned) {
+                    if (Contains<ClassDefinition>(*stmt)) {
+                        kept.push_back(std::move(stmt));
+                    }
+                    return;
+                }
+                if (IsLiteral(*stmt)) {
+                    return;
+                }
+                returned = dynamic_cast<Return*>(stmt.get()) != nullptr;
+                kept.push_back(std::move(stmt));
+            }
+
+            static void SimplifyCompound(Compound& compound) {
+                vector<unique_ptr<Statement>> kept;
+                bool returned = false;
+                for (auto& stmt : compound.GetStatements()) {
+                    // Nested blocks come from collapsed if/else statements; a return in them ends the
+                    // enclosing block just the same, so they run the same inline
+                    if (auto* nested = dynamic_cast<Compound*>(stmt.get())) {
+                        for (auto& nested_stmt : nested->GetStatements()) {
+                            Keep(kept, nested_stmt, returned);
+                        }
+                    }
+                    else {
+                        Keep(kept, stmt, returned);
+                    }
+                }
+                compound.GetStatements() = std::move(kept);
+            }
+
+            runtime::DummyContext context_;
+        };
+    }  // namespace
+
+    OptimizeStats Optimize(std::unique_ptr<runtime::Executable>& program, std::ostream* node_count_dump) {
+        OptimizeStats stats;
+        stats.nodes_before = CountNodes(*program);
+        Optimizer{}.Visit(program);
+        stats.nodes_after = CountNodes(*program);
+        if (node_count_dump) {
+            *node_count_dump << "nodes before optimization: "s << stats.nodes_before
+                             << ", after: "s << stats.nodes_after << '\n';
+        }
+        return stats;
+    }
+
+}  // namespace ast
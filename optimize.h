@@ -0,0 +1,22 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <iosfwd>
+#include <memory>
+
+namespace ast {
+
+    struct OptimizeStats {
+        size_t nodes_before = 0;
+        size_t nodes_after = 0;
+    };
+
+    // Optional pass over a tree returned by ParseProgram, method bodies of its classes included.
+    // Folds arithmetic, concatenation, str, not/and/or and comparisons whose operands are literals,
+    // collapses if/else statements with a literal condition and drops statements that can never run
+    // after a return. Operations that would fail at run time are left for run time to report.
+    // With node_count_dump set, the node counts before and after the pass are written to it
+    OptimizeStats Optimize(std::unique_ptr<runtime::Executable>& program, std::ostream* node_count_dump = nullptr);
+
+}  // namespace ast
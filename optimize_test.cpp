@@ -0,0 +1,173 @@
+#include "lexer.h"
+#include "optimize.h"
+#include "parse.h"
+#include "statement.h"
+
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace ast {
+
+    namespace {
+        unique_ptr<Statement> Parse(string_view program) {
+            parse::Lexer lexer(program);
+            return ParseProgram(lexer);
+        }
+
+        string Run(Statement& program) {
+            runtime::DummyContext context;
+            runtime::Closure closure;
+            program.Execute(closure, context);
+            return context.output.str();
+        }
+
+        // Runs the program as parsed and once optimized; both must print the same
+        string RunOptimized(string_view program, OptimizeStats* stats = nullptr) {
+            auto tree = Parse(program);
+            const string expected = Run(*tree);
+            tree = Parse(program);
+            const OptimizeStats result = Optimize(tree);
+            if (stats) {
+                *stats = result;
+            }
+            const string output = Run(*tree);
+            ASSERT_EQUAL(output, expected);
+            return output;
+        }
+
+        const vector<unique_ptr<Statement>>& Statements(const Statement& program) {
+            return dynamic_cast<const Compound&>(program).GetStatements();
+        }
+
+        const Statement& AssignedValue(const Statement& stmt) {
+            return *dynamic_cast<const Assignment&>(stmt).GetValue();
+        }
+    }  // namespace
+
+    void TestConstantFolding() {
+        const string_view program = R"(
+x = 2 * 3 + 1
+y = -x
+z = 'a' + "b" + str(5) + str(None)
+w = not 1 < 2 or 3 == 3 and True
+v = False and y
+print x, y, z, w, v
+)"sv;
+        ASSERT_EQUAL(RunOptimized(program), "7 -7 ab5None True False\n"s);
+
+        auto tree = Parse(program);
+        Optimize(tree);
+        const auto& stmts = Statements(*tree);
+        ASSERT_EQUAL(dynamic_cast<const NumericConst&>(AssignedValue(*stmts[0])).GetValue().GetValue(), 7);
+        ASSERT(dynamic_cast<const Mult*>(&AssignedValue(*stmts[1])) != nullptr);
+        ASSERT_EQUAL(dynamic_cast<const StringConst&>(AssignedValue(*stmts[2])).GetValue().GetValue(), "ab5None"s);
+        ASSERT(dynamic_cast<const BoolConst&>(AssignedValue(*stmts[3])).GetValue().GetValue());
+        ASSERT(!dynamic_cast<const BoolConst&>(AssignedValue(*stmts[4])).GetValue().GetValue());
+    }
+
+    void TestFailingOperationsAreNotFolded() {
+        auto tree = Parse("x = 1 / 0\ny = 'a' - 1\nz = None < 1\n"sv);
+        Optimize(tree);
+        const auto& stmts = Statements(*tree);
+        ASSERT(dynamic_cast<const Div*>(&AssignedValue(*stmts[0])) != nullptr);
+        ASSERT(dynamic_cast<const Sub*>(&AssignedValue(*stmts[1])) != nullptr);
+        ASSERT(dynamic_cast<const Comparison*>(&AssignedValue(*stmts[2])) != nullptr);
+        ASSERT_THROWS(Run(*tree), runtime_error);
+    }
+
+    void TestDeadCodeElimination() {
+        const string_view program = R"(
+class A:
+  def f(n):
+    if 1 > 2:
+      return 0
+    else:
+      return n + 1
+    print 'unreachable'
+    n = n + 1
+
+  def g():
+    if False:
+      print 'never'
+    if True:
+      print 'always'
+    return 6
+    print 'unreachable'
+
+  def h():
+    if True:
+      return None
+    return 2
+
+a = A()
+if 'non-empty':
+  print a.f(1), a.g()
+else:
+  print 'never'
+print a.h()
+)"sv;
+        OptimizeStats stats;
+        ASSERT_EQUAL(RunOptimized(program, &stats), "2 always\n6\nNone\n"s);
+        ASSERT(stats.nodes_after < stats.nodes_before);
+
+        auto tree = Parse(program);
+        Optimize(tree);
+        const auto& stmts = Statements(*tree);
+        // The top-level if/else is inlined into the program
+        ASSERT_EQUAL(stmts.size(), 4U);
+        ASSERT(dynamic_cast<const Print*>(stmts[2].get()) != nullptr);
+
+        const auto* cls = dynamic_cast<const ClassDefinition&>(*stmts[0]).GetClass().TryAs<runtime::Class>();
+        auto body = [cls](runtime::Symbol name) -> const vector<unique_ptr<Statement>>& {
+            return Statements(*dynamic_cast<const MethodBody&>(*cls->GetMethod(name)->body).GetBody());
+        };
+        // f: return n + 1, the statements after it are dropped
+        ASSERT_EQUAL(body("f").size(), 1U);
+        ASSERT(dynamic_cast<const Return*>(body("f")[0].get()) != nullptr);
+        // g: print 'always', return 6
+        ASSERT_EQUAL(body("g").size(), 2U);
+        // h: return None
+        ASSERT_EQUAL(body("h").size(), 1U);
+    }
+
+    void TestUnreachableClassesAreKept() {
+        const string_view program = R"(
+class A:
+  def f():
+    return 1
+    class B:
+      def g():
+        return 'b'
+
+if False:
+  class C:
+    def h():
+      return 'c'
+
+b = B()
+c = C()
+print b.g(), c.h()
+)"sv;
+        ASSERT_EQUAL(RunOptimized(program), "b c\n"s);
+    }
+
+    void TestNodeCountDump() {
+        auto tree = Parse("x = 1 + 2\n"sv);
+        ostringstream dump;
+        const OptimizeStats stats = Optimize(tree, &dump);
+        // Compound, Assignment, Add and two constants; then Compound, Assignment and a constant
+        ASSERT_EQUAL(stats.nodes_before, 5U);
+        ASSERT_EQUAL(stats.nodes_after, 3U);
+        ASSERT_EQUAL(dump.str(), "nodes before optimization: 5, after: 3\n"s);
+    }
+
+    void RunOptimizeTests(TestRunner& tr) {
+        RUN_TEST(tr, ast::TestConstantFolding);
+        RUN_TEST(tr, ast::TestFailingOperationsAreNotFolded);
+        RUN_TEST(tr, ast::TestDeadCodeElimination);
+        RUN_TEST(tr, ast::TestUnreachableClassesAreKept);
+        RUN_TEST(tr, ast::TestNodeCountDump);
+    }
+
+}  // namespace ast
@@ -0,0 +1,61 @@
+#include "output_sink.h"
+
+#include <charconv>
+#include <limits>
+
+using namespace std;
+
+namespace runtime {
+
+    OutputSink::OutputSink(std::ostream& output, size_t flush_threshold)
+        : output_(output), flush_threshold_(flush_threshold), stream_(this) {
+        buffer_.reserve(flush_threshold_);
+    }
+
+    OutputSink::~OutputSink() {
+        try {
+            Flush();
+        }
+        catch (...) {
+            // A stream that throws on failure has nowhere to report it from here
+        }
+    }
+
+    void OutputSink::WriteInteger(int value) {
+        char digits[numeric_limits<int>::digits10 + 3];
+        const char* last = to_chars(begin(digits), end(digits), value).ptr;
+        Write(string_view(digits, last - digits));
+    }
+
+    void OutputSink::Flush() {
+        if (!buffer_.empty()) {
+            output_.write(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+            buffer_.clear();
+        }
+        output_.flush();
+    }
+
+    void OutputSink::SetFlushThreshold(size_t flush_threshold) {
+        flush_threshold_ = flush_threshold;
+        buffer_.reserve(flush_threshold_);
+        FlushIfFull();
+    }
+
+    OutputSink::int_type OutputSink::overflow(int_type c) {
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            Write(traits_type::to_char_type(c));
+        }
+        return traits_type::not_eof(c);
+    }
+
+    std::streamsize OutputSink::xsputn(const char* text, std::streamsize count) {
+        Write(string_view(text, static_cast<size_t>(count)));
+        return count;
+    }
+
+    int OutputSink::sync() {
+        Flush();
+        return output_ ? 0 : -1;
+    }
+
+}  // namespace runtime
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace runtime {
+
+    // Append-only buffer in front of the stream a program prints to. Output is collected in one
+    // byte buffer and handed to the stream in a single write once the buffer reaches the flush
+    // threshold, on Flush and on destruction; a threshold of 0 writes every piece through.
+    // GetStream formats through the same buffer, so output written either way stays in order
+    class OutputSink : private std::streambuf {
+    public:
+        static constexpr size_t DEFAULT_FLUSH_THRESHOLD = 64 * 1024;
+
+        explicit OutputSink(std::ostream& output, size_t flush_threshold = DEFAULT_FLUSH_THRESHOLD);
+        ~OutputSink() override;
+
+        OutputSink(const OutputSink&) = delete;
+        OutputSink& operator=(const OutputSink&) = delete;
+
+        void Write(std::string_view text) {
+            buffer_.append(text);
+            FlushIfFull();
+        }
+
+        void Write(char c) {
+            buffer_.push_back(c);
+            FlushIfFull();
+        }
+
+        // Formatted with std::to_chars, the same text as operator<< in the C locale
+        void WriteInteger(int value);
+
+        // Writes the buffer to the stream and flushes the stream
+        void Flush();
+
+        [[nodiscard]] size_t GetFlushThreshold() const {
+            return flush_threshold_;
+        }
+
+        void SetFlushThreshold(size_t flush_threshold);
+
+        // For output formatted by an ostream; slower than Write
+        [[nodiscard]] std::ostream& GetStream() {
+            return stream_;
+        }
+
+    private:
+        void FlushIfFull() {
+            if (buffer_.size() >= flush_threshold_) {
+                Flush();
+            }
+        }
+
+        int_type overflow(int_type c) override;
+        std::streamsize xsputn(const char* text, std::streamsize count) override;
+        int sync() override;
+
+        std::ostream& output_;
+        size_t flush_threshold_;
+        std::string buffer_;
+        std::ostream stream_;
+    };
+
+}  // namespace runtime
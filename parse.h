@@ -1,18 +1,28 @@
-#pragma once
-
-#include <memory>
-#include <stdexcept>
-
-namespace parse {
-    class Lexer;
-}
-
-namespace runtime {
-    class Executable;
-}
-
-struct ParseError : std::runtime_error {
-    using std::runtime_error::runtime_error;
-};
-
-std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
\ No newline at end of file
+#pragma once
+
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+namespace parse {
+    class Lexer;
+}
+
+namespace runtime {
+    class Executable;
+}
+
+struct ParseError : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+// A program is executed by one thread at a time: its classes are reference counted without
+// atomics and its call sites update their caches as they run
+std::unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer);
+
+// Parses the sources on thread_count worker threads (0 - one per hardware thread); the programs
+// come in the order of the sources. If any source fails, the error of the first failing one is
+// rethrown once all workers are done. Each program may then run on any thread, but on one at a time
+std::vector<std::unique_ptr<runtime::Executable>> ParsePrograms(const std::vector<std::string_view>& sources,
+    size_t thread_count = 0);
\ No newline at end of file
@@ -1,259 +1,494 @@
-#include "lexer.h"
-#include "parse.h"
-#include "statement.h"
-
-#include "test_runner_p.h"
-
-using namespace std;
-
-namespace parse {
-
-    unique_ptr<ast::Statement> ParseProgramFromString(const string& program) {
-        istringstream is(program);
-        parse::Lexer lexer(is);
-        return ParseProgram(lexer);
-    }
-
-    void TestSimpleProgram() {
-        const string program = R"(
-x = 4
-y = 5
-z = "hello, "
-n = "world"
-print x + y, z + n
-)"s;
-
-        runtime::DummyContext context;
-
-        runtime::Closure closure;
-        auto tree = ParseProgramFromString(program);
-        tree->Execute(closure, context);
-
-        ASSERT_EQUAL(context.output.str(), "9 hello, world\n"s);
-    }
-
-    void TestProgramWithClasses() {
-        const string program = R"(
-program_name = "Classes test"
-
-class Empty:
-  def __init__():
-    x = 0
-
-class Point:
-  def __init__(x, y):
-    self.x = x
-    self.y = y
-
-  def SetX(value):
-    self.x = value
-  def SetY(value):
-    self.y = value
-
-  def __str__():
-    return '(' + str(self.x) + '; ' + str(self.y) + ')'    #ошибка при выводе origin, far_far_away,
-
-origin = Empty()
-origin = Point(0, 0)
-
-far_far_away = Point(10000, 50000)
-
-print program_name, origin, far_far_away, origin.SetX(1)
-)"s;
-
-        runtime::DummyContext context;
-
-        runtime::Closure closure;
-        auto tree = ParseProgramFromString(program);
-        tree->Execute(closure, context);
-
-        ASSERT_EQUAL(context.output.str(), "Classes test (0; 0) (10000; 50000) None\n"s);
-    }
-
-    void TestProgramWithIf() {
-        const string program = R"(
-x = 4
-y = 5
-if x > y:
-  print "x > y"
-else:
-  print "x <= y"
-if x > 0:
-  if y > 0:
-    print "y > 0"
-  else:
-    print "y <= 0"
-else:
-  print 'x <= 0'
-)"s;
-
-        runtime::DummyContext context;
-
-        runtime::Closure closure;
-        auto tree = ParseProgramFromString(program);
-        tree->Execute(closure, context);
-
-        ASSERT_EQUAL(context.output.str(), "x <= y\ny > 0\n"s);
-    }
-
-    void TestReturnFromIf() {
-        const string program = R"(
-class Abs:
-  def calc(n):
-    if n > 0:
-      return n
-    else:
-      return -n
-
-x = Abs()
-print x.calc(2)
-)"s;
-
-        runtime::DummyContext context;
-
-        runtime::Closure closure;
-        auto tree = ParseProgramFromString(program);
-        tree->Execute(closure, context);
-
-        ASSERT_EQUAL(context.output.str(), "2\n"s);
-    }
-
-    void TestRecursion() {
-        const string program = R"(
-class ArithmeticProgression:
-  def calc(n):
-    self.result = 0
-    self.calc_impl(n)
-
-  def calc_impl(n):
-    value = n
-    if value > 0:
-      self.result = self.result + value
-      self.calc_impl(value - 1)
-
-x = ArithmeticProgression()
-x.calc(10)
-print x.result
-)"s;
-
-        runtime::DummyContext context;
-
-        runtime::Closure closure;
-        auto tree = ParseProgramFromString(program);
-        tree->Execute(closure, context);
-
-        ASSERT_EQUAL(context.output.str(), "55\n"s);
-    }
-
-    void TestRecursion2() {
-        const string program = R"(
-class GCD:
-  def __init__():
-    self.call_count = 0
-
-  def calc(a, b):
-    self.call_count = self.call_count + 1
-    if a < b:
-      return self.calc(b, a)
-    if b == 0:
-      return a
-    return self.calc(a - b, b)
-
-x = GCD()
-print x.calc(510510, 18629977)
-print x.calc(22, 17)
-print x.call_count
-)"s;
-
-        runtime::DummyContext context;
-
-        runtime::Closure closure;
-        auto tree = ParseProgramFromString(program);
-        tree->Execute(closure, context);
-
-        ASSERT_EQUAL(context.output.str(), "17\n1\n115\n"s);
-    }
-
-    void TestComplexLogicalExpression() {
-        const string program = R"(
-a = 1
-b = 2
-c = 3
-ok = a + b > c and a + c > b and b + c > a
-print ok
-)"s;
-
-        runtime::DummyContext context;
-
-        runtime::Closure closure;
-        auto tree = ParseProgramFromString(program);
-        tree->Execute(closure, context);
-
-        ASSERT_EQUAL(context.output.str(), "False\n"s);
-    }
-
-    void TestClassicalPolymorphism() {
-        const string program = R"(
-class Shape:
-  def __str__():
-    return "Shape"
-
-class Rect(Shape):
-  def __init__(w, h):
-    self.w = w
-    self.h = h
-
-  def __str__():
-    return "Rect(" + str(self.w) + 'x' + str(self.h) + ')'
-
-class Circle(Shape):
-  def __init__(r):
-    self.r = r
-
-  def __str__():
-    return 'Circle(' + str(self.r) + ')'
-
-class Triangle(Shape):
-  def __init__(a, b, c):
-    self.ok = a + b > c and a + c > b and b + c > a
-    if (self.ok):
-      self.a = a
-      self.b = b
-      self.c = c
-
-  def __str__():
-    if self.ok:
-      return 'Triangle(' + str(self.a) + ', ' + str(self.b) + ', ' + str(self.c) + ')'
-    else:
-      return 'Wrong triangle'
-
-r = Rect(10, 20)
-c = Circle(52)
-t1 = Triangle(3, 4, 5)
-t2 = Triangle(125, 1, 2)
-
-print r, c, t1, t2
-)"s;
-
-        runtime::DummyContext context;
-
-        runtime::Closure closure;
-        auto tree = ParseProgramFromString(program);
-        tree->Execute(closure, context);
-
-        ASSERT_EQUAL(context.output.str(),
-            "Rect(10x20) Circle(52) Triangle(3, 4, 5) Wrong triangle\n"s);
-    }
-
-}  // namespace parse
-
-void TestParseProgram(TestRunner& tr) {
-    RUN_TEST(tr, parse::TestSimpleProgram);
-    RUN_TEST(tr, parse::TestProgramWithClasses);
-    RUN_TEST(tr, parse::TestProgramWithIf);
-    RUN_TEST(tr, parse::TestReturnFromIf);
-    RUN_TEST(tr, parse::TestRecursion);
-    RUN_TEST(tr, parse::TestRecursion2);
-    RUN_TEST(tr, parse::TestComplexLogicalExpression);
-    RUN_TEST(tr, parse::TestClassicalPolymorphism);
+#include "arena.h"
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+
+#include "test_runner_p.h"
+
+#include <thread>
+
+using namespace std;
+
+namespace parse {
+
+    unique_ptr<ast::Statement> ParseProgramFromString(const string& program) {
+        istringstream is(program);
+        parse::Lexer lexer(is);
+        return ParseProgram(lexer);
+    }
+
+    void TestSimpleProgram() {
+        const string program = R"(
+x = 4
+y = 5
+z = "hello, "
+n = "world"
+print x + y, z + n
+)"s;
+
+        runtime::DummyContext context;
+
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        tree->Execute(closure, context);
+
+        ASSERT_EQUAL(context.output.str(), "9 hello, world\n"s);
+    }
+
+    void TestProgramWithClasses() {
+        const string program = R"(
+program_name = "Classes test"
+
+class Empty:
+  def __init__():
+    x = 0
+
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  def SetX(value):
+    self.x = value
+  def SetY(value):
+    self.y = value
+
+  def __str__():
+    return '(' + str(self.x) + '; ' + str(self.y) + ')'    #ошибка при выводе origin, far_far_away,
+
+origin = Empty()
+origin = Point(0, 0)
+
+far_far_away = Point(10000, 50000)
+
+print program_name, origin, far_far_away, origin.SetX(1)
+)"s;
+
+        runtime::DummyContext context;
+
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        tree->Execute(closure, context);
+
+        ASSERT_EQUAL(context.output.str(), "Classes test (0; 0) (10000; 50000) None\n"s);
+    }
+
+    void TestProgramWithIf() {
+        const string program = R"(
+x = 4
+y = 5
+if x > y:
+  print "x > y"
+else:
+  print "x <= y"
+if x > 0:
+  if y > 0:
+    print "y > 0"
+  else:
+    print "y <= 0"
+else:
+  print 'x <= 0'
+)"s;
+
+        runtime::DummyContext context;
+
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        tree->Execute(closure, context);
+
+        ASSERT_EQUAL(context.output.str(), "x <= y\ny > 0\n"s);
+    }
+
+    void TestReturnFromIf() {
+        const string program = R"(
+class Abs:
+  def calc(n):
+    if n > 0:
+      return n
+    else:
+      return -n
+
+x = Abs()
+print x.calc(2)
+)"s;
+
+        runtime::DummyContext context;
+
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        tree->Execute(closure, context);
+
+        ASSERT_EQUAL(context.output.str(), "2\n"s);
+    }
+
+    void TestRecursion() {
+        const string program = R"(
+class ArithmeticProgression:
+  def calc(n):
+    self.result = 0
+    self.calc_impl(n)
+
+  def calc_impl(n):
+    value = n
+    if value > 0:
+      self.result = self.result + value
+      self.calc_impl(value - 1)
+
+x = ArithmeticProgression()
+x.calc(10)
+print x.result
+)"s;
+
+        runtime::DummyContext context;
+
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        tree->Execute(closure, context);
+
+        ASSERT_EQUAL(context.output.str(), "55\n"s);
+    }
+
+    void TestRecursion2() {
+        const string program = R"(
+class GCD:
+  def __init__():
+    self.call_count = 0
+
+  def calc(a, b):
+    self.call_count = self.call_count + 1
+    if a < b:
+      return self.calc(b, a)
+    if b == 0:
+      return a
+    return self.calc(a - b, b)
+
+x = GCD()
+print x.calc(510510, 18629977)
+print x.calc(22, 17)
+print x.call_count
+)"s;
+
+        runtime::DummyContext context;
+
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        tree->Execute(closure, context);
+
+        ASSERT_EQUAL(context.output.str(), "17\n1\n115\n"s);
+    }
+
+    void TestReturnFromNestedBlocks() {
+        const string program = R"(
+class Flow:
+  def none_first(flag):
+    if flag:
+      return None
+    return 'after'
+
+  def assigns(n):
+    if n > 0:
+      self.last = n
+      x = n
+    return n + 1
+
+  def nested(n):
+    if n > 0:
+      if n > 1:
+        return 'big'
+      print 'small'
+    return 'end'
+
+f = Flow()
+print f.none_first(True), f.none_first(False)
+print f.assigns(3), f.last
+print f.nested(2)
+print f.nested(1)
+print f.nested(0)
+)"s;
+
+        runtime::DummyContext context;
+
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        tree->Execute(closure, context);
+
+        ASSERT_EQUAL(context.output.str(), "None after\n4 3\nbig\nsmall\nend\nend\n"s);
+    }
+
+    void TestComplexLogicalExpression() {
+        const string program = R"(
+a = 1
+b = 2
+c = 3
+ok = a + b > c and a + c > b and b + c > a
+print ok
+)"s;
+
+        runtime::DummyContext context;
+
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        tree->Execute(closure, context);
+
+        ASSERT_EQUAL(context.output.str(), "False\n"s);
+    }
+
+    void TestClassicalPolymorphism() {
+        const string program = R"(
+class Shape:
+  def __str__():
+    return "Shape"
+
+class Rect(Shape):
+  def __init__(w, h):
+    self.w = w
+    self.h = h
+
+  def __str__():
+    return "Rect(" + str(self.w) + 'x' + str(self.h) + ')'
+
+class Circle(Shape):
+  def __init__(r):
+    self.r = r
+
+  def __str__():
+    return 'Circle(' + str(self.r) + ')'
+
+class Triangle(Shape):
+  def __init__(a, b, c):
+    self.ok = a + b > c and a + c > b and b + c > a
+    if (self.ok):
+      self.a = a
+      self.b = b
+      self.c = c
+
+  def __str__():
+    if self.ok:
+      return 'Triangle(' + str(self.a) + ', ' + str(self.b) + ', ' + str(self.c) + ')'
+    else:
+      return 'Wrong triangle'
+
+r = Rect(10, 20)
+c = Circle(52)
+t1 = Triangle(3, 4, 5)
+t2 = Triangle(125, 1, 2)
+
+print r, c, t1, t2
+)"s;
+
+        runtime::DummyContext context;
+
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        tree->Execute(closure, context);
+
+        ASSERT_EQUAL(context.output.str(),
+            "Rect(10x20) Circle(52) Triangle(3, 4, 5) Wrong triangle\n"s);
+    }
+
+    void TestComparisonsCallEachMethodOnce() {
+        const string program = R"(
+class Counted:
+  def __init__(value):
+    self.value = value
+    self.eq_calls = 0
+    self.lt_calls = 0
+
+  def __eq__(other):
+    self.eq_calls = self.eq_calls + 1
+    return self.value == other.value
+
+  def __lt__(other):
+    self.lt_calls = self.lt_calls + 1
+    return self.value < other.value
+
+a = Counted(1)
+b = Counted(1)
+print a > b, a.eq_calls, a.lt_calls
+print a <= b, a.eq_calls, a.lt_calls
+print a >= b, a.eq_calls, a.lt_calls
+print a != b, a.eq_calls, a.lt_calls
+)"s;
+
+        runtime::DummyContext context;
+        runtime::Closure closure;
+        ParseProgramFromString(program)->Execute(closure, context);
+
+        ASSERT_EQUAL(context.output.str(), "False 1 1\nTrue 2 2\nTrue 2 3\nFalse 3 3\n"s);
+    }
+
+    void TestClassesOutliveProgram() {
+        const string program = R"(
+class Counter:
+  def __init__():
+    self.value = 0
+
+  def inc():
+    self.value = self.value + 1
+    return self.value
+
+c = Counter()
+c.inc()
+)"s;
+
+        runtime::DummyContext context;
+
+        runtime::Closure closure;
+        auto tree = ParseProgramFromString(program);
+        ASSERT(runtime::ArenaScope::Current() == nullptr);
+        tree->Execute(closure, context);
+
+        // Method bodies share the arena of the program, which must stay alive for them
+        tree.reset();
+        auto* counter = closure.at("c").TryAs<runtime::ClassInstance>();
+        ASSERT(counter != nullptr);
+        ASSERT_EQUAL(counter->Call("inc", {}, context).TryAs<runtime::Number>()->GetValue(), 2);
+    }
+
+    string MakeNestedProgram(int seed) {
+        // Each program nests to its own depth, so a shared indentation state would show up
+        const int depth = 1 + seed % 6;
+        string program = "class Nest"s + to_string(seed) + ":\n  def run(x):\n"s;
+        string indent = "    "s;
+        for (int level = 0; level < depth; ++level) {
+            program += indent + "if x > "s + to_string(level) + ":  # level "s + to_string(level) + '\n';
+            indent += "  "s;
+        }
+        program += indent + "return x * "s + to_string(seed) + "\n"s;
+        program += "    return 'shallow'\n\nn = Nest"s + to_string(seed) + "()\nprint n.run("s + to_string(depth)
+            + "), n.run(0)\n"s;
+        return program;
+    }
+
+    void TestConcurrentLexingAndParsing() {
+        vector<string> programs;
+        vector<string_view> sources;
+        for (int seed = 0; seed < 48; ++seed) {
+            programs.push_back(MakeNestedProgram(seed));
+        }
+        for (const string& program : programs) {
+            sources.push_back(program);
+        }
+
+        auto lex_all = [](string_view source) {
+            Lexer lexer(source);
+            vector<Token> tokens{ lexer.CurrentToken() };
+            while (!tokens.back().Is<token_type::Eof>()) {
+                tokens.push_back(lexer.NextToken());
+            }
+            return tokens;
+        };
+        vector<vector<Token>> serial_tokens;
+        for (string_view source : sources) {
+            serial_tokens.push_back(lex_all(source));
+        }
+
+        constexpr size_t THREADS = 8;
+        vector<size_t> mismatches(THREADS);
+        vector<thread> threads;
+        for (size_t t = 0; t < THREADS; ++t) {
+            threads.emplace_back([&, t] {
+                for (int round = 0; round < 20; ++round) {
+                    for (size_t i = t; i < sources.size(); i += round % 2 + 1) {
+                        mismatches[t] += lex_all(sources[i]) != serial_tokens[i];
+                    }
+                }
+            });
+        }
+        for (thread& t : threads) {
+            t.join();
+        }
+        ASSERT_EQUAL(mismatches, vector<size_t>(THREADS));
+
+        auto run = [](runtime::Executable& program) {
+            runtime::DummyContext context;
+            runtime::Closure closure;
+            program.Execute(closure, context);
+            return context.output.str();
+        };
+        const auto parallel = ParsePrograms(sources, THREADS);
+        ASSERT_EQUAL(parallel.size(), sources.size());
+        for (size_t i = 0; i < sources.size(); ++i) {
+            ASSERT_EQUAL(run(*parallel[i]), run(*ParseProgramFromString(programs[i])));
+        }
+
+        sources.push_back("print Unknown()\n"sv);
+        ASSERT_THROWS(ParsePrograms(sources, THREADS), ParseError);
+        ASSERT(ParsePrograms({}, THREADS).empty());
+    }
+
+    void TestNodeSpans() {
+        const string program = R"(x = 1
+class Counter:
+  def add(n):
+    if n > 0:
+      self.total = self.total + n
+    return self.total
+
+c = Counter()
+)"s;
+        auto tree = ParseProgramFromString(program);
+        auto span_of = [](const ast::Statement& node) {
+            const SourceSpan& span = node.GetSpan();
+            return vector<uint32_t>{ span.begin.line, span.begin.column, span.end.line, span.end.column };
+        };
+
+        const auto& stmts = dynamic_cast<const ast::Compound&>(*tree).GetStatements();
+        ASSERT_EQUAL(span_of(*tree), (vector<uint32_t>{ 1, 1, 8, 14 }));
+        ASSERT_EQUAL(span_of(*stmts[0]), (vector<uint32_t>{ 1, 1, 1, 6 }));
+        ASSERT_EQUAL(span_of(*stmts[1]), (vector<uint32_t>{ 2, 1, 6, 22 }));
+        ASSERT_EQUAL(span_of(*stmts[2]), (vector<uint32_t>{ 8, 1, 8, 14 }));
+
+        const auto* cls = dynamic_cast<const ast::ClassDefinition&>(*stmts[1]).GetClass().TryAs<runtime::Class>();
+        const runtime::Method* add = cls->GetMethod("add");
+        ASSERT_EQUAL(span_of(*add->body), (vector<uint32_t>{ 3, 3, 6, 22 }));
+
+        const auto& body = dynamic_cast<const ast::Compound&>(*dynamic_cast<const ast::MethodBody&>(*add->body).GetBody());
+        const auto& if_else = dynamic_cast<const ast::IfElse&>(*body.GetStatements()[0]);
+        ASSERT_EQUAL(span_of(if_else), (vector<uint32_t>{ 4, 5, 5, 34 }));
+        ASSERT_EQUAL(span_of(*if_else.GetCondition()), (vector<uint32_t>{ 4, 8, 4, 13 }));
+        const auto& field_assign = dynamic_cast<const ast::FieldAssignment&>(
+            *dynamic_cast<const ast::Compound&>(*if_else.GetIfBody()).GetStatements()[0]);
+        // self.total + n
+        ASSERT_EQUAL(span_of(*field_assign.GetValue()), (vector<uint32_t>{ 5, 20, 5, 34 }));
+    }
+
+    void TestSpansOnLongLine() {
+        // Spans on one 300 KB line; the lexer looking back to the line start for each of them
+        // makes this take seconds instead of milliseconds
+        constexpr int TERMS = 100'000;
+        string program = "print 0"s;
+        for (int i = 1; i < TERMS; ++i) {
+            program += ", 1"sv;
+        }
+        program += '\n';
+        auto tree = ParseProgramFromString(program);
+
+        const auto& print = dynamic_cast<const ast::Print&>(*dynamic_cast<const ast::Compound&>(*tree).GetStatements()[0]);
+        ASSERT_EQUAL(print.GetArgs().size(), static_cast<size_t>(TERMS));
+        const SourceSpan& last = print.GetArgs().back()->GetSpan();
+        const auto last_column = static_cast<uint32_t>(program.size() - 1);
+        ASSERT_EQUAL(last.begin.line, 1U);
+        ASSERT_EQUAL(last.begin.column, last_column);
+        ASSERT_EQUAL(last.end.column, last_column + 1);
+        ASSERT_EQUAL(print.GetSpan().end.column, last_column + 1);
+    }
+
+}  // namespace parse
+
+void TestParseProgram(TestRunner& tr) {
+    RUN_TEST(tr, parse::TestSimpleProgram);
+    RUN_TEST(tr, parse::TestProgramWithClasses);
+    RUN_TEST(tr, parse::TestProgramWithIf);
+    RUN_TEST(tr, parse::TestReturnFromIf);
+    RUN_TEST(tr, parse::TestRecursion);
+    RUN_TEST(tr, parse::TestRecursion2);
+    RUN_TEST(tr, parse::TestReturnFromNestedBlocks);
+    RUN_TEST(tr, parse::TestComplexLogicalExpression);
+    RUN_TEST(tr, parse::TestClassicalPolymorphism);
+    RUN_TEST(tr, parse::TestComparisonsCallEachMethodOnce);
+    RUN_TEST(tr, parse::TestClassesOutliveProgram);
+    RUN_TEST(tr, parse::TestConcurrentLexingAndParsing);
+    RUN_TEST(tr, parse::TestNodeSpans);
+    RUN_TEST(tr, parse::TestSpansOnLongLine);
 }
\ No newline at end of file
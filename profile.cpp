@@ -0,0 +1,251 @@
+#include "profile.h"
+
+#include "statement.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace ast {
+
+    namespace {
+        using Clock = chrono::steady_clock;
+
+        template <typename Visit>
+        void ForEachChild(Statement& node, Visit visit) {
+            auto visit_if_present = [&visit](unique_ptr<Statement>& child) {
+                if (child) {
+                    visit(child);
+                }
+            };
+            auto visit_all = [&visit](vector<unique_ptr<Statement>>& nodes) {
+                for (auto& child : nodes) {
+                    visit(child);
+                }
+            };
+            if (auto* assign = dynamic_cast<Assignment*>(&node)) {
+                visit(assign->GetValue());
+            }
+            else if (auto* field_assign = dynamic_cast<FieldAssignment*>(&node)) {
+                visit(field_assign->GetValue());
+            }
+            else if (auto* print = dynamic_cast<Print*>(&node)) {
+                visit_if_present(print->GetArgument());
+                visit_all(print->GetArgs());
+            }
+            else if (auto* call = dynamic_cast<MethodCall*>(&node)) {
+                visit(call->GetObject());
+                visit_all(call->GetArgs());
+            }
+            else if (auto* new_instance = dynamic_cast<NewInstance*>(&node)) {
+                visit_all(new_instance->GetArgs());
+            }
+            else if (auto* unary = dynamic_cast<UnaryOperation*>(&node)) {
+                visit(unary->GetArgument());
+            }
+            else if (auto* binary = dynamic_cast<BinaryOperation*>(&node)) {
+                visit(binary->GetLhs());
+                visit(binary->GetRhs());
+            }
+            else if (auto* compound = dynamic_cast<Compound*>(&node)) {
+                visit_all(compound->GetStatements());
+            }
+            else if (auto* body = dynamic_cast<MethodBody*>(&node)) {
+                visit(body->GetBody());
+            }
+            else if (auto* ret = dynamic_cast<Return*>(&node)) {
+                visit_if_present(ret->GetStatement());
+            }
+            else if (auto* if_else = dynamic_cast<IfElse*>(&node)) {
+                visit(if_else->GetCondition());
+                visit(if_else->GetIfBody());
+                visit_if_present(if_else->GetElseBody());
+            }
+        }
+
+        string JoinDottedIds(const vector<runtime::Symbol>& ids) {
+            string result;
+            for (runtime::Symbol id : ids) {
+                if (!result.empty()) {
+                    result += '.';
+                }
+                result += id.GetName();
+            }
+            return result;
+        }
+
+        string Label(const Statement& node) {
+            if (const auto* var = dynamic_cast<const VariableValue*>(&node)) {
+                return "VariableValue "s + JoinDottedIds(var->GetDottedIds());
+            }
+            if (const auto* assign = dynamic_cast<const Assignment*>(&node)) {
+                return "Assignment "s + assign->GetName().GetName();
+            }
+            if (const auto* field_assign = dynamic_cast<const FieldAssignment*>(&node)) {
+                return "FieldAssignment "s + JoinDottedIds(field_assign->GetObject().GetDottedIds()) + '.'
+                    + field_assign->GetFieldName().GetName();
+            }
+            if (const auto* call = dynamic_cast<const MethodCall*>(&node)) {
+                return "MethodCall "s + call->GetMethod().GetName();
+            }
+            if (const auto* new_instance = dynamic_cast<const NewInstance*>(&node)) {
+                return "NewInstance "s + new_instance->GetClass().GetName();
+            }
+            if (const auto* class_def = dynamic_cast<const ClassDefinition*>(&node)) {
+                return "ClassDefinition "s + class_def->GetClass().TryAs<runtime::Class>()->GetName();
+            }
+            if (const auto* cmp = dynamic_cast<const Comparison*>(&node)) {
+                static constexpr string_view OPERATORS[] = { "=="sv, "!="sv, "<"sv, ">"sv, "<="sv, ">="sv };
+                return "Comparison "s + string(OPERATORS[static_cast<size_t>(cmp->GetComparator())]);
+            }
+#define NODE_LABEL(type) \
+    if (dynamic_cast<const type*>(&node)) return #type;
+
+            NODE_LABEL(NumericConst);
+            NODE_LABEL(StringConst);
+            NODE_LABEL(BoolConst);
+            NODE_LABEL(None);
+            NODE_LABEL(Print);
+            NODE_LABEL(Stringify);
+            NODE_LABEL(Add);
+            NODE_LABEL(Sub);
+            NODE_LABEL(Mult);
+            NODE_LABEL(Div);
+            NODE_LABEL(Or);
+            NODE_LABEL(And);
+            NODE_LABEL(Not);
+            NODE_LABEL(Compound);
+            NODE_LABEL(MethodBody);
+            NODE_LABEL(Return);
+            NODE_LABEL(IfElse);
+
+#undef NODE_LABEL
+
+            return "Executable"s;
+        }
+
+        // Runs the node it wraps and adds the run to its entry
+        class ProfiledNode final : public Statement {
+        public:
+            ProfiledNode(unique_ptr<Statement> node, Profiler::Entry& entry, chrono::nanoseconds& children_time)
+                : node_(std::move(node)), entry_(entry), children_time_(children_time) {
+                SetSpan(node_->GetSpan());
+            }
+
+            runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override {
+                Run run(*this);
+                return node_->Execute(closure, context);
+            }
+
+        private:
+            // Accounts one run, also one that ends with an exception
+            class Run {
+            public:
+                explicit Run(ProfiledNode& node)
+                    : node_(node), parent_children_time_(node.children_time_), start_(Clock::now()) {
+                    ++node_.entry_.count;
+                    ++node_.depth_;
+                    node_.children_time_ = {};
+                }
+
+                Run(const Run&) = delete;
+                Run& operator=(const Run&) = delete;
+
+                ~Run() {
+                    const chrono::nanoseconds elapsed = Clock::now() - start_;
+                    if (--node_.depth_ == 0) {
+                        node_.entry_.inclusive += elapsed;
+                    }
+                    node_.entry_.exclusive += elapsed - node_.children_time_;
+                    node_.children_time_ = parent_children_time_ + elapsed;
+                }
+
+            private:
+                ProfiledNode& node_;
+                chrono::nanoseconds parent_children_time_;
+                Clock::time_point start_;
+            };
+
+            unique_ptr<Statement> node_;
+            Profiler::Entry& entry_;
+            chrono::nanoseconds& children_time_;
+            size_t depth_ = 0;
+        };
+
+        void WriteEntries(ostream& output, string_view title, const deque<Profiler::Entry>& entries, size_t limit) {
+            vector<const Profiler::Entry*> ran;
+            for (const Profiler::Entry& entry : entries) {
+                if (entry.count != 0) {
+                    ran.push_back(&entry);
+                }
+            }
+            sort(ran.begin(), ran.end(), [](const Profiler::Entry* lhs, const Profiler::Entry* rhs) {
+                return lhs->exclusive > rhs->exclusive;
+            });
+            ran.resize(min(ran.size(), limit));
+
+            auto ms = [](chrono::nanoseconds time) {
+                return chrono::duration<double, milli>(time).count();
+            };
+            output << title << '\n';
+            output << setw(12) << "count"sv << setw(12) << "incl ms"sv << setw(12) << "excl ms"sv
+                   << "  location"sv << '\n';
+            for (const Profiler::Entry* entry : ran) {
+                output << setw(12) << entry->count << fixed << setprecision(3)
+                       << setw(12) << ms(entry->inclusive) << setw(12) << ms(entry->exclusive)
+                       << "  "sv << entry->span.begin.line << ':' << entry->span.begin.column
+                       << ' ' << entry->label << '\n';
+            }
+            output << defaultfloat;
+        }
+    }  // namespace
+
+    void Profiler::Instrument(std::unique_ptr<runtime::Executable>& program) {
+        InstrumentNode(program);
+    }
+
+    void Profiler::InstrumentNode(std::unique_ptr<runtime::Executable>& node) {
+        ForEachChild(*node, [this](unique_ptr<Statement>& child) {
+            InstrumentNode(child);
+        });
+
+        if (auto* class_def = dynamic_cast<ClassDefinition*>(node.get())) {
+            runtime::Class* cls = class_def->GetClass().TryAs<runtime::Class>();
+            for (runtime::Method& method : cls->GetMethods()) {
+                // A method body is timed as its method, not as one more node
+                ForEachChild(*method.body, [this](unique_ptr<Statement>& child) {
+                    InstrumentNode(child);
+                });
+                Entry& entry = methods_.emplace_back();
+                entry.label = cls->GetName() + '.' + method.name.GetName();
+                entry.span = method.body->GetSpan();
+                method.body = make_unique<ProfiledNode>(std::move(method.body), entry, children_time_);
+            }
+        }
+
+        Entry& entry = nodes_.emplace_back();
+        entry.label = Label(*node);
+        entry.span = node->GetSpan();
+        node = make_unique<ProfiledNode>(std::move(node), entry, children_time_);
+    }
+
+    void Profiler::WriteReport(std::ostream& output, size_t limit) const {
+        WriteEntries(output, "methods by exclusive time:"sv, methods_, limit);
+        WriteEntries(output, "nodes by exclusive time:"sv, nodes_, limit);
+    }
+
+    void Profiler::SaveReport(const std::string& path, size_t limit) const {
+        ofstream output(path, ios::trunc);
+        WriteReport(output, limit);
+        if (!output.flush()) {
+            throw runtime_error("Cannot write the profile report to "s + path);
+        }
+    }
+
+}  // namespace ast
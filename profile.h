@@ -0,0 +1,60 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <memory>
+#include <string>
+
+namespace ast {
+
+    // Opt-in execution profile of a program. Instrument wraps the nodes of a tree in nodes that
+    // count and time them; a tree that is not instrumented runs as it always does, so profiling
+    // costs nothing unless asked for. Not thread-safe
+    class Profiler {
+    public:
+        struct Entry {
+            // Node type, with the name it works on where it has one; Class.method for methods
+            std::string label;
+            parse::SourceSpan span;
+            std::uint64_t count = 0;
+            // Inclusive time counts a recursive node or method once per outermost run
+            std::chrono::nanoseconds inclusive{ 0 };
+            // Time not spent in instrumented nodes under this one
+            std::chrono::nanoseconds exclusive{ 0 };
+        };
+
+        // Wraps every node of a tree returned by ParseProgram, method bodies of its classes included.
+        // Run it after any other pass over the tree: the wrappers are opaque to them. The profiler
+        // must outlive the tree
+        void Instrument(std::unique_ptr<runtime::Executable>& program);
+
+        // In the order they were instrumented
+        [[nodiscard]] const std::deque<Entry>& GetNodes() const {
+            return nodes_;
+        }
+
+        [[nodiscard]] const std::deque<Entry>& GetMethods() const {
+            return methods_;
+        }
+
+        // Methods and then nodes that ran, hottest first by exclusive time, at most limit of each
+        void WriteReport(std::ostream& output, size_t limit = 20) const;
+
+        // Same report, written to a file; throws std::runtime_error if it cannot be written
+        void SaveReport(const std::string& path, size_t limit = 20) const;
+
+    private:
+        void InstrumentNode(std::unique_ptr<runtime::Executable>& node);
+
+        // Entries never move, the instrumented nodes refer to them
+        std::deque<Entry> nodes_;
+        std::deque<Entry> methods_;
+        // Time spent in the instrumented children of the node that is running
+        std::chrono::nanoseconds children_time_{ 0 };
+    };
+
+}  // namespace ast
@@ -0,0 +1,107 @@
+#include "lexer.h"
+#include "parse.h"
+#include "profile.h"
+#include "statement.h"
+
+#include "test_runner_p.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace std;
+
+namespace ast {
+
+    namespace {
+        const string PROGRAM = R"(class Counter:
+  def __init__():
+    self.total = 0
+
+  def count(n):
+    if n > 0:
+      self.total = self.total + n
+      self.count(n - 1)
+
+c = Counter()
+c.count(50)
+print c.total
+)"s;
+
+        unique_ptr<Statement> Parse(string_view program) {
+            parse::Lexer lexer(program);
+            return ParseProgram(lexer);
+        }
+
+        string Run(Statement& program) {
+            runtime::DummyContext context;
+            runtime::Closure closure;
+            program.Execute(closure, context);
+            return context.output.str();
+        }
+
+        const Profiler::Entry* Find(const deque<Profiler::Entry>& entries, string_view label) {
+            for (const Profiler::Entry& entry : entries) {
+                if (entry.label == label) {
+                    return &entry;
+                }
+            }
+            return nullptr;
+        }
+    }  // namespace
+
+    void TestProfileCountsRuns() {
+        Profiler profiler;
+        auto tree = Parse(PROGRAM);
+        profiler.Instrument(tree);
+        ASSERT_EQUAL(Run(*tree), Run(*Parse(PROGRAM)));
+
+        const Profiler::Entry* count = Find(profiler.GetMethods(), "Counter.count"sv);
+        ASSERT(count != nullptr);
+        ASSERT_EQUAL(count->count, 51U);
+        ASSERT_EQUAL(count->span.begin.line, 5U);
+        ASSERT(count->inclusive >= count->exclusive);
+        ASSERT_EQUAL(Find(profiler.GetMethods(), "Counter.__init__"sv)->count, 1U);
+
+        const Profiler::Entry* field_assign = Find(profiler.GetNodes(), "FieldAssignment self.total"sv);
+        ASSERT(field_assign != nullptr);
+        ASSERT_EQUAL(field_assign->span.begin.line, 3U);
+        ASSERT_EQUAL(Find(profiler.GetNodes(), "Comparison >"sv)->count, 51U);
+        // The call in the method, instrumented before the one in the program
+        ASSERT_EQUAL(Find(profiler.GetNodes(), "MethodCall count"sv)->count, 50U);
+        ASSERT_EQUAL(Find(profiler.GetNodes(), "NewInstance Counter"sv)->count, 1U);
+
+        // The program node takes all the time, the recursion is counted once
+        const Profiler::Entry& program = profiler.GetNodes().back();
+        ASSERT_EQUAL(program.label, "Compound"s);
+        ASSERT(program.inclusive >= count->inclusive);
+    }
+
+    void TestProfileReport() {
+        Profiler profiler;
+        auto tree = Parse(PROGRAM);
+        profiler.Instrument(tree);
+        Run(*tree);
+
+        ostringstream report;
+        profiler.WriteReport(report, 3);
+        const string text = report.str();
+        ASSERT(text.find("methods by exclusive time:"s) == 0);
+        ASSERT(text.find("5:3 Counter.count"s) != string::npos);
+        ASSERT(text.find("nodes by exclusive time:"s) != string::npos);
+        // Two titles, two headers and at most three entries in each list
+        ASSERT(count(text.begin(), text.end(), '\n') <= 10);
+
+        const filesystem::path path = filesystem::temp_directory_path() / "mython_profile_test.txt"s;
+        profiler.SaveReport(path.string(), 3);
+        ifstream file(path);
+        ASSERT_EQUAL(string(istreambuf_iterator<char>(file), istreambuf_iterator<char>()), text);
+        filesystem::remove(path);
+        ASSERT_THROWS(profiler.SaveReport((path / "missing"s / "report.txt"s).string()), runtime_error);
+    }
+
+    void RunProfileTests(TestRunner& tr) {
+        RUN_TEST(tr, ast::TestProfileCountsRuns);
+        RUN_TEST(tr, ast::TestProfileReport);
+    }
+
+}  // namespace ast
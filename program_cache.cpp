@@ -0,0 +1,812 @@
+#include "program_cache.h"
+
+#include "arena.h"
+#include "lexer.h"
+#include "parse.h"
+#include "source_file.h"
+#include "statement.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <unordered_map>
+
+using namespace std;
+
+namespace parse {
+
+    namespace {
+        // Image layout, all integers little-endian:
+        //   header   "MYPC", u32 version, u64 source hash, u64 source check, u64 source size
+        //   symbols  u32 count, then u32 length and bytes of each
+        //   classes  u32 count, then for each: u32 name, u32 parent (index + 1, 0 - none),
+        //            u32 method count and per method: u32 name, u32 param count, u32 params,
+        //            u32 frame size, node body
+        //   program  node
+        // A node is a u8 tag and the fields of its record, then the line and column of the start and of
+        // the end of its source span as four u32; symbols and classes are referred to by
+        // index, and a class only to classes before it, as the parser creates them in that order
+        constexpr string_view MAGIC = "MYPC"sv;
+
+        // Deep enough for any script the recursive parser handles comfortably
+        constexpr size_t MAX_DEPTH = 2048;
+        constexpr size_t MAX_FRAME_SIZE = 65536;
+        constexpr uint32_t NO_INDEX = 0xFFFFFFFFU;
+
+        enum class Tag : uint8_t {
+            Absent,
+            NumericConst,
+            StringConst,
+            BoolConst,
+            VariableValue,
+            Assignment,
+            FieldAssignment,
+            None,
+            Print,
+            MethodCall,
+            NewInstance,
+            Stringify,
+            Add,
+            Sub,
+            Mult,
+            Div,
+            Or,
+            And,
+            Not,
+            Compound,
+            MethodBody,
+            Return,
+            ClassDefinition,
+            IfElse,
+            Comparison,
+        };
+
+        const runtime::Class* AsClass(const runtime::ObjectHolder& holder) {
+            return holder.TryAs<runtime::Class>();
+        }
+
+        class ImageWriter {
+        public:
+            string Write(const runtime::Executable& program, SourceKey key) {
+                CollectClasses(program, 0);
+
+                WriteU32(static_cast<uint32_t>(classes_.size()));
+                for (const runtime::Class* cls : classes_) {
+                    WriteClass(*cls);
+                }
+                WriteNode(&program, 0);
+
+                string image;
+                image.reserve(MAGIC.size() + 32 + symbol_bytes_ + body_.size());
+                image += MAGIC;
+                AppendU32(image, PROGRAM_IMAGE_VERSION);
+                AppendU64(image, key.hash);
+                AppendU64(image, key.check);
+                AppendU64(image, key.size);
+                AppendU32(image, static_cast<uint32_t>(symbols_.size()));
+                for (runtime::Symbol symbol : symbols_) {
+                    AppendU32(image, static_cast<uint32_t>(symbol.GetName().size()));
+                    image += symbol.GetName();
+                }
+                image += body_;
+                return image;
+            }
+
+        private:
+            static void AppendU32(string& out, uint32_t value) {
+                for (int shift = 0; shift < 32; shift += 8) {
+                    out.push_back(static_cast<char>(value >> shift));
+                }
+            }
+
+            static void AppendU64(string& out, uint64_t value) {
+                AppendU32(out, static_cast<uint32_t>(value));
+                AppendU32(out, static_cast<uint32_t>(value >> 32));
+            }
+
+            void WriteU8(uint8_t value) {
+                body_.push_back(static_cast<char>(value));
+            }
+
+            void WriteU32(uint32_t value) {
+                AppendU32(body_, value);
+            }
+
+            void WriteCount(size_t count) {
+                if (count >= NO_INDEX) {
+                    throw ProgramCacheError("Too many elements for a program image"s);
+                }
+                WriteU32(static_cast<uint32_t>(count));
+            }
+
+            void WriteSlot(size_t slot) {
+                WriteU32(slot == ast::NO_SLOT ? NO_INDEX : static_cast<uint32_t>(slot));
+            }
+
+            void WriteSymbol(runtime::Symbol symbol) {
+                const auto [it, inserted] = symbol_indices_.emplace(symbol, static_cast<uint32_t>(symbols_.size()));
+                if (inserted) {
+                    symbols_.push_back(symbol);
+                    symbol_bytes_ += 4 + symbol.GetName().size();
+                }
+                WriteU32(it->second);
+            }
+
+            void WriteSymbols(const vector<runtime::Symbol>& symbols) {
+                WriteCount(symbols.size());
+                for (runtime::Symbol symbol : symbols) {
+                    WriteSymbol(symbol);
+                }
+            }
+
+            void WriteClassIndex(const runtime::Class& cls) {
+                const auto it = class_indices_.find(&cls);
+                if (it == class_indices_.end()) {
+                    throw ProgramCacheError("Class "s + cls.GetName() + " is not declared by the program"s);
+                }
+                WriteU32(it->second);
+            }
+
+            void WriteClass(const runtime::Class& cls) {
+                WriteSymbol(runtime::Symbol(cls.GetName()));
+                if (const runtime::Class* parent = cls.GetParent()) {
+                    WriteU32(class_indices_.at(parent) + 1);
+                }
+                else {
+                    WriteU32(0);
+                }
+                WriteCount(cls.GetMethods().size());
+                for (const runtime::Method& method : cls.GetMethods()) {
+                    WriteSymbol(method.name);
+                    WriteSymbols(method.formal_params);
+                    WriteCount(method.frame_size);
+                    WriteNode(method.body.get(), 0);
+                }
+            }
+
+            void WriteNodes(const vector<unique_ptr<ast::Statement>>& nodes, size_t depth) {
+                WriteCount(nodes.size());
+                for (const auto& node : nodes) {
+                    WriteNode(node.get(), depth);
+                }
+            }
+
+            void WriteBinary(Tag tag, const ast::BinaryOperation& node, size_t depth) {
+                WriteU8(static_cast<uint8_t>(tag));
+                WriteNode(node.GetLhs().get(), depth);
+                WriteNode(node.GetRhs().get(), depth);
+            }
+
+            void WriteUnary(Tag tag, const ast::UnaryOperation& node, size_t depth) {
+                WriteU8(static_cast<uint8_t>(tag));
+                WriteNode(node.GetArgument().get(), depth);
+            }
+
+            void WriteNode(const ast::Statement* node, size_t depth) {
+                if (++depth > MAX_DEPTH) {
+                    throw ProgramCacheError("Program nests too deeply for an image"s);
+                }
+                if (!node) {
+                    WriteU8(static_cast<uint8_t>(Tag::Absent));
+                    return;
+                }
+                WriteRecord(node, depth);
+                const parse::SourceSpan& span = node->GetSpan();
+                WriteU32(span.begin.line);
+                WriteU32(span.begin.column);
+                WriteU32(span.end.line);
+                WriteU32(span.end.column);
+            }
+
+            void WriteRecord(const ast::Statement* node, size_t depth) {
+                if (const auto* number = dynamic_cast<const ast::NumericConst*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::NumericConst));
+                    WriteU32(static_cast<uint32_t>(number->GetValue().GetValue()));
+                    return;
+                }
+                if (const auto* str = dynamic_cast<const ast::StringConst*>(node)) {
+                    const string& value = str->GetValue().GetValue();
+                    WriteU8(static_cast<uint8_t>(Tag::StringConst));
+                    WriteCount(value.size());
+                    body_ += value;
+                    return;
+                }
+                if (const auto* boolean = dynamic_cast<const ast::BoolConst*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::BoolConst));
+                    WriteU8(boolean->GetValue().GetValue() ? 1 : 0);
+                    return;
+                }
+                if (const auto* var = dynamic_cast<const ast::VariableValue*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::VariableValue));
+                    WriteVariable(*var);
+                    return;
+                }
+                if (const auto* assign = dynamic_cast<const ast::Assignment*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::Assignment));
+                    WriteSymbol(assign->GetName());
+                    WriteSlot(assign->GetSlot());
+                    WriteNode(assign->GetValue().get(), depth);
+                    return;
+                }
+                if (const auto* field_assign = dynamic_cast<const ast::FieldAssignment*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::FieldAssignment));
+                    WriteVariable(field_assign->GetObject());
+                    WriteSymbol(field_assign->GetFieldName());
+                    WriteNode(field_assign->GetValue().get(), depth);
+                    return;
+                }
+                if (dynamic_cast<const ast::None*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::None));
+                    return;
+                }
+                if (const auto* print = dynamic_cast<const ast::Print*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::Print));
+                    WriteNode(print->GetArgument().get(), depth);
+                    WriteNodes(print->GetArgs(), depth);
+                    return;
+                }
+                if (const auto* call = dynamic_cast<const ast::MethodCall*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::MethodCall));
+                    WriteNode(call->GetObject().get(), depth);
+                    WriteSymbol(call->GetMethod());
+                    WriteNodes(call->GetArgs(), depth);
+                    return;
+                }
+                if (const auto* new_instance = dynamic_cast<const ast::NewInstance*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::NewInstance));
+                    WriteClassIndex(new_instance->GetClass());
+                    WriteNodes(new_instance->GetArgs(), depth);
+                    return;
+                }
+                if (const auto* stringify = dynamic_cast<const ast::Stringify*>(node)) {
+                    WriteUnary(Tag::Stringify, *stringify, depth);
+                    return;
+                }
+                if (const auto* negation = dynamic_cast<const ast::Not*>(node)) {
+                    WriteUnary(Tag::Not, *negation, depth);
+                    return;
+                }
+                if (const auto* add = dynamic_cast<const ast::Add*>(node)) {
+                    WriteBinary(Tag::Add, *add, depth);
+                    return;
+                }
+                if (const auto* sub = dynamic_cast<const ast::Sub*>(node)) {
+                    WriteBinary(Tag::Sub, *sub, depth);
+                    return;
+                }
+                if (const auto* mult = dynamic_cast<const ast::Mult*>(node)) {
+                    WriteBinary(Tag::Mult, *mult, depth);
+                    return;
+                }
+                if (const auto* div = dynamic_cast<const ast::Div*>(node)) {
+                    WriteBinary(Tag::Div, *div, depth);
+                    return;
+                }
+                if (const auto* disjunction = dynamic_cast<const ast::Or*>(node)) {
+                    WriteBinary(Tag::Or, *disjunction, depth);
+                    return;
+                }
+                if (const auto* conjunction = dynamic_cast<const ast::And*>(node)) {
+                    WriteBinary(Tag::And, *conjunction, depth);
+                    return;
+                }
+                if (const auto* cmp = dynamic_cast<const ast::Comparison*>(node)) {
+                    WriteBinary(Tag::Comparison, *cmp, depth);
+                    WriteU8(static_cast<uint8_t>(cmp->GetComparator()));
+                    return;
+                }
+                if (const auto* compound = dynamic_cast<const ast::Compound*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::Compound));
+                    WriteNodes(compound->GetStatements(), depth);
+                    return;
+                }
+                if (const auto* body = dynamic_cast<const ast::MethodBody*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::MethodBody));
+                    WriteNode(body->GetBody().get(), depth);
+                    return;
+                }
+                if (const auto* ret = dynamic_cast<const ast::Return*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::Return));
+                    WriteNode(ret->GetStatement().get(), depth);
+                    return;
+                }
+                if (const auto* class_def = dynamic_cast<const ast::ClassDefinition*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::ClassDefinition));
+                    WriteClassIndex(*AsClass(class_def->GetClass()));
+                    return;
+                }
+                if (const auto* if_else = dynamic_cast<const ast::IfElse*>(node)) {
+                    WriteU8(static_cast<uint8_t>(Tag::IfElse));
+                    WriteNode(if_else->GetCondition().get(), depth);
+                    WriteNode(if_else->GetIfBody().get(), depth);
+                    WriteNode(if_else->GetElseBody().get(), depth);
+                    return;
+                }
+                throw ProgramCacheError("Program holds a node with no image record"s);
+            }
+
+            void WriteVariable(const ast::VariableValue& var) {
+                WriteSymbols(var.GetDottedIds());
+                WriteSlot(var.GetSlot());
+            }
+
+            // Classes in the order the parser created them: a class after every class
+            // defined in its methods, which is after its parent and the classes it instantiates
+            void CollectClasses(const ast::Statement& node, size_t depth) {
+                if (++depth > MAX_DEPTH) {
+                    throw ProgramCacheError("Program nests too deeply for an image"s);
+                }
+                if (const auto* class_def = dynamic_cast<const ast::ClassDefinition*>(&node)) {
+                    const runtime::Class* cls = AsClass(class_def->GetClass());
+                    if (!cls || class_indices_.count(cls)) {
+                        throw ProgramCacheError("Malformed class definition"s);
+                    }
+                    for (const runtime::Method& method : cls->GetMethods()) {
+                        CollectClasses(*method.body, depth);
+                    }
+                    if (cls->GetParent() && !class_indices_.count(cls->GetParent())) {
+                        throw ProgramCacheError("Base class of "s + cls->GetName() + " is not declared by the program"s);
+                    }
+                    class_indices_.emplace(cls, static_cast<uint32_t>(classes_.size()));
+                    classes_.push_back(cls);
+                    return;
+                }
+                ForEachChild(node, [this, depth](const ast::Statement& child) {
+                    CollectClasses(child, depth);
+                });
+            }
+
+            template <typename Visit>
+            static void ForEachChild(const ast::Statement& node, Visit visit) {
+                auto visit_all = [&visit](const vector<unique_ptr<ast::Statement>>& nodes) {
+                    for (const auto& child : nodes) {
+                        visit(*child);
+                    }
+                };
+                if (const auto* assign = dynamic_cast<const ast::Assignment*>(&node)) {
+                    visit(*assign->GetValue());
+                }
+                else if (const auto* field_assign = dynamic_cast<const ast::FieldAssignment*>(&node)) {
+                    visit(*field_assign->GetValue());
+                }
+                else if (const auto* print = dynamic_cast<const ast::Print*>(&node)) {
+                    if (print->GetArgument()) {
+                        visit(*print->GetArgument());
+                    }
+                    visit_all(print->GetArgs());
+                }
+                else if (const auto* call = dynamic_cast<const ast::MethodCall*>(&node)) {
+                    visit(*call->GetObject());
+                    visit_all(call->GetArgs());
+                }
+                else if (const auto* new_instance = dynamic_cast<const ast::NewInstance*>(&node)) {
+                    visit_all(new_instance->GetArgs());
+                }
+                else if (const auto* unary = dynamic_cast<const ast::UnaryOperation*>(&node)) {
+                    visit(*unary->GetArgument());
+                }
+                else if (const auto* binary = dynamic_cast<const ast::BinaryOperation*>(&node)) {
+                    visit(*binary->GetLhs());
+                    visit(*binary->GetRhs());
+                }
+                else if (const auto* compound = dynamic_cast<const ast::Compound*>(&node)) {
+                    visit_all(compound->GetStatements());
+                }
+                else if (const auto* body = dynamic_cast<const ast::MethodBody*>(&node)) {
+                    visit(*body->GetBody());
+                }
+                else if (const auto* ret = dynamic_cast<const ast::Return*>(&node)) {
+                    if (ret->GetStatement()) {
+                        visit(*ret->GetStatement());
+                    }
+                }
+                else if (const auto* if_else = dynamic_cast<const ast::IfElse*>(&node)) {
+                    visit(*if_else->GetCondition());
+                    visit(*if_else->GetIfBody());
+                    if (if_else->GetElseBody()) {
+                        visit(*if_else->GetElseBody());
+                    }
+                }
+            }
+
+            string body_;
+            vector<runtime::Symbol> symbols_;
+            unordered_map<runtime::Symbol, uint32_t> symbol_indices_;
+            size_t symbol_bytes_ = 0;
+            vector<const runtime::Class*> classes_;
+            unordered_map<const runtime::Class*, uint32_t> class_indices_;
+        };
+
+        class ImageReader {
+        public:
+            explicit ImageReader(string_view image)
+                : image_(image) {
+            }
+
+            unique_ptr<runtime::Executable> Read(SourceKey key) {
+                if (ReadBytes(MAGIC.size()) != MAGIC) {
+                    throw ProgramCacheError("Not a program image"s);
+                }
+                if (ReadU32() != PROGRAM_IMAGE_VERSION) {
+                    throw ProgramCacheError("Program image of another version"s);
+                }
+                const uint64_t hash = ReadU64();
+                const uint64_t check = ReadU64();
+                const uint64_t size = ReadU64();
+                if (hash != key.hash || check != key.check || size != key.size) {
+                    throw ProgramCacheError("Program image of another source"s);
+                }
+
+                const size_t symbol_count = ReadCount(4);
+                symbols_.reserve(symbol_count);
+                for (size_t i = 0; i < symbol_count; ++i) {
+                    symbols_.emplace_back(ReadBytes(ReadU32()));
+                }
+
+                const size_t class_count = ReadCount(12);
+                classes_.reserve(class_count);
+                for (size_t i = 0; i < class_count; ++i) {
+                    ReadClass();
+                }
+
+                auto program = ReadNode(0, 0);
+                if (pos_ != image_.size()) {
+                    throw ProgramCacheError("Program image has trailing bytes"s);
+                }
+                if (!program) {
+                    throw ProgramCacheError("Program image has no program"s);
+                }
+                // Only ClassDefinition nodes own classes; instances and child classes only refer to them
+                if (find(defined_.begin(), defined_.end(), false) != defined_.end()) {
+                    throw ProgramCacheError("Program image has a class that it never defines"s);
+                }
+                return program;
+            }
+
+        private:
+            string_view ReadBytes(size_t count) {
+                if (image_.size() - pos_ < count) {
+                    throw ProgramCacheError("Program image is truncated"s);
+                }
+                const string_view result = image_.substr(pos_, count);
+                pos_ += count;
+                return result;
+            }
+
+            uint8_t ReadU8() {
+                return static_cast<uint8_t>(ReadBytes(1).front());
+            }
+
+            uint32_t ReadU32() {
+                const string_view bytes = ReadBytes(4);
+                uint32_t value = 0;
+                for (int i = 3; i >= 0; --i) {
+                    value = (value << 8) | static_cast<uint8_t>(bytes[static_cast<size_t>(i)]);
+                }
+                return value;
+            }
+
+            uint64_t ReadU64() {
+                const uint64_t low = ReadU32();
+                return low | (static_cast<uint64_t>(ReadU32()) << 32);
+            }
+
+            // A count of elements that take at least min_bytes each, so that a corrupt count
+            // cannot make the reader reserve more than the image could hold
+            size_t ReadCount(size_t min_bytes) {
+                const size_t count = ReadU32();
+                if (count > (image_.size() - pos_) / min_bytes) {
+                    throw ProgramCacheError("Program image is truncated"s);
+                }
+                return count;
+            }
+
+            runtime::Symbol ReadSymbol() {
+                const uint32_t index = ReadU32();
+                if (index >= symbols_.size()) {
+                    throw ProgramCacheError("Program image refers to a missing symbol"s);
+                }
+                return symbols_[index];
+            }
+
+            vector<runtime::Symbol> ReadSymbols() {
+                vector<runtime::Symbol> result(ReadCount(4));
+                for (runtime::Symbol& symbol : result) {
+                    symbol = ReadSymbol();
+                }
+                return result;
+            }
+
+            size_t ReadSlot(size_t frame_size) {
+                const uint32_t slot = ReadU32();
+                if (slot == NO_INDEX) {
+                    return ast::NO_SLOT;
+                }
+                if (slot >= frame_size) {
+                    throw ProgramCacheError("Program image has a slot outside of its frame"s);
+                }
+                return slot;
+            }
+
+            uint32_t ReadClassNumber() {
+                const uint32_t index = ReadU32();
+                if (index >= classes_.size()) {
+                    throw ProgramCacheError("Program image refers to a missing class"s);
+                }
+                return index;
+            }
+
+            const runtime::ObjectHolder& ReadClassIndex() {
+                return classes_[ReadClassNumber()];
+            }
+
+            void ReadClass() {
+                const runtime::Symbol name = ReadSymbol();
+                const uint32_t parent_index = ReadU32();
+                if (parent_index > classes_.size()) {
+                    throw ProgramCacheError("Program image refers to a missing class"s);
+                }
+                const runtime::Class* parent = parent_index != 0 ? AsClass(classes_[parent_index - 1]) : nullptr;
+
+                vector<runtime::Method> methods(ReadCount(13));
+                for (runtime::Method& method : methods) {
+                    method.name = ReadSymbol();
+                    method.formal_params = ReadSymbols();
+                    method.frame_size = ReadU32();
+                    if (method.frame_size > MAX_FRAME_SIZE
+                        || (method.frame_size != 0 && method.frame_size <= method.formal_params.size())) {
+                        throw ProgramCacheError("Program image has a malformed method frame"s);
+                    }
+                    method.body = ReadNode(0, method.frame_size);
+                    if (!method.body) {
+                        throw ProgramCacheError("Program image has a method without a body"s);
+                    }
+                }
+                classes_.push_back(runtime::ObjectHolder::Own(runtime::Class(name.GetName(), std::move(methods), parent)));
+                defined_.push_back(false);
+            }
+
+            vector<unique_ptr<ast::Statement>> ReadNodes(size_t depth, size_t frame_size) {
+                vector<unique_ptr<ast::Statement>> result(ReadCount(1));
+                for (auto& node : result) {
+                    node = ReadRequiredNode(depth, frame_size);
+                }
+                return result;
+            }
+
+            unique_ptr<ast::Statement> ReadRequiredNode(size_t depth, size_t frame_size) {
+                auto node = ReadNode(depth, frame_size);
+                if (!node) {
+                    throw ProgramCacheError("Program image lacks a required node"s);
+                }
+                return node;
+            }
+
+            ast::VariableValue ReadVariable(size_t frame_size) {
+                vector<runtime::Symbol> dotted_ids = ReadSymbols();
+                if (dotted_ids.empty()) {
+                    throw ProgramCacheError("Program image has a variable without a name"s);
+                }
+                ast::VariableValue var(std::move(dotted_ids));
+                var.SetSlot(ReadSlot(frame_size));
+                return var;
+            }
+
+            template <typename Node>
+            unique_ptr<ast::Statement> ReadBinary(size_t depth, size_t frame_size) {
+                auto lhs = ReadRequiredNode(depth, frame_size);
+                auto rhs = ReadRequiredNode(depth, frame_size);
+                return make_unique<Node>(std::move(lhs), std::move(rhs));
+            }
+
+            unique_ptr<ast::Statement> ReadNode(size_t depth, size_t frame_size) {
+                if (++depth > MAX_DEPTH) {
+                    throw ProgramCacheError("Program image nests too deeply"s);
+                }
+                const auto tag = static_cast<Tag>(ReadU8());
+                if (tag == Tag::Absent) {
+                    return nullptr;
+                }
+                auto node = ReadRecord(tag, depth, frame_size);
+                parse::SourceSpan span;
+                span.begin.line = ReadU32();
+                span.begin.column = ReadU32();
+                span.end.line = ReadU32();
+                span.end.column = ReadU32();
+                node->SetSpan(span);
+                return node;
+            }
+
+            unique_ptr<ast::Statement> ReadRecord(Tag tag, size_t depth, size_t frame_size) {
+                switch (tag) {
+                case Tag::Absent:
+                    break;
+                case Tag::NumericConst:
+                    return make_unique<ast::NumericConst>(static_cast<int>(ReadU32()));
+                case Tag::StringConst:
+                    return make_unique<ast::StringConst>(string(ReadBytes(ReadU32())));
+                case Tag::BoolConst:
+                    return make_unique<ast::BoolConst>(ReadU8() != 0);
+                case Tag::VariableValue:
+                    return make_unique<ast::VariableValue>(ReadVariable(frame_size));
+                case Tag::Assignment: {
+                    const runtime::Symbol name = ReadSymbol();
+                    const size_t slot = ReadSlot(frame_size);
+                    auto assign = make_unique<ast::Assignment>(name, ReadRequiredNode(depth, frame_size));
+                    assign->SetSlot(slot);
+                    return assign;
+                }
+                case Tag::FieldAssignment: {
+                    ast::VariableValue object = ReadVariable(frame_size);
+                    const runtime::Symbol field_name = ReadSymbol();
+                    return make_unique<ast::FieldAssignment>(std::move(object), field_name,
+                        ReadRequiredNode(depth, frame_size));
+                }
+                case Tag::None:
+                    return make_unique<ast::None>();
+                case Tag::Print: {
+                    auto argument = ReadNode(depth, frame_size);
+                    auto args = ReadNodes(depth, frame_size);
+                    if (argument) {
+                        return make_unique<ast::Print>(std::move(argument));
+                    }
+                    return make_unique<ast::Print>(std::move(args));
+                }
+                case Tag::MethodCall: {
+                    auto object = ReadRequiredNode(depth, frame_size);
+                    const runtime::Symbol method = ReadSymbol();
+                    return make_unique<ast::MethodCall>(std::move(object), method, ReadNodes(depth, frame_size));
+                }
+                case Tag::NewInstance: {
+                    const runtime::Class& cls = *AsClass(ReadClassIndex());
+                    return make_unique<ast::NewInstance>(cls, ReadNodes(depth, frame_size));
+                }
+                case Tag::Stringify:
+                    return make_unique<ast::Stringify>(ReadRequiredNode(depth, frame_size));
+                case Tag::Not:
+                    return make_unique<ast::Not>(ReadRequiredNode(depth, frame_size));
+                case Tag::Add:
+                    return ReadBinary<ast::Add>(depth, frame_size);
+                case Tag::Sub:
+                    return ReadBinary<ast::Sub>(depth, frame_size);
+                case Tag::Mult:
+                    return ReadBinary<ast::Mult>(depth, frame_size);
+                case Tag::Div:
+                    return ReadBinary<ast::Div>(depth, frame_size);
+                case Tag::Or:
+                    return ReadBinary<ast::Or>(depth, frame_size);
+                case Tag::And:
+                    return ReadBinary<ast::And>(depth, frame_size);
+                case Tag::Comparison: {
+                    auto lhs = ReadRequiredNode(depth, frame_size);
+                    auto rhs = ReadRequiredNode(depth, frame_size);
+                    const uint8_t comparator = ReadU8();
+                    if (comparator > static_cast<uint8_t>(runtime::Comparator::GreaterOrEqual)) {
+                        throw ProgramCacheError("Program image has an unknown comparison"s);
+                    }
+                    return ast::Comparison::Make(static_cast<runtime::Comparator>(comparator), std::move(lhs), std::move(rhs));
+                }
+                case Tag::Compound: {
+                    auto compound = make_unique<ast::Compound>();
+                    for (auto& stmt : ReadNodes(depth, frame_size)) {
+                        compound->AddStatement(std::move(stmt));
+                    }
+                    return compound;
+                }
+                case Tag::MethodBody:
+                    return make_unique<ast::MethodBody>(ReadRequiredNode(depth, frame_size));
+                case Tag::Return:
+                    return make_unique<ast::Return>(ReadRequiredNode(depth, frame_size));
+                case Tag::ClassDefinition: {
+                    const uint32_t index = ReadClassNumber();
+                    defined_[index] = true;
+                    return make_unique<ast::ClassDefinition>(classes_[index]);
+                }
+                case Tag::IfElse: {
+                    auto condition = ReadRequiredNode(depth, frame_size);
+                    auto if_body = ReadRequiredNode(depth, frame_size);
+                    auto else_body = ReadNode(depth, frame_size);
+                    return make_unique<ast::IfElse>(std::move(condition), std::move(if_body), std::move(else_body));
+                }
+                }
+                throw ProgramCacheError("Program image has an unknown node"s);
+            }
+
+            string_view image_;
+            size_t pos_ = 0;
+            vector<runtime::Symbol> symbols_;
+            vector<runtime::ObjectHolder> classes_;
+            // Whether a ClassDefinition record took each of classes_
+            vector<bool> defined_;
+        };
+    }  // namespace
+
+    SourceKey MakeSourceKey(std::string_view source) {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        uint64_t check = 0;
+        for (const char c : source) {
+            hash = (hash ^ static_cast<uint8_t>(c)) * 0x100000001b3ULL;
+            check = check * 0x9E3779B97F4A7C15ULL + static_cast<uint8_t>(c) + 1;
+        }
+        // splitmix64 finalizer, so that every byte of the check depends on every byte of the source
+        check = (check ^ (check >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        check = (check ^ (check >> 27)) * 0x94D049BB133111EBULL;
+        check ^= check >> 31;
+        return { hash, check, source.size() };
+    }
+
+    std::string SerializeProgram(const runtime::Executable& program, SourceKey key) {
+        return ImageWriter{}.Write(program, key);
+    }
+
+    std::unique_ptr<runtime::Executable> DeserializeProgram(std::string_view image, SourceKey key) {
+        // Same as for a parsed program: the nodes share one arena
+        runtime::ArenaScope arena;
+        return ImageReader{ image }.Read(key);
+    }
+
+    ProgramCache::ProgramCache(std::string directory)
+        : directory_(std::move(directory)) {
+    }
+
+    std::unique_ptr<runtime::Executable> ProgramCache::Load(std::string_view source) {
+        const SourceKey key = MakeSourceKey(source);
+        try {
+            const SourceFile entry(GetEntryPath(key));
+            auto program = DeserializeProgram(entry.GetContents(), key);
+            ++stats_.hits;
+            return program;
+        }
+        catch (const SourceFileError&) {
+        }
+        catch (const ProgramCacheError&) {
+            // A stale or damaged entry is replaced below
+        }
+
+        ++stats_.misses;
+        Lexer lexer(source);
+        auto program = ParseProgram(lexer);
+        Store(*program, key);
+        return program;
+    }
+
+    std::string ProgramCache::GetEntryPath(SourceKey key) const {
+        static constexpr char DIGITS[] = "0123456789abcdef";
+        string name(16, '0');
+        for (size_t i = 0; i < name.size(); ++i) {
+            name[name.size() - 1 - i] = DIGITS[(key.hash >> (4 * i)) & 0xF];
+        }
+        return (filesystem::path(directory_) / (name + ".mpc"s)).string();
+    }
+
+    void ProgramCache::Store(const runtime::Executable& program, SourceKey key) const {
+        string image;
+        try {
+            image = SerializeProgram(program, key);
+        }
+        catch (const ProgramCacheError&) {
+            return;
+        }
+
+        // Readers only ever see complete images: the image goes to a file of its own first
+        // and is then renamed over the entry
+        error_code error;
+        filesystem::create_directories(directory_, error);
+        const string path = GetEntryPath(key);
+        const string temporary = path + ".tmp"s + to_string(random_device{}());
+        {
+            ofstream output(temporary, ios::binary | ios::trunc);
+            if (!output.write(image.data(), static_cast<streamsize>(image.size())) || !output.flush()) {
+                output.close();
+                filesystem::remove(temporary, error);
+                return;
+            }
+        }
+        filesystem::rename(temporary, path, error);
+        if (error) {
+            filesystem::remove(temporary, error);
+        }
+    }
+
+}  // namespace parse
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace runtime {
+    class Executable;
+}
+
+namespace parse {
+
+    class ProgramCacheError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Layout version of program images; bump it on any change to the layout or to what a node means
+    inline constexpr std::uint32_t PROGRAM_IMAGE_VERSION = 3;
+
+    // Identifies the script text an image was made from. The hash names the cache entry; the
+    // check, computed independently of it, makes an entry of another source that shares the hash
+    // and the size a miss instead of running the wrong program
+    struct SourceKey {
+        std::uint64_t hash = 0;   // 64-bit FNV-1a
+        std::uint64_t check = 0;  // polynomial hash with a 64-bit mix at the end
+        std::uint64_t size = 0;
+    };
+
+    [[nodiscard]] SourceKey MakeSourceKey(std::string_view source);
+
+    // Flat image of a program returned by ParseProgram: a symbol table, the classes the program
+    // declares with their methods, then the top-level statements. Throws ProgramCacheError for
+    // trees with nodes the format has no record for or that nest too deeply
+    [[nodiscard]] std::string SerializeProgram(const runtime::Executable& program, SourceKey key);
+
+    // Rebuilds a program from its image. The image holds no pointers and every read is checked
+    // against its bounds, so it can come straight from a mapped file; a truncated or corrupt
+    // image, one of another version or of another source throws ProgramCacheError
+    std::unique_ptr<runtime::Executable> DeserializeProgram(std::string_view image, SourceKey key);
+
+    // Directory of program images named after the key of their source. Not thread-safe
+    class ProgramCache {
+    public:
+        struct Stats {
+            size_t hits = 0;
+            size_t misses = 0;
+        };
+
+        explicit ProgramCache(std::string directory);
+
+        // Program of the script text, loaded from the directory when it holds a valid image of it.
+        // Otherwise the source is parsed and its image is written; parse errors propagate as from
+        // ParseProgram, and a directory that cannot be written to only costs the next warm start
+        std::unique_ptr<runtime::Executable> Load(std::string_view source);
+
+        [[nodiscard]] std::string GetEntryPath(SourceKey key) const;
+
+        [[nodiscard]] const Stats& GetStats() const {
+            return stats_;
+        }
+
+    private:
+        void Store(const runtime::Executable& program, SourceKey key) const;
+
+        std::string directory_;
+        Stats stats_;
+    };
+
+}  // namespace parse
@@ -0,0 +1,99 @@
+#include "lexer.h"
+#include "parse.h"
+#include "program_cache.h"
+#include "runtime.h"
+
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+using namespace std;
+using namespace std::literals;
+
+// Cold and warm start of a script with many classes through a ProgramCache: the
+// cold start lexes, parses and writes the image, the warm one maps the image and
+// rebuilds the program from it. Then the same two paths without the file system.
+// Build with -O2 and run without arguments.
+
+namespace {
+
+    constexpr int CLASSES = 5000;
+    constexpr int RUNS = 5;
+
+    string MakeScript() {
+        string script;
+        for (int i = 0; i < CLASSES; ++i) {
+            const string n = to_string(i);
+            const string base = i == 0 ? ""s : "(Item"s + to_string(i - 1) + ')';
+            script += "class Item"s + n + base + ":\n"s;
+            script += "  def __init__(value, name):\n"s;
+            script += "    self.value = value * "s + n + " + 17\n"s;
+            script += "    self.name = 'item "s + n + "'\n"s;
+            script += "  def scaled(factor):\n"s;
+            script += "    result = self.value * factor\n"s;
+            script += "    if result >= 100 and not result == 200:\n"s;
+            script += "      return result - 100\n"s;
+            script += "    return result\n"s;
+            script += "  def __str__():\n"s;
+            script += "    return self.name + ': ' + str(self.scaled(2))\n\n"s;
+        }
+        script += "x = Item"s + to_string(CLASSES - 1) + "(3, \"x\")\nprint x\n"s;
+        return script;
+    }
+
+    template <typename Action>
+    double BestMs(Action action) {
+        double best_ms = 0;
+        for (int run = 0; run < RUNS; ++run) {
+            const auto start = chrono::steady_clock::now();
+            action();
+            const chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+            if (run == 0 || elapsed.count() < best_ms) {
+                best_ms = elapsed.count();
+            }
+        }
+        return best_ms;
+    }
+
+}  // namespace
+
+int main() {
+    const string script = MakeScript();
+    const filesystem::path directory = filesystem::temp_directory_path() / "mython_cache_bench"s;
+
+    const double cold_ms = BestMs([&]() {
+        filesystem::remove_all(directory);
+        parse::ProgramCache cache(directory.string());
+        cache.Load(script);
+    });
+    const double warm_ms = BestMs([&]() {
+        parse::ProgramCache cache(directory.string());
+        cache.Load(script);
+    });
+    const auto image_size = filesystem::file_size(
+        parse::ProgramCache(directory.string()).GetEntryPath(parse::MakeSourceKey(script)));
+    filesystem::remove_all(directory);
+
+    cout << CLASSES << " classes, "sv << script.size() / 1024 << " KiB of source, "sv
+         << image_size / 1024 << " KiB image"sv << endl;
+    cout << "cold start (parse and store): "sv << cold_ms << " ms"sv << endl;
+    cout << "warm start (map and load): "sv << warm_ms << " ms"sv << endl;
+
+    const parse::SourceKey key = parse::MakeSourceKey(script);
+    string image;
+    const double parse_ms = BestMs([&]() {
+        parse::Lexer lexer(string_view{ script });
+        image = parse::SerializeProgram(*ParseProgram(lexer), key);
+    });
+    const double load_ms = BestMs([&]() {
+        parse::DeserializeProgram(image, key);
+    });
+    uint64_t hash_sink = 0;
+    const double hash_ms = BestMs([&]() {
+        hash_sink += parse::MakeSourceKey(script).hash;
+    });
+    cout << "in memory, parse and serialize: "sv << parse_ms << " ms"sv << endl;
+    cout << "in memory, deserialize: "sv << load_ms << " ms"sv << endl;
+    cout << "source key: "sv << hash_ms << " ms"sv << " ("sv << (hash_sink & 1) << ")"sv << endl;
+}
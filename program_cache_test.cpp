@@ -0,0 +1,173 @@
+#include "lexer.h"
+#include "parse.h"
+#include "program_cache.h"
+#include "statement.h"
+
+#include "test_runner_p.h"
+
+#include <filesystem>
+#include <fstream>
+
+using namespace std;
+
+namespace parse {
+
+    namespace {
+        const string PROGRAM = R"(
+class Shape:
+  def __init__(name):
+    self.name = name
+
+  def area():
+    return 0
+
+  def __str__():
+    return self.name + ' of area ' + str(self.area())
+
+class Rect(Shape):
+  def __init__(w, h):
+    self.name = 'rect'
+    self.w = w
+    self.h = h
+
+  def area():
+    return self.w * self.h
+
+class Factory:
+  def make(n):
+    class Local:
+      def get():
+        return 'local'
+    if n > 2 and not n == 5 or n <= 0:
+      return Rect(n, n - 1)
+    else:
+      return Shape("shape")
+
+f = Factory()
+shapes = None
+r = f.make(-4)
+print f.make(3), f.make(1), r.area() / 2 >= 0, 7 / 2 != 3, True
+x = "done"
+print x
+)"s;
+
+        string Run(runtime::Executable& program) {
+            runtime::DummyContext context;
+            runtime::Closure closure;
+            program.Execute(closure, context);
+            return context.output.str();
+        }
+
+        unique_ptr<runtime::Executable> Parse(string_view source) {
+            Lexer lexer(source);
+            return ParseProgram(lexer);
+        }
+    }  // namespace
+
+    void TestProgramImageRoundTrip() {
+        const SourceKey key = MakeSourceKey(PROGRAM);
+        auto parsed = Parse(PROGRAM);
+        const string image = SerializeProgram(*parsed, key);
+
+        auto loaded = DeserializeProgram(image, key);
+        ASSERT_EQUAL(Run(*loaded), Run(*parsed));
+        ASSERT_EQUAL(SerializeProgram(*loaded, key), image);
+        // Source spans come along, for the profiler
+        ASSERT_EQUAL(loaded->GetSpan().begin.line, 2U);
+        ASSERT_EQUAL(loaded->GetSpan().end.line, parsed->GetSpan().end.line);
+    }
+
+    void TestDamagedProgramImages() {
+        const SourceKey key = MakeSourceKey(PROGRAM);
+        const string image = SerializeProgram(*Parse(PROGRAM), key);
+
+        for (size_t size = 0; size < image.size(); ++size) {
+            ASSERT_THROWS(DeserializeProgram(string_view(image).substr(0, size), key), ProgramCacheError);
+        }
+        ASSERT_THROWS(DeserializeProgram(image + '\0', key), ProgramCacheError);
+        ASSERT_THROWS(DeserializeProgram(image, MakeSourceKey(PROGRAM + "\n"s)), ProgramCacheError);
+        // Another source with the same hash and size still differs in the check
+        ASSERT_THROWS(DeserializeProgram(image, SourceKey{ key.hash, ~key.check, key.size }), ProgramCacheError);
+
+        string other_version = image;
+        ++other_version[4];
+        ASSERT_THROWS(DeserializeProgram(other_version, key), ProgramCacheError);
+
+        // Any other damage is either caught or yields some program; it is never read out of bounds
+        for (size_t i = 0; i < image.size(); ++i) {
+            string damaged = image;
+            damaged[i] = static_cast<char>(~damaged[i]);
+            try {
+                auto program = DeserializeProgram(damaged, key);
+                ASSERT(program != nullptr);
+            }
+            catch (const ProgramCacheError&) {
+            }
+        }
+    }
+
+    void TestImageWithUndefinedClass() {
+        const string source = "class A:\n  def f():\n    return 1\nclass B(A):\n  def g():\n    return 2\nprint B()\n"s;
+        const SourceKey key = MakeSourceKey(source);
+        const string image = SerializeProgram(*Parse(source), key);
+        ASSERT(DeserializeProgram(image, key) != nullptr);
+
+        // The ClassDefinition records of A and B (tag 22, class index, span from their line) turned
+        // into NumericConst records of the same size. B's parent, then the new instance of B, would
+        // refer to a class that nothing in the program owns
+        for (const string& record : { "\x16\0\0\0\0\x01\0\0\0"s, "\x16\x01\0\0\0\x04\0\0\0"s }) {
+            string damaged = image;
+            const size_t pos = damaged.find(record);
+            ASSERT(pos != string::npos);
+            damaged[pos] = '\x01';
+            ASSERT_THROWS(DeserializeProgram(damaged, key), ProgramCacheError);
+        }
+    }
+
+    void TestProgramCacheDirectory() {
+        const filesystem::path directory = filesystem::temp_directory_path()
+            / ("mython_cache_test_"s + to_string(MakeSourceKey(PROGRAM).hash));
+        filesystem::remove_all(directory);
+
+        const string expected = Run(*Parse(PROGRAM));
+        {
+            ProgramCache cache(directory.string());
+            ASSERT_EQUAL(Run(*cache.Load(PROGRAM)), expected);
+            ASSERT_EQUAL(Run(*cache.Load(PROGRAM)), expected);
+            ASSERT_EQUAL(cache.GetStats().misses, 1U);
+            ASSERT_EQUAL(cache.GetStats().hits, 1U);
+            ASSERT(filesystem::exists(cache.GetEntryPath(MakeSourceKey(PROGRAM))));
+        }
+        {
+            // A damaged entry is parsed over and replaced
+            ProgramCache cache(directory.string());
+            ofstream(cache.GetEntryPath(MakeSourceKey(PROGRAM)), ios::binary | ios::trunc) << "MYPC"s;
+            ASSERT_EQUAL(Run(*cache.Load(PROGRAM)), expected);
+            ASSERT_EQUAL(Run(*cache.Load(PROGRAM)), expected);
+            ASSERT_EQUAL(cache.GetStats().misses, 1U);
+            ASSERT_EQUAL(cache.GetStats().hits, 1U);
+
+            ASSERT_THROWS(cache.Load("print Unknown()\n"sv), ParseError);
+        }
+        {
+            // The entry of another source whose hash and size collide with it is a miss, not its program
+            const SourceKey key = MakeSourceKey(PROGRAM);
+            ProgramCache cache(directory.string());
+            ofstream(cache.GetEntryPath(key), ios::binary | ios::trunc)
+                << SerializeProgram(*Parse("print 1\n"sv), SourceKey{ key.hash, ~key.check, key.size });
+            ASSERT_EQUAL(Run(*cache.Load(PROGRAM)), expected);
+            ASSERT_EQUAL(cache.GetStats().misses, 1U);
+            ASSERT_EQUAL(cache.GetStats().hits, 0U);
+        }
+
+        filesystem::remove_all(directory);
+    }
+
+    void RunProgramCacheTests(TestRunner& tr) {
+        RUN_TEST(tr, parse::TestProgramImageRoundTrip);
+        RUN_TEST(tr, parse::TestDamagedProgramImages);
+        RUN_TEST(tr, parse::TestImageWithUndefinedClass);
+        RUN_TEST(tr, parse::TestProgramCacheDirectory);
+    }
+
+}  // namespace parse
@@ -0,0 +1,107 @@
+#include "resolve.h"
+
+#include "statement.h"
+
+#include <unordered_map>
+
+using namespace std;
+
+namespace ast {
+
+    namespace {
+        class SlotResolver {
+        public:
+            bool Collect(Statement& node) {
+                if (dynamic_cast<NumericConst*>(&node) || dynamic_cast<StringConst*>(&node)
+                    || dynamic_cast<BoolConst*>(&node) || dynamic_cast<None*>(&node)) {
+                    return true;
+                }
+                if (auto* var = dynamic_cast<VariableValue*>(&node)) {
+                    reads_.push_back(var);
+                    return true;
+                }
+                if (auto* assign = dynamic_cast<Assignment*>(&node)) {
+                    writes_.push_back(assign);
+                    return Collect(*assign->GetValue());
+                }
+                if (auto* field_assign = dynamic_cast<FieldAssignment*>(&node)) {
+                    reads_.push_back(&field_assign->GetObject());
+                    return Collect(*field_assign->GetValue());
+                }
+                if (auto* print = dynamic_cast<Print*>(&node)) {
+                    // Print::Variable looks its argument up by name at run time
+                    return !print->GetArgument() && CollectAll(print->GetArgs());
+                }
+                if (auto* call = dynamic_cast<MethodCall*>(&node)) {
+                    return Collect(*call->GetObject()) && CollectAll(call->GetArgs());
+                }
+                if (auto* new_instance = dynamic_cast<NewInstance*>(&node)) {
+                    return CollectAll(new_instance->GetArgs());
+                }
+                if (auto* unary = dynamic_cast<UnaryOperation*>(&node)) {
+                    return Collect(*unary->GetArgument());
+                }
+                if (auto* binary = dynamic_cast<BinaryOperation*>(&node)) {
+                    return Collect(*binary->GetLhs()) && Collect(*binary->GetRhs());
+                }
+                if (auto* compound = dynamic_cast<Compound*>(&node)) {
+                    return CollectAll(compound->GetStatements());
+                }
+                if (auto* body = dynamic_cast<MethodBody*>(&node)) {
+                    return Collect(*body->GetBody());
+                }
+                if (auto* ret = dynamic_cast<Return*>(&node)) {
+                    return Collect(*ret->GetStatement());
+                }
+                if (auto* if_else = dynamic_cast<IfElse*>(&node)) {
+                    return Collect(*if_else->GetCondition()) && Collect(*if_else->GetIfBody())
+                        && (!if_else->GetElseBody() || Collect(*if_else->GetElseBody()));
+                }
+                // ClassDefinition and foreign Executables touch the closure by name
+                return false;
+            }
+
+            bool Resolve(runtime::Method& method) {
+                slots_["self"] = 0;
+                for (runtime::Symbol param : method.formal_params) {
+                    if (!slots_.emplace(param, slots_.size()).second) {
+                        return false;
+                    }
+                }
+                if (!Collect(*method.body)) {
+                    return false;
+                }
+                for (Assignment* assign : writes_) {
+                    const auto it = slots_.emplace(assign->GetName(), slots_.size()).first;
+                    assign->SetSlot(it->second);
+                }
+                for (VariableValue* var : reads_) {
+                    if (const auto it = slots_.find(var->GetDottedIds().front()); it != slots_.end()) {
+                        var->SetSlot(it->second);
+                    }
+                }
+                method.frame_size = slots_.size();
+                return true;
+            }
+
+        private:
+            bool CollectAll(const vector<unique_ptr<Statement>>& nodes) {
+                for (const auto& node : nodes) {
+                    if (!Collect(*node)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            unordered_map<runtime::Symbol, size_t> slots_;
+            vector<VariableValue*> reads_;
+            vector<Assignment*> writes_;
+        };
+    }  // namespace
+
+    bool ResolveSlots(runtime::Method& method) {
+        return SlotResolver{}.Resolve(method);
+    }
+
+}  // namespace ast
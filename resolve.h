@@ -0,0 +1,12 @@
+#pragma once
+
+#include "runtime.h"
+
+namespace ast {
+
+    // Lays out self, the formal parameters and the locals of a method in fixed frame slots
+    // and binds every variable node of its body to its slot. Returns false and leaves the
+    // method untouched when the body holds nodes whose names cannot be resolved statically
+    bool ResolveSlots(runtime::Method& method);
+
+}  // namespace ast
@@ -0,0 +1,75 @@
+#include "resolve.h"
+#include "statement.h"
+
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace ast {
+
+    using runtime::Closure;
+    using runtime::ObjectHolder;
+
+    namespace {
+
+        void TestLocalsGetSlots() {
+            runtime::DummyContext context;
+
+            // def calc(x):
+            //   y = x + 1
+            //   self.value = y
+            //   return y
+            auto body = make_unique<Compound>();
+            body->AddStatement(make_unique<Assignment>("y",
+                make_unique<Add>(make_unique<VariableValue>("x"), make_unique<NumericConst>(1))));
+            body->AddStatement(make_unique<FieldAssignment>(VariableValue{ "self" }, "value",
+                make_unique<VariableValue>("y")));
+            body->AddStatement(make_unique<Return>(make_unique<VariableValue>("y")));
+
+            runtime::Method method{ "calc", {"x"}, make_unique<MethodBody>(std::move(body)) };
+            ASSERT(ResolveSlots(method));
+            ASSERT_EQUAL(method.frame_size, 3U);
+
+            vector<runtime::Method> methods;
+            methods.push_back(std::move(method));
+            runtime::Class cls("Calc"s, std::move(methods), nullptr);
+            runtime::ClassInstance instance(cls);
+
+            auto result = instance.Call("calc", { ObjectHolder::Own(runtime::Number(41)) }, context);
+            ASSERT_EQUAL(result.TryAs<runtime::Number>()->GetValue(), 42);
+            ASSERT_EQUAL(instance.Fields().at("value").TryAs<runtime::Number>()->GetValue(), 42);
+        }
+
+        void TestUnresolvedNamesStayUndefined() {
+            runtime::DummyContext context;
+
+            runtime::Method method{ "get", {}, make_unique<MethodBody>(make_unique<VariableValue>("global")) };
+            ASSERT(ResolveSlots(method));
+
+            vector<runtime::Method> methods;
+            methods.push_back(std::move(method));
+            runtime::Class cls("Getter"s, std::move(methods), nullptr);
+            runtime::ClassInstance instance(cls);
+
+            ASSERT_THROWS(instance.Call("get", {}, context), runtime_error);
+        }
+
+        void TestDynamicBodiesAreNotResolved() {
+            runtime::Method print_variable{ "print", {"x"}, Print::Variable("x") };
+            ASSERT(!ResolveSlots(print_variable));
+            ASSERT_EQUAL(print_variable.frame_size, 0U);
+
+            runtime::Method duplicated_params{ "f", {"x", "x"}, make_unique<VariableValue>("x") };
+            ASSERT(!ResolveSlots(duplicated_params));
+            ASSERT_EQUAL(duplicated_params.frame_size, 0U);
+        }
+
+    }  // namespace
+
+    void RunResolveTests(TestRunner& tr) {
+        RUN_TEST(tr, ast::TestLocalsGetSlots);
+        RUN_TEST(tr, ast::TestUnresolvedNamesStayUndefined);
+        RUN_TEST(tr, ast::TestDynamicBodiesAreNotResolved);
+    }
+
+}  // namespace ast
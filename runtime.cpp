@@ -1,192 +1,504 @@
-#include "runtime.h"
-
-#include <cassert>
-#include <optional>
-#include <sstream>
-
-using namespace std;
-
-namespace runtime {
-
-    namespace {
-        const string LESS_METHOD = "__lt__"s;
-        const string EQ_METHOD = "__eq__"s;
-        const string STR_METHOD = "__str__"s;
-    }  // namespace
-
-    ObjectHolder::ObjectHolder(std::shared_ptr<Object> data)
-        : data_(std::move(data)) {
-    }
-
-    void ObjectHolder::AssertIsValid() const {
-        assert(data_ != nullptr);
-    }
-
-    ObjectHolder ObjectHolder::Share(Object& object) {
-        return ObjectHolder(std::shared_ptr<Object>(&object, [](auto* /*p*/) { /* do nothing */ }));
-    }
-
-    ObjectHolder ObjectHolder::None() {
-        return ObjectHolder();
-    }
-
-    Object& ObjectHolder::operator*() const {
-        AssertIsValid();
-        return *Get();
-    }
-
-    Object* ObjectHolder::operator->() const {
-        AssertIsValid();
-        return Get();
-    }
-
-    Object* ObjectHolder::Get() const {
-        return data_.get();
-    }
-
-    ObjectHolder::operator bool() const {
-        return Get() != nullptr;
-    }
-
-    bool IsTrue(const ObjectHolder& object) {
-        if (object.TryAs<ValueObject<int>>()) {
-            return object.TryAs<ValueObject<int>>()->GetValue() != 0;
-        }
-        else if (object.TryAs<ValueObject<string>>()) {
-            return object.TryAs<ValueObject<string>>()->GetValue() != ""s;
-        }
-        else if (object.TryAs<ValueObject<bool>>()) {
-            return object.TryAs<ValueObject<bool>>()->GetValue();
-        }
-        return false;
-    }
-
-    void ClassInstance::Print(std::ostream& os, Context& context) {
-        if (this->HasMethod(STR_METHOD, 0U)) {
-            this->Call(STR_METHOD, {}, context)->Print(os,context);
-        }
-        else {
-            os << this;
-        }
-    }
-
-    bool ClassInstance::HasMethod(const std::string& method, size_t argument_count) const {
-        if (const Method* class_method = cls_.GetMethod(method); class_method) {
-            if (argument_count == class_method->formal_params.size()) {
-                return true;
-            }
-        }
-        return false;
-    }
-
-    Closure& ClassInstance::Fields() {
-        return closure_;
-    }
-
-    const Closure& ClassInstance::Fields() const {
-        return closure_;
-    }
-
-    ClassInstance::ClassInstance(const Class& cls) : cls_(cls) {
-    }
-
-    ObjectHolder ClassInstance::Call(const std::string& method,
-        const std::vector<ObjectHolder>& actual_args,
-        Context& context) {
-
-        const Method* class_method = cls_.GetMethod(method);
-        if (!class_method) {
-            throw std::runtime_error("undeclareted method"s);
-        }
-        else if (class_method->formal_params.size() != actual_args.size()) {
-            throw std::runtime_error("undeclareted method"s);
-        }
-        Closure closure;
-        closure["self"] = ObjectHolder::Share(*this);
-        for (size_t i = 0; i < class_method->formal_params.size(); ++i) {
-            closure[class_method->formal_params.at(i)] = actual_args.at(i);
-        }
-        return class_method->body->Execute(closure, context);
-    }
-
-    Class::Class(std::string name, std::vector<Method> methods, const Class* parent) : name_(move(name)), methods_(move(methods)), parent_(parent) {
-    }
-
-    const Method* Class::GetMethod(const std::string& method_name) const {
-        for (const Method& method : methods_) {
-            if (method.name == method_name) {
-                return &method;
-            }
-        }
-        if (parent_) {
-            return parent_->GetMethod(method_name);
-        }
-        return nullptr;
-    }
-
-    void Class::Print(ostream& os, [[maybe_unused]] Context& context) {
-        os << "Class " << name_;
-    }
-
-    void Bool::Print(std::ostream& os, [[maybe_unused]] Context& context) {
-        os << (GetValue() ? "True"sv : "False"sv);
-    }
-
-    bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-        ObjectHolder obj_holder;
-        if (obj_holder = EqualObjectHolders<int>(lhs, rhs); obj_holder) {
-            return obj_holder.TryAs<runtime::Bool>()->GetValue();
-        }
-        else if (obj_holder = EqualObjectHolders<string>(lhs, rhs); obj_holder) {
-            return obj_holder.TryAs<runtime::Bool>()->GetValue();
-        }
-        else if (obj_holder = EqualObjectHolders<bool>(lhs, rhs); obj_holder) {
-            return obj_holder.TryAs<runtime::Bool>()->GetValue();
-        }
-        else if (!lhs && !rhs) {
-            return true;
-        }
-        else if (lhs.TryAs<ClassInstance>()) {
-            if (lhs.TryAs<ClassInstance>()->HasMethod(EQ_METHOD, 1U)) {
-                return IsTrue(lhs.TryAs<ClassInstance>()->Call(EQ_METHOD, { rhs }, context));
-            }
-        }
-        throw std::runtime_error("diffrent tipes"s);
-    }
-
-    bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
-        ObjectHolder obj_holder;
-        if (obj_holder = LessObjectHolders<int>(lhs, rhs); obj_holder) {
-            return obj_holder.TryAs<runtime::Bool>()->GetValue();
-        }
-        else if (obj_holder = LessObjectHolders<string>(lhs, rhs); obj_holder) {
-            return obj_holder.TryAs<runtime::Bool>()->GetValue();
-        }
-        else if (obj_holder = LessObjectHolders<bool>(lhs, rhs); obj_holder) {
-            return obj_holder.TryAs<runtime::Bool>()->GetValue();
-        }
-        else if (lhs.TryAs<ClassInstance>()) {
-            if (lhs.TryAs<ClassInstance>()->HasMethod(LESS_METHOD, 1U)) {
-                return IsTrue(lhs.TryAs<ClassInstance>()->Call(LESS_METHOD, { rhs }, context));
-            }
-        }
-        throw std::runtime_error("diffrent tipes"s);
-    }
-
-    bool NotEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, [[maybe_unused]] Context& context) {
-        return !Equal(lhs, rhs, context);
-    }
-
-    bool Greater(const ObjectHolder& lhs, const ObjectHolder& rhs, [[maybe_unused]] Context& context) {
-        return (!Less(lhs, rhs, context) && !Equal(lhs, rhs, context));
-    }
-
-    bool LessOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, [[maybe_unused]] Context& context) {
-        return (Less(lhs, rhs, context) || Equal(lhs, rhs, context));
-    }
-
-    bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, [[maybe_unused]] Context& context) {
-        return (!Less(lhs, rhs, context));
-    }
-
+#include "runtime.h"
+
+#include <atomic>
+#include <cassert>
+#include <charconv>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        const Symbol LESS_METHOD{ "__lt__" };
+        const Symbol EQ_METHOD{ "__eq__" };
+        const Symbol STR_METHOD{ "__str__" };
+        const Symbol SELF{ "self" };
+
+        std::atomic<std::uint64_t> next_class_id{ 1 };
+
+        ObjectHolder SharedString(std::string value) {
+            ObjectHolder result = ObjectHolder::Own(String(std::move(value)));
+            result->ShareAcrossThreads();
+            return result;
+        }
+    }  // namespace
+
+#if defined(__GNUC__) || defined(__clang__)
+    void Object::AddSharedRef() const noexcept {
+        __atomic_fetch_add(&ref_count_, 1, __ATOMIC_RELAXED);
+    }
+
+    bool Object::ReleaseShared() const noexcept {
+        return __atomic_sub_fetch(&ref_count_, 1, __ATOMIC_ACQ_REL) == 0;
+    }
+#else
+    namespace {
+        std::mutex shared_ref_count_mutex;
+    }  // namespace
+
+    void Object::AddSharedRef() const noexcept {
+        std::lock_guard lock(shared_ref_count_mutex);
+        ++ref_count_;
+    }
+
+    bool Object::ReleaseShared() const noexcept {
+        std::lock_guard lock(shared_ref_count_mutex);
+        return --ref_count_ == 0;
+    }
+#endif
+
+    ObjectHolder::ObjectHolder(ObjectRef data)
+        : data_(std::move(data)) {
+    }
+
+    ObjectHolder::ObjectHolder(Number number)
+        : data_(std::move(number)) {
+    }
+
+    ObjectHolder::ObjectHolder(Bool boolean)
+        : data_(std::move(boolean)) {
+    }
+
+    void ObjectHolder::AssertIsValid() const {
+        assert(Get() != nullptr);
+    }
+
+    ObjectHolder ObjectHolder::Share(Object& object) {
+        return ObjectHolder(ObjectRef(&object, false));
+    }
+
+    ObjectHolder ObjectHolder::None() {
+        return ObjectHolder();
+    }
+
+    Object& ObjectHolder::operator*() const {
+        AssertIsValid();
+        return *Get();
+    }
+
+    Object* ObjectHolder::operator->() const {
+        AssertIsValid();
+        return Get();
+    }
+
+    const ObjectHolder& Closure::GetSlot(size_t slot) const {
+        if (!slots_[slot]) {
+            throw std::runtime_error("undefined value"s);
+        }
+        return *slots_[slot];
+    }
+
+    ObjectHolder& InstanceFields::operator[](Symbol name) {
+        if (ObjectHolder* value = Find(name)) {
+            return *value;
+        }
+        shape_ = &shape_->WithField(name);
+        return values_.emplace_back();
+    }
+
+    ObjectHolder& InstanceFields::at(Symbol name) {
+        if (ObjectHolder* value = Find(name)) {
+            return *value;
+        }
+        throw std::out_of_range("no field "s + name.GetName());
+    }
+
+    const ObjectHolder& InstanceFields::at(Symbol name) const {
+        if (const ObjectHolder* value = Find(name)) {
+            return *value;
+        }
+        throw std::out_of_range("no field "s + name.GetName());
+    }
+
+    bool IsTrue(const ObjectHolder& object) {
+        switch (object.GetKind()) {
+        case ObjectKind::Number:
+            return object.TryAs<Number>()->GetValue() != 0;
+        case ObjectKind::String:
+            return object.TryAs<String>()->GetSize() != 0;
+        case ObjectKind::Bool:
+            return object.TryAs<Bool>()->GetValue();
+        default:
+            return false;
+        }
+    }
+
+    String String::Concat(const String& lhs, const String& rhs) {
+        const size_t size = lhs.GetSize() + rhs.GetSize();
+        if (!lhs.rope_ && size < MIN_ROPE_SIZE) {
+            std::string value;
+            value.reserve(size);
+            value += lhs.value_;
+            value += rhs.GetValue();
+            return String(std::move(value));
+        }
+        std::shared_ptr<Piece> left = lhs.rope_;
+        if (!left) {
+            left = std::make_shared<Piece>();
+            left->text = lhs.value_;
+            left->size = lhs.value_.size();
+        }
+        auto piece = std::make_shared<Piece>();
+        piece->left = std::move(left);
+        piece->text = rhs.GetValue();
+        piece->size = size;
+        return String(std::move(piece));
+    }
+
+    const std::string& String::Flatten() const {
+        Piece& top = *rope_;
+        if (!top.left) {
+            return top.text;
+        }
+        // The pieces above the first flat one. When nothing else refers to the pieces below the top,
+        // the flat text is taken over instead of copied: appending and reading in turn stays linear
+        std::vector<const Piece*> pieces{ &top };
+        bool only_user = true;
+        Piece* bottom = nullptr;
+        for (const std::shared_ptr<Piece>* link = &top.left;; link = &(*link)->left) {
+            only_user = only_user && link->use_count() == 1;
+            if (!(*link)->left) {
+                bottom = link->get();
+                break;
+            }
+            pieces.push_back(link->get());
+        }
+        std::string text = only_user ? std::move(bottom->text) : bottom->text;
+        text.reserve(top.size);
+        for (auto piece = pieces.rbegin(); piece != pieces.rend(); ++piece) {
+            text += (*piece)->text;
+        }
+        top.text = std::move(text);
+        top.left.reset();
+        return top.text;
+    }
+
+    String::Piece::~Piece() {
+        std::shared_ptr<Piece> next = std::move(left);
+        while (next && next.use_count() == 1) {
+            // Destroys the piece after its own left has been moved out of it
+            next = std::move(next->left);
+        }
+    }
+
+    void String::Print(std::ostream& os, [[maybe_unused]] Context& context) {
+        os << GetValue();
+    }
+
+    void String::Write(OutputSink& output, [[maybe_unused]] Context& context) {
+        output.Write(GetValue());
+    }
+
+    ObjectHolder ToString(const ObjectHolder& object, Context& context) {
+        // Shared by every str() call, on every thread; strings are never changed in place
+        static const ObjectHolder NONE_STRING = SharedString("None"s);
+        static const ObjectHolder TRUE_STRING = SharedString("True"s);
+        static const ObjectHolder FALSE_STRING = SharedString("False"s);
+
+        switch (object.GetKind()) {
+        case ObjectKind::None:
+            return NONE_STRING;
+        case ObjectKind::Number: {
+            char digits[std::numeric_limits<int>::digits10 + 3];
+            char* last = std::to_chars(std::begin(digits), std::end(digits),
+                object.TryAs<Number>()->GetValue()).ptr;
+            return ObjectHolder::Own(String(std::string(digits, last)));
+        }
+        case ObjectKind::String:
+            // Copied, since the object may be a constant of a node that the result outlives. A rope
+            // shares its pieces with the copy; flat text is copied in full
+            return ObjectHolder::Own(String(*object.TryAs<String>()));
+        case ObjectKind::Bool:
+            return object.TryAs<Bool>()->GetValue() ? TRUE_STRING : FALSE_STRING;
+        case ObjectKind::Class:
+            return ObjectHolder::Own(String("Class "s + object.TryAs<Class>()->GetName()));
+        case ObjectKind::ClassInstance: {
+            auto* instance = object.TryAs<ClassInstance>();
+            if (instance->HasMethod(STR_METHOD, 0U)) {
+                return ToString(instance->Call(STR_METHOD, {}, context), context);
+            }
+            break;
+        }
+        case ObjectKind::Other:
+            break;
+        }
+        std::ostringstream output;
+        object->Print(output, context);
+        return ObjectHolder::Own(String(output.str()));
+    }
+
+    void ClassInstance::Print(std::ostream& os, Context& context) {
+        if (this->HasMethod(STR_METHOD, 0U)) {
+            this->Call(STR_METHOD, {}, context)->Print(os,context);
+        }
+        else {
+            os << this;
+        }
+    }
+
+    void ClassInstance::Write(OutputSink& output, Context& context) {
+        if (this->HasMethod(STR_METHOD, 0U)) {
+            this->Call(STR_METHOD, {}, context)->Write(output, context);
+        }
+        else {
+            output.GetStream() << this;
+        }
+    }
+
+    bool ClassInstance::HasMethod(Symbol method, size_t argument_count) const {
+        if (const Method* class_method = cls_.GetMethod(method); class_method) {
+            if (argument_count == class_method->formal_params.size()) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    InstanceFields& ClassInstance::Fields() {
+        return fields_;
+    }
+
+    const InstanceFields& ClassInstance::Fields() const {
+        return fields_;
+    }
+
+    ClassInstance::ClassInstance(const Class& cls) : Object(ObjectKind::ClassInstance), cls_(cls) {
+    }
+
+    ObjectHolder ClassInstance::Call(Symbol method,
+        const std::vector<ObjectHolder>& actual_args,
+        Context& context) {
+
+        const Method* class_method = cls_.GetMethod(method);
+        if (!class_method) {
+            throw std::runtime_error("undeclareted method"s);
+        }
+        return Call(*class_method, actual_args, context);
+    }
+
+    ObjectHolder ClassInstance::Call(const Method& method,
+        const std::vector<ObjectHolder>& actual_args,
+        Context& context) {
+
+        if (method.formal_params.size() != actual_args.size()) {
+            throw std::runtime_error("undeclareted method"s);
+        }
+        Closure closure;
+        if (method.frame_size) {
+            closure.ResizeSlots(method.frame_size);
+            closure.SetSlot(0, ObjectHolder::Share(*this));
+            for (size_t i = 0; i < actual_args.size(); ++i) {
+                closure.SetSlot(i + 1, actual_args[i]);
+            }
+        }
+        else {
+            closure[SELF] = ObjectHolder::Share(*this);
+            for (size_t i = 0; i < method.formal_params.size(); ++i) {
+                closure[method.formal_params.at(i)] = actual_args.at(i);
+            }
+        }
+        return method.body->Execute(closure, context);
+    }
+
+    Class::Class(std::string name, std::vector<Method> methods, const Class* parent) : Object(ObjectKind::Class), name_(move(name)), methods_(move(methods)), parent_(parent), id_(next_class_id++) {
+        BuildMethodTable();
+    }
+
+    Class::Class(Class&& other)
+        : Object(std::move(other)), name_(move(other.name_)), methods_(move(other.methods_)), parent_(other.parent_), id_(other.id_) {
+        other.method_table_.clear();
+        BuildMethodTable();
+    }
+
+    void Class::BuildMethodTable() {
+        method_table_.reserve(methods_.size() + (parent_ ? parent_->method_table_.size() : 0));
+        for (const Method& method : methods_) {
+            method_table_.emplace(method.name, &method);
+        }
+        if (parent_) {
+            for (const auto& [method_name, method] : parent_->method_table_) {
+                method_table_.emplace(method_name, method);
+            }
+        }
+    }
+
+    const Method* Class::GetMethod(Symbol method_name) const {
+        if (auto it = method_table_.find(method_name); it != method_table_.end()) {
+            return it->second;
+        }
+        return nullptr;
+    }
+
+    const Method* MethodCache::Lookup(const Class& cls, Symbol name) {
+        Stats& thread_stats = GetThreadStats();
+        for (size_t i = 0; i < size_; ++i) {
+            if (entries_[i].class_id == cls.GetId()) {
+                ++stats_.hits;
+                ++thread_stats.hits;
+                return entries_[i].method;
+            }
+        }
+        ++stats_.misses;
+        ++thread_stats.misses;
+        const Method* method = cls.GetMethod(name);
+        if (method && size_ < CAPACITY) {
+            entries_[size_++] = { cls.GetId(), method };
+        }
+        return method;
+    }
+
+    MethodCache::Stats& MethodCache::GetThreadStats() {
+        static thread_local Stats stats;
+        return stats;
+    }
+
+    void Class::Print(ostream& os, [[maybe_unused]] Context& context) {
+        os << "Class " << name_;
+    }
+
+    void Class::Write(OutputSink& output, [[maybe_unused]] Context& context) {
+        output.Write("Class "sv);
+        output.Write(name_);
+    }
+
+    void Bool::Print(std::ostream& os, [[maybe_unused]] Context& context) {
+        os << (GetValue() ? "True"sv : "False"sv);
+    }
+
+    void Bool::Write(OutputSink& output, [[maybe_unused]] Context& context) {
+        output.Write(GetValue() ? "True"sv : "False"sv);
+    }
+
+    namespace {
+        template <typename T>
+        int ThreeWay(const T& lhs, const T& rhs) {
+            return (lhs > rhs) - (lhs < rhs);
+        }
+
+        // Equality of objects other than two values of one type
+        bool EqualObjects(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+            if (!lhs && !rhs) {
+                return true;
+            }
+            if (auto* instance = lhs.TryAs<ClassInstance>(); instance && instance->HasMethod(EQ_METHOD, 1U)) {
+                return IsTrue(instance->Call(EQ_METHOD, { rhs }, context));
+            }
+            throw std::runtime_error("diffrent tipes"s);
+        }
+
+        bool LessObjects(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+            if (auto* instance = lhs.TryAs<ClassInstance>(); instance && instance->HasMethod(LESS_METHOD, 1U)) {
+                return IsTrue(instance->Call(LESS_METHOD, { rhs }, context));
+            }
+            throw std::runtime_error("diffrent tipes"s);
+        }
+    }  // namespace
+
+    optional<int> CompareValues(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+        const ObjectKind kind = lhs.GetKind();
+        if (kind != rhs.GetKind()) {
+            return nullopt;
+        }
+        switch (kind) {
+        case ObjectKind::Number:
+            return ThreeWay(lhs.TryAs<Number>()->GetValue(), rhs.TryAs<Number>()->GetValue());
+        case ObjectKind::String:
+            return ThreeWay(lhs.TryAs<String>()->GetValue().compare(rhs.TryAs<String>()->GetValue()), 0);
+        case ObjectKind::Bool:
+            return ThreeWay(lhs.TryAs<Bool>()->GetValue(), rhs.TryAs<Bool>()->GetValue());
+        default:
+            return nullopt;
+        }
+    }
+
+    template <Comparator CMP>
+    bool Compare(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        if (const optional<int> order = CompareValues(lhs, rhs)) {
+            switch (CMP) {
+            case Comparator::Equal:
+                return *order == 0;
+            case Comparator::NotEqual:
+                return *order != 0;
+            case Comparator::Less:
+                return *order < 0;
+            case Comparator::Greater:
+                return *order > 0;
+            case Comparator::LessOrEqual:
+                return *order <= 0;
+            case Comparator::GreaterOrEqual:
+                return *order >= 0;
+            }
+        }
+        switch (CMP) {
+        case Comparator::Equal:
+            return EqualObjects(lhs, rhs, context);
+        case Comparator::NotEqual:
+            return !EqualObjects(lhs, rhs, context);
+        case Comparator::Less:
+            return LessObjects(lhs, rhs, context);
+        case Comparator::Greater:
+            return !LessObjects(lhs, rhs, context) && !EqualObjects(lhs, rhs, context);
+        case Comparator::LessOrEqual:
+            return LessObjects(lhs, rhs, context) || EqualObjects(lhs, rhs, context);
+        case Comparator::GreaterOrEqual:
+            return !LessObjects(lhs, rhs, context);
+        }
+        return false;
+    }
+
+    template bool Compare<Comparator::Equal>(const ObjectHolder&, const ObjectHolder&, Context&);
+    template bool Compare<Comparator::NotEqual>(const ObjectHolder&, const ObjectHolder&, Context&);
+    template bool Compare<Comparator::Less>(const ObjectHolder&, const ObjectHolder&, Context&);
+    template bool Compare<Comparator::Greater>(const ObjectHolder&, const ObjectHolder&, Context&);
+    template bool Compare<Comparator::LessOrEqual>(const ObjectHolder&, const ObjectHolder&, Context&);
+    template bool Compare<Comparator::GreaterOrEqual>(const ObjectHolder&, const ObjectHolder&, Context&);
+
+    bool Compare(Comparator cmp, const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        switch (cmp) {
+        case Comparator::Equal:
+            return Compare<Comparator::Equal>(lhs, rhs, context);
+        case Comparator::NotEqual:
+            return Compare<Comparator::NotEqual>(lhs, rhs, context);
+        case Comparator::Less:
+            return Compare<Comparator::Less>(lhs, rhs, context);
+        case Comparator::Greater:
+            return Compare<Comparator::Greater>(lhs, rhs, context);
+        case Comparator::LessOrEqual:
+            return Compare<Comparator::LessOrEqual>(lhs, rhs, context);
+        case Comparator::GreaterOrEqual:
+            return Compare<Comparator::GreaterOrEqual>(lhs, rhs, context);
+        }
+        throw std::runtime_error("unknown comparison"s);
+    }
+
+    bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        return Compare<Comparator::Equal>(lhs, rhs, context);
+    }
+
+    bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        return Compare<Comparator::Less>(lhs, rhs, context);
+    }
+
+    bool NotEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        return Compare<Comparator::NotEqual>(lhs, rhs, context);
+    }
+
+    bool Greater(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        return Compare<Comparator::Greater>(lhs, rhs, context);
+    }
+
+    bool LessOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        return Compare<Comparator::LessOrEqual>(lhs, rhs, context);
+    }
+
+    bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+        return Compare<Comparator::GreaterOrEqual>(lhs, rhs, context);
+    }
+
 }  // namespace runtime
\ No newline at end of file
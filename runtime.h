@@ -1,191 +1,723 @@
-#pragma once
-
-#include <memory>
-#include <sstream>
-#include <string>
-#include <unordered_map>
-#include <vector>
-
-namespace runtime {
-
-    class Context {
-    public:
-        virtual std::ostream& GetOutputStream() = 0;
-
-    protected:
-        ~Context() = default;
-    };
-
-    class Object {
-    public:
-        virtual ~Object() = default;
-        virtual void Print(std::ostream& os, Context& context) = 0;
-    };
-
-    class ObjectHolder {
-    public:
-        ObjectHolder() = default;
-
-        template <typename T>
-        [[nodiscard]] static ObjectHolder Own(T&& object) {
-            return ObjectHolder(std::make_shared<T>(std::forward<T>(object)));
-        }
-
-        [[nodiscard]] static ObjectHolder Share(Object& object);
-
-        [[nodiscard]] static ObjectHolder None();
-
-        Object& operator*() const;
-
-        Object* operator->() const;
-
-        [[nodiscard]] Object* Get() const;
-
-        template <typename T>
-        [[nodiscard]] T* TryAs() const {
-            return dynamic_cast<T*>(this->Get());
-        }
-
-        explicit operator bool() const;
-
-    private:
-        explicit ObjectHolder(std::shared_ptr<Object> data);
-        void AssertIsValid() const;
-
-        std::shared_ptr<Object> data_;
-    };
-
-    template <typename T>
-    class ValueObject : public Object {
-    public:
-        ValueObject(T v)  
-            : value_(v) {
-        }
-
-        void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
-            os << value_;
-        }
-
-        [[nodiscard]] const T& GetValue() const {
-            return value_;
-        }
-
-    private:
-        T value_;
-    };
-
-    using Closure = std::unordered_map<std::string, ObjectHolder>;
-
-    bool IsTrue(const ObjectHolder& object);
-
-    class Executable {
-    public:
-        virtual ~Executable() = default;
-        virtual ObjectHolder Execute(Closure& closure, Context& context) = 0;
-    };
-
-    using String = ValueObject<std::string>;
-
-    using Number = ValueObject<int>;
-
-    class Bool : public ValueObject<bool> {
-    public:
-        using ValueObject<bool>::ValueObject;
-
-        void Print(std::ostream& os, Context& context) override;
-    };
-
-    struct Method {
-        std::string name;
-        std::vector<std::string> formal_params;
-        std::unique_ptr<Executable> body;
-    };
-
-    class Class : public Object {
-    public:
-        explicit Class(std::string name, std::vector<Method> methods, const Class* parent);
-
-        [[nodiscard]] const Method* GetMethod(const std::string& name) const;
-
-        [[nodiscard]] inline const std::string& GetName() const {
-            return name_;
-        }
-
-        void Print(std::ostream& os, Context& context) override;
-    private:
-        std::string name_;
-        std::vector<Method> methods_;
-        const Class* parent_;
-    };
-
-    class ClassInstance : public Object {
-    public:
-        explicit ClassInstance(const Class& cls);
-
-        void Print(std::ostream& os, Context& context) override;
-
-        ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& actual_args,
-            Context& context);
-
-        [[nodiscard]] bool HasMethod(const std::string& method, size_t argument_count) const;
-
-        [[nodiscard]] Closure& Fields();
-
-        [[nodiscard]] const Closure& Fields() const;
-
-    private:
-        const Class& cls_;
-        Closure closure_;
-    };
-
-    template <typename Type>
-    ObjectHolder EqualObjectHolders(const ObjectHolder& lhs, const ObjectHolder& rhs) {
-        if (lhs.TryAs<ValueObject<Type>>() && rhs.TryAs<ValueObject<Type>>()) {
-            return ObjectHolder::Own(runtime::Bool{ lhs.TryAs<ValueObject<Type>>()->GetValue() == rhs.TryAs<ValueObject<Type>>()->GetValue() });
-        }
-        return {};
-    }
-
-    template <typename Type>
-    ObjectHolder LessObjectHolders(const ObjectHolder& lhs, const ObjectHolder& rhs) {
-        if (lhs.TryAs<ValueObject<Type>>() && rhs.TryAs<ValueObject<Type>>()) {
-            return ObjectHolder::Own(runtime::Bool{ lhs.TryAs<ValueObject<Type>>()->GetValue() < rhs.TryAs<ValueObject<Type>>()->GetValue() });
-        }
-        return {};
-    }
-
-    bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-
-    bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-
-    bool NotEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-
-    bool Greater(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-
-    bool LessOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-
-    bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-
-    struct DummyContext : Context {
-        std::ostream& GetOutputStream() override {
-            return output;
-        }
-
-        std::ostringstream output;
-    };
-
-    class SimpleContext : public runtime::Context {
-    public:
-        explicit SimpleContext(std::ostream& output)
-            : output_(output) {
-        }
-
-        std::ostream& GetOutputStream() override {
-            return output_;
-        }
-
-    private:
-        std::ostream& output_;
-    };
-
+#pragma once
+
+#include "output_sink.h"
+#include "shape.h"
+#include "source_span.h"
+#include "symbol.h"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace runtime {
+
+    class Context {
+    public:
+        // Where print statements write; output written to GetOutputStream goes through it too
+        virtual OutputSink& GetOutput() = 0;
+
+        virtual std::ostream& GetOutputStream() = 0;
+
+    protected:
+        ~Context() = default;
+    };
+
+    // Built-in type of an object, so that operators can switch on it instead of trying dynamic_casts
+    enum class ObjectKind : std::uint8_t {
+        None,  // only reported by an empty ObjectHolder
+        Number,
+        String,
+        Bool,
+        Class,
+        ClassInstance,
+        Other,
+    };
+
+    class ObjectRef;
+
+    // Heap objects are reference counted by the ObjectHolders that own them. The count lives in the
+    // object and is not atomic, since an interpreter runs on one thread; an object that threads
+    // hold at the same time has to be marked with ShareAcrossThreads
+    class Object {
+    public:
+        virtual ~Object() = default;
+        virtual void Print(std::ostream& os, Context& context) = 0;
+
+        // Same text as Print; built-in types write it without an ostream
+        virtual void Write(OutputSink& output, Context& context) {
+            Print(output.GetStream(), context);
+        }
+
+        [[nodiscard]] ObjectKind GetKind() const {
+            return kind_;
+        }
+
+        // Makes the reference count atomic. Call it before the object reaches a second thread
+        void ShareAcrossThreads() {
+            thread_shared_ = true;
+        }
+
+    protected:
+        Object() = default;
+
+        // Only for the built-in types the kind stands for
+        explicit Object(ObjectKind kind)
+            : kind_(kind) {
+        }
+
+        // A copy is a new object that nothing refers to yet
+        Object(const Object& other) noexcept
+            : kind_(other.kind_) {
+        }
+
+        Object& operator=(const Object& other) noexcept {
+            kind_ = other.kind_;
+            return *this;
+        }
+
+    private:
+        friend class ObjectRef;
+
+        void AddRef() const noexcept {
+            if (thread_shared_) {
+                AddSharedRef();
+            }
+            else {
+                ++ref_count_;
+            }
+        }
+
+        // True when the last reference is gone
+        [[nodiscard]] bool Release() const noexcept {
+            if (thread_shared_) {
+                return ReleaseShared();
+            }
+            return --ref_count_ == 0;
+        }
+
+        void AddSharedRef() const noexcept;
+        [[nodiscard]] bool ReleaseShared() const noexcept;
+
+        ObjectKind kind_ = ObjectKind::Other;
+        bool thread_shared_ = false;
+        mutable std::uint32_t ref_count_ = 0;
+    };
+
+    class Class;
+    class ClassInstance;
+    class Bool;
+    class String;
+
+    template <typename T>
+    class ValueObject;
+
+    // Kind of every object of type T and of its subclasses; Other where objects of T may have different kinds
+    template <typename T>
+    inline constexpr ObjectKind KIND_OF = ObjectKind::Other;
+
+    template <>
+    inline constexpr ObjectKind KIND_OF<ValueObject<int>> = ObjectKind::Number;
+
+    template <>
+    inline constexpr ObjectKind KIND_OF<String> = ObjectKind::String;
+
+    // Booleans are always Bool objects
+    template <>
+    inline constexpr ObjectKind KIND_OF<ValueObject<bool>> = ObjectKind::Bool;
+
+    template <>
+    inline constexpr ObjectKind KIND_OF<Bool> = ObjectKind::Bool;
+
+    template <>
+    inline constexpr ObjectKind KIND_OF<Class> = ObjectKind::Class;
+
+    template <>
+    inline constexpr ObjectKind KIND_OF<ClassInstance> = ObjectKind::ClassInstance;
+
+    template <typename T>
+    class ValueObject : public Object {
+    public:
+        ValueObject(T v)  
+            : Object(KIND_OF<ValueObject<T>>), value_(v) {
+        }
+
+        void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
+            os << value_;
+        }
+
+        void Write(OutputSink& output, [[maybe_unused]] Context& context) override {
+            if constexpr (std::is_same_v<T, int>) {
+                output.WriteInteger(value_);
+            }
+            else {
+                output.GetStream() << value_;
+            }
+        }
+
+        [[nodiscard]] const T& GetValue() const {
+            return value_;
+        }
+
+    private:
+        T value_;
+    };
+
+    // Immutable text. A long concatenation refers to the text of its left operand instead of copying
+    // it, and is flattened into one buffer when its value is first needed, so building a string
+    // with s = s + piece takes time linear in its length. Ropes are for one thread only: GetValue
+    // flattens in place the pieces that copies of the string share, and a flat string taking over
+    // the text of its pieces depends on their use counts. Only flat strings may be read by several
+    // threads at once
+    class String : public Object {
+    public:
+        String(std::string value)
+            : Object(ObjectKind::String), value_(std::move(value)) {
+        }
+
+        // Concatenations shorter than this are copied
+        static constexpr size_t MIN_ROPE_SIZE = 256;
+
+        [[nodiscard]] static String Concat(const String& lhs, const String& rhs);
+
+        void Print(std::ostream& os, Context& context) override;
+
+        void Write(OutputSink& output, Context& context) override;
+
+        [[nodiscard]] const std::string& GetValue() const {
+            return rope_ ? Flatten() : value_;
+        }
+
+        [[nodiscard]] size_t GetSize() const {
+            return rope_ ? rope_->size : value_.size();
+        }
+
+    private:
+        // Text of a concatenation: the text of left, if any, followed by text
+        struct Piece {
+            Piece() = default;
+            Piece(const Piece&) = delete;
+            Piece& operator=(const Piece&) = delete;
+            // Without recursion, however long the chain
+            ~Piece();
+
+            std::shared_ptr<Piece> left;
+            std::string text;
+            size_t size = 0;
+        };
+
+        explicit String(std::shared_ptr<Piece> rope)
+            : Object(ObjectKind::String), rope_(std::move(rope)) {
+        }
+
+        const std::string& Flatten() const;
+
+        // Used when rope_ is empty
+        std::string value_;
+        std::shared_ptr<Piece> rope_;
+    };
+
+    using Number = ValueObject<int>;
+
+    class Bool : public ValueObject<bool> {
+    public:
+        using ValueObject<bool>::ValueObject;
+
+        void Print(std::ostream& os, Context& context) override;
+
+        void Write(OutputSink& output, Context& context) override;
+    };
+
+    // Pointer to a heap object for ObjectHolder, counted unless it was made by ObjectHolder::Share
+    class ObjectRef {
+    public:
+        ObjectRef() = default;
+
+        ObjectRef(Object* object, bool owning) noexcept
+            : object_(object), owning_(owning) {
+            if (owning_) {
+                object_->AddRef();
+            }
+        }
+
+        ObjectRef(const ObjectRef& other) noexcept
+            : object_(other.object_), owning_(other.owning_) {
+            if (owning_) {
+                object_->AddRef();
+            }
+        }
+
+        ObjectRef(ObjectRef&& other) noexcept
+            : object_(std::exchange(other.object_, nullptr)), owning_(std::exchange(other.owning_, false)) {
+        }
+
+        ObjectRef& operator=(ObjectRef other) noexcept {
+            std::swap(object_, other.object_);
+            std::swap(owning_, other.owning_);
+            return *this;
+        }
+
+        ~ObjectRef() {
+            if (owning_ && object_->Release()) {
+                delete object_;
+            }
+        }
+
+        [[nodiscard]] Object* Get() const {
+            return object_;
+        }
+
+    private:
+        Object* object_ = nullptr;
+        bool owning_ = false;
+    };
+
+    // Number and Bool are kept inline in ObjectHolder instead of on the heap
+    template <typename T>
+    inline constexpr bool IS_IMMEDIATE = std::is_same_v<T, Number> || std::is_same_v<T, Bool>;
+
+    class ObjectHolder {
+    public:
+        ObjectHolder() = default;
+
+        template <typename T>
+        [[nodiscard]] static ObjectHolder Own(T&& object) {
+            using Type = std::decay_t<T>;
+            if constexpr (IS_IMMEDIATE<Type>) {
+                return ObjectHolder(Type(std::forward<T>(object)));
+            }
+            else {
+                return ObjectHolder(ObjectRef(new Type(std::forward<T>(object)), true));
+            }
+        }
+
+        [[nodiscard]] static ObjectHolder Share(Object& object);
+
+        [[nodiscard]] static ObjectHolder None();
+
+        Object& operator*() const;
+
+        Object* operator->() const;
+
+        [[nodiscard]] Object* Get() const {
+            if (const auto* heap = std::get_if<ObjectRef>(&data_)) {
+                return heap->Get();
+            }
+            if (const auto* number = std::get_if<Number>(&data_)) {
+                return const_cast<Number*>(number);
+            }
+            return const_cast<Bool*>(&std::get<Bool>(data_));
+        }
+
+        [[nodiscard]] ObjectKind GetKind() const {
+            if (const auto* heap = std::get_if<ObjectRef>(&data_)) {
+                return heap->Get() ? heap->Get()->GetKind() : ObjectKind::None;
+            }
+            return std::holds_alternative<Number>(data_) ? ObjectKind::Number : ObjectKind::Bool;
+        }
+
+        template <typename T>
+        [[nodiscard]] T* TryAs() const {
+            if (const auto* heap = std::get_if<ObjectRef>(&data_)) {
+                if constexpr (KIND_OF<T> != ObjectKind::Other) {
+                    Object* object = heap->Get();
+                    return object && object->GetKind() == KIND_OF<T> ? static_cast<T*>(object) : nullptr;
+                }
+                else {
+                    return dynamic_cast<T*>(heap->Get());
+                }
+            }
+            if constexpr (std::is_base_of_v<T, Number>) {
+                if (const auto* number = std::get_if<Number>(&data_)) {
+                    return const_cast<Number*>(number);
+                }
+            }
+            if constexpr (std::is_base_of_v<T, Bool>) {
+                if (const auto* boolean = std::get_if<Bool>(&data_)) {
+                    return const_cast<Bool*>(boolean);
+                }
+            }
+            return nullptr;
+        }
+
+        explicit operator bool() const {
+            return Get() != nullptr;
+        }
+
+    private:
+        explicit ObjectHolder(ObjectRef data);
+        explicit ObjectHolder(Number number);
+        explicit ObjectHolder(Bool boolean);
+        void AssertIsValid() const;
+
+        std::variant<ObjectRef, Number, Bool> data_;
+    };
+
+    // How the statements run in a frame completed: a return carries its value as the result of Execute
+    enum class Completion : std::uint8_t {
+        Normal,
+        Return,
+    };
+
+    class Closure : public std::unordered_map<Symbol, ObjectHolder> {
+    public:
+        using std::unordered_map<Symbol, ObjectHolder>::unordered_map;
+
+        // Set by a return statement; blocks stop on it and the method body it ends resets it
+        [[nodiscard]] Completion GetCompletion() const {
+            return completion_;
+        }
+
+        void SetCompletion(Completion completion) {
+            completion_ = completion;
+        }
+
+        // Frame slots of a method call with resolved locals (see ast::ResolveSlots)
+        void ResizeSlots(size_t count) {
+            slots_.resize(count);
+        }
+
+        [[nodiscard]] const ObjectHolder& GetSlot(size_t slot) const;
+
+        void SetSlot(size_t slot, ObjectHolder value) {
+            slots_[slot] = std::move(value);
+        }
+
+    private:
+        std::vector<std::optional<ObjectHolder>> slots_;
+        Completion completion_ = Completion::Normal;
+    };
+
+    // Fields of a class instance: values in assignment order, names kept by the shared shape
+    class InstanceFields {
+    public:
+        template <typename Holder>
+        class Iterator {
+        public:
+            using value_type = std::pair<Symbol, Holder&>;
+
+            struct Arrow {
+                value_type value;
+
+                const value_type* operator->() const {
+                    return &value;
+                }
+            };
+
+            Iterator(const Shape* shape, Holder* values, size_t index)
+                : shape_(shape), values_(values), index_(index) {
+            }
+
+            value_type operator*() const {
+                return { shape_->GetFieldName(index_), values_[index_] };
+            }
+
+            Arrow operator->() const {
+                return { **this };
+            }
+
+            Iterator& operator++() {
+                ++index_;
+                return *this;
+            }
+
+            friend bool operator==(const Iterator& lhs, const Iterator& rhs) {
+                return lhs.values_ == rhs.values_ && lhs.index_ == rhs.index_;
+            }
+
+            friend bool operator!=(const Iterator& lhs, const Iterator& rhs) {
+                return !(lhs == rhs);
+            }
+
+        private:
+            const Shape* shape_;
+            Holder* values_;
+            size_t index_;
+        };
+
+        using iterator = Iterator<ObjectHolder>;
+        using const_iterator = Iterator<const ObjectHolder>;
+
+        [[nodiscard]] ObjectHolder* Find(Symbol name) {
+            const size_t index = shape_->IndexOf(name);
+            return index == Shape::NO_FIELD ? nullptr : &values_[index];
+        }
+
+        [[nodiscard]] const ObjectHolder* Find(Symbol name) const {
+            const size_t index = shape_->IndexOf(name);
+            return index == Shape::NO_FIELD ? nullptr : &values_[index];
+        }
+
+        // Adds the field holding None if it is missing. References to other fields of the
+        // instance do not survive the addition
+        ObjectHolder& operator[](Symbol name);
+
+        [[nodiscard]] const Shape& GetShape() const {
+            return *shape_;
+        }
+
+        // Map-like interface of the former std::unordered_map based storage
+
+        ObjectHolder& at(Symbol name);
+        const ObjectHolder& at(Symbol name) const;
+
+        [[nodiscard]] iterator find(Symbol name) {
+            const size_t index = shape_->IndexOf(name);
+            return { shape_, values_.data(), index == Shape::NO_FIELD ? values_.size() : index };
+        }
+
+        [[nodiscard]] const_iterator find(Symbol name) const {
+            const size_t index = shape_->IndexOf(name);
+            return { shape_, values_.data(), index == Shape::NO_FIELD ? values_.size() : index };
+        }
+
+        [[nodiscard]] size_t count(Symbol name) const {
+            return Find(name) ? 1 : 0;
+        }
+
+        [[nodiscard]] size_t size() const {
+            return values_.size();
+        }
+
+        [[nodiscard]] iterator begin() {
+            return { shape_, values_.data(), 0 };
+        }
+
+        [[nodiscard]] iterator end() {
+            return { shape_, values_.data(), values_.size() };
+        }
+
+        [[nodiscard]] const_iterator begin() const {
+            return { shape_, values_.data(), 0 };
+        }
+
+        [[nodiscard]] const_iterator end() const {
+            return { shape_, values_.data(), values_.size() };
+        }
+
+    private:
+        const Shape* shape_ = &Shape::Empty();
+        std::vector<ObjectHolder> values_;
+    };
+
+    bool IsTrue(const ObjectHolder& object);
+
+    // Result of str(object): the same text Print writes, as a String. True, False and None give
+    // shared strings and numbers are formatted without a stream; only objects that are not
+    // built-in and instances without __str__ are printed to one
+    [[nodiscard]] ObjectHolder ToString(const ObjectHolder& object, Context& context);
+
+    class Executable {
+    public:
+        virtual ~Executable() = default;
+        virtual ObjectHolder Execute(Closure& closure, Context& context) = 0;
+
+        // Where the node was parsed from; unknown for nodes made by code
+        [[nodiscard]] const parse::SourceSpan& GetSpan() const {
+            return span_;
+        }
+
+        void SetSpan(const parse::SourceSpan& span) {
+            span_ = span;
+        }
+
+        // Nodes go to the arena of the active ArenaScope, if any (see arena.h)
+        static void* operator new(size_t size);
+        static void operator delete(void* node);
+
+    private:
+        parse::SourceSpan span_;
+    };
+
+    struct Method {
+        Symbol name;
+        std::vector<Symbol> formal_params;
+        std::unique_ptr<Executable> body;
+        // 0 - locals are looked up by name; otherwise self takes slot 0 and formal_params slots 1..n
+        size_t frame_size = 0;
+    };
+
+    class Class : public Object {
+    public:
+        explicit Class(std::string name, std::vector<Method> methods, const Class* parent);
+
+        // The method table points into methods_, so a moved class builds its own; a class is not copied
+        Class(Class&& other);
+        Class(const Class&) = delete;
+        Class& operator=(const Class&) = delete;
+        Class& operator=(Class&&) = delete;
+
+        [[nodiscard]] const Method* GetMethod(Symbol name) const;
+
+        [[nodiscard]] inline const std::string& GetName() const {
+            return name_;
+        }
+
+        [[nodiscard]] const std::vector<Method>& GetMethods() const {
+            return methods_;
+        }
+
+        // Bodies may be rewritten in place; methods must not be added or removed
+        [[nodiscard]] std::vector<Method>& GetMethods() {
+            return methods_;
+        }
+
+        [[nodiscard]] const Class* GetParent() const {
+            return parent_;
+        }
+
+        // Unique for the whole process, unlike the address of a class that may be reused
+        [[nodiscard]] std::uint64_t GetId() const {
+            return id_;
+        }
+
+        void Print(std::ostream& os, Context& context) override;
+
+        void Write(OutputSink& output, Context& context) override;
+
+    private:
+        void BuildMethodTable();
+
+        std::string name_;
+        std::vector<Method> methods_;
+        const Class* parent_;
+        std::uint64_t id_;
+        // Own and inherited methods, own ones overriding; built once by the constructors
+        std::unordered_map<Symbol, const Method*> method_table_;
+    };
+
+    class ClassInstance : public Object {
+    public:
+        explicit ClassInstance(const Class& cls);
+
+        void Print(std::ostream& os, Context& context) override;
+
+        void Write(OutputSink& output, Context& context) override;
+
+        ObjectHolder Call(Symbol method, const std::vector<ObjectHolder>& actual_args,
+            Context& context);
+
+        // Calls a method already looked up in the class of this instance
+        ObjectHolder Call(const Method& method, const std::vector<ObjectHolder>& actual_args,
+            Context& context);
+
+        [[nodiscard]] bool HasMethod(Symbol method, size_t argument_count) const;
+
+        [[nodiscard]] InstanceFields& Fields();
+
+        [[nodiscard]] const InstanceFields& Fields() const;
+
+        [[nodiscard]] const Class& GetClass() const {
+            return cls_;
+        }
+
+    private:
+        const Class& cls_;
+        InstanceFields fields_;
+    };
+
+    // Inline cache of one call site: remembers the methods resolved for the last few receiver
+    // classes and goes megamorphic (plain lookups) once more classes show up
+    class MethodCache {
+    public:
+        static constexpr size_t CAPACITY = 4;
+
+        struct Stats {
+            std::uint64_t hits = 0;
+            std::uint64_t misses = 0;
+        };
+
+        [[nodiscard]] const Method* Lookup(const Class& cls, Symbol name);
+
+        [[nodiscard]] const Stats& GetStats() const {
+            return stats_;
+        }
+
+        // Totals of every call site executed by the current thread
+        [[nodiscard]] static Stats& GetThreadStats();
+
+    private:
+        struct Entry {
+            std::uint64_t class_id = 0;
+            const Method* method = nullptr;
+        };
+
+        std::array<Entry, CAPACITY> entries_;
+        size_t size_ = 0;
+        Stats stats_;
+    };
+
+    bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+    bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+    bool NotEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+    bool Greater(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+    bool LessOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+    bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+    enum class Comparator {
+        Equal,
+        NotEqual,
+        Less,
+        Greater,
+        LessOrEqual,
+        GreaterOrEqual,
+    };
+
+    // Three-way comparison of two numbers, two strings or two bools: negative, zero or positive.
+    // Empty for any other pair of objects
+    [[nodiscard]] std::optional<int> CompareValues(const ObjectHolder& lhs, const ObjectHolder& rhs);
+
+    // Values are compared by a single CompareValues. Class instances get __lt__ and then, if the
+    // result still depends on it, __eq__, so neither method runs more than once per comparison
+    template <Comparator CMP>
+    bool Compare(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+    bool Compare(Comparator cmp, const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
+    // Collects the output in a string stream, written through so that it can be read at any time
+    struct DummyContext : Context {
+        OutputSink& GetOutput() override {
+            return sink;
+        }
+
+        std::ostream& GetOutputStream() override {
+            return sink.GetStream();
+        }
+
+        std::ostringstream output;
+        OutputSink sink{ output, 0 };
+    };
+
+    // Buffers the output for the stream until flush_threshold bytes have collected, and at the latest
+    // until the context is destroyed
+    class SimpleContext : public runtime::Context {
+    public:
+        explicit SimpleContext(std::ostream& output, size_t flush_threshold = OutputSink::DEFAULT_FLUSH_THRESHOLD)
+            : sink_(output, flush_threshold) {
+        }
+
+        OutputSink& GetOutput() override {
+            return sink_;
+        }
+
+        std::ostream& GetOutputStream() override {
+            return sink_.GetStream();
+        }
+
+    private:
+        OutputSink sink_;
+    };
+
 }  // namespace runtime
\ No newline at end of file
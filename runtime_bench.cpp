@@ -0,0 +1,79 @@
+#include "runtime.h"
+#include "statement.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+using namespace std::literals;
+
+// Method lookup cost in a deep class hierarchy. Every level adds a couple of
+// methods of its own; the probed ones live in the root class only, so each
+// lookup from the leaf has to get past every level above it.
+// Build with -O2 and run without arguments.
+
+namespace {
+
+    constexpr int DEPTH = 10;
+    constexpr int ITERATIONS = 1'000'000;
+
+    vector<unique_ptr<runtime::Class>> MakeHierarchy() {
+        vector<unique_ptr<runtime::Class>> hierarchy;
+        for (int level = 0; level < DEPTH; ++level) {
+            vector<runtime::Method> methods;
+            if (level == 0) {
+                methods.push_back({ "__str__", {}, make_unique<ast::StringConst>("Leaf"s) });
+                methods.push_back({ "__eq__", {"rhs"}, make_unique<ast::BoolConst>(true) });
+                methods.push_back({ "Get", {}, make_unique<ast::NumericConst>(1) });
+            }
+            const string suffix = to_string(level);
+            methods.push_back({ runtime::Symbol("Get"s + suffix), {}, make_unique<ast::NumericConst>(level) });
+            methods.push_back({ runtime::Symbol("Set"s + suffix), {"x"}, make_unique<ast::None>() });
+
+            const runtime::Class* parent = hierarchy.empty() ? nullptr : hierarchy.back().get();
+            hierarchy.push_back(make_unique<runtime::Class>("Level"s + suffix, move(methods), parent));
+        }
+        return hierarchy;
+    }
+
+    template <typename Body>
+    void Measure(const string& name, Body body) {
+        const auto start = chrono::steady_clock::now();
+        for (int i = 0; i < ITERATIONS; ++i) {
+            body();
+        }
+        const auto elapsed = chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start);
+        cout << name << ": "sv << static_cast<double>(elapsed.count()) / ITERATIONS << " ns/op"sv << endl;
+    }
+
+}  // namespace
+
+int main() {
+    const auto hierarchy = MakeHierarchy();
+    const runtime::Class& leaf = *hierarchy.back();
+    const runtime::Symbol get = "Get";
+    const runtime::Symbol missing = "Missing";
+
+    size_t found = 0;
+    Measure("GetMethod, root method"s, [&] {
+        found += leaf.GetMethod(get) != nullptr;
+    });
+    Measure("GetMethod, missing method"s, [&] {
+        found += leaf.GetMethod(missing) != nullptr;
+    });
+
+    runtime::ClassInstance instance(leaf);
+    const runtime::ObjectHolder lhs = runtime::ObjectHolder::Share(instance);
+    const runtime::ObjectHolder rhs = runtime::ObjectHolder::Share(instance);
+    runtime::DummyContext context;
+    Measure("Equal via root __eq__"s, [&] {
+        found += runtime::Equal(lhs, rhs, context);
+    });
+    Measure("Call of root method"s, [&] {
+        found += instance.Call(get, {}, context).TryAs<runtime::Number>() != nullptr;
+    });
+
+    cout << "(checksum "sv << found << ')' << endl;
+}
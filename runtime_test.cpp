@@ -1,552 +1,892 @@
-#include "runtime.h"
-
-#include <functional>
-#include "test_runner_p.h"
-
-using namespace std;
-
-namespace runtime {
-
-    namespace {
-        class Logger : public Object {
-        public:
-            static int instance_count;
-
-            explicit Logger(int value_ = 0)
-                : id_(value_)  //
-            {
-                ++instance_count;
-            }
-
-            Logger(const Logger& rhs)
-                : id_(rhs.id_)  //
-            {
-                ++instance_count;
-            }
-
-            Logger(Logger&& rhs) noexcept
-                : id_(rhs.id_)  //
-            {
-                ++instance_count;
-            }
-
-            Logger& operator=(const Logger& /*rhs*/) = default;
-            Logger& operator=(Logger&& /*rhs*/) = default;
-
-            [[nodiscard]] int GetId() const {
-                return id_;
-            }
-
-            ~Logger()  // NOLINT(hicpp-use-override,modernize-use-override)
-            {
-                --instance_count;
-            }
-
-            void Print(ostream& os, [[maybe_unused]] Context& context) override {
-                os << id_;
-            }
-
-        private:
-            int id_;
-        };
-
-        int Logger::instance_count = 0;
-
-        void TestNumber() {
-            Number num(127);
-
-            DummyContext context;
-
-            num.Print(context.output, context);
-            ASSERT_EQUAL(context.output.str(), "127"s);
-            ASSERT_EQUAL(num.GetValue(), 127);
-        }
-
-        void TestString() {
-            String word("hello!"s);
-
-            DummyContext context;
-            word.Print(context.output, context);
-            ASSERT_EQUAL(context.output.str(), "hello!"s);
-            ASSERT_EQUAL(word.GetValue(), "hello!"s);
-        }
-
-        void TestBool() {
-            Bool t(true);
-            ASSERT_EQUAL(t.GetValue(), true);
-
-            DummyContext context;
-            ostringstream out;
-            t.Print(out, context);
-            ASSERT_EQUAL(out.str(), "True"s);
-            out.str({});
-
-            Bool f(false);
-            ASSERT_EQUAL(f.GetValue(), false);
-
-            f.Print(out, context);
-            ASSERT_EQUAL(out.str(), "False"s);
-
-            ASSERT(context.output.str().empty());
-        }
-
-        struct TestMethodBody : Executable {
-            using Fn = std::function<ObjectHolder(Closure& closure, Context& context)>;
-            Fn body;
-
-            explicit TestMethodBody(Fn body)
-                : body(std::move(body)) {
-            }
-
-            ObjectHolder Execute(Closure& closure, Context& context) override {
-                if (body) {
-                    return body(closure, context);
-                }
-                return {};
-            }
-        };
-
-        void TestMethodInvocation() {
-            DummyContext context;
-            Closure base_closure;
-            auto base_method_1 = [&base_closure, &context](Closure& closure, Context& ctx) {
-                ASSERT_EQUAL(&context, &ctx);
-                base_closure = closure;
-                return ObjectHolder::Own(Number{ 123 });
-            };
-            auto base_method_2 = [&base_closure, &context](Closure& closure, Context& ctx) {
-                ASSERT_EQUAL(&context, &ctx);
-                base_closure = closure;
-                return ObjectHolder::Own(Number{ 456 });
-            };
-            vector<Method> base_methods;
-            base_methods.push_back(
-                { "test"s, {"arg1"s, "arg2"s}, make_unique<TestMethodBody>(base_method_1) });
-            base_methods.push_back({ "test_2"s, {"arg1"s}, make_unique<TestMethodBody>(base_method_2) });
-            Class base_class{ "Base"s, std::move(base_methods), nullptr };
-            ClassInstance base_inst{ base_class };
-            base_inst.Fields()["base_field"s] = ObjectHolder::Own(String{ "hello"s });
-            ASSERT(base_inst.HasMethod("test"s, 2U));
-            auto res = base_inst.Call(
-                "test"s, { ObjectHolder::Own(Number{1}), ObjectHolder::Own(String{"abc"s}) }, context);
-            ASSERT(Equal(res, ObjectHolder::Own(Number{ 123 }), context));
-            ASSERT_EQUAL(base_closure.size(), 3U);
-            ASSERT_EQUAL(base_closure.count("self"s), 1U);
-            ASSERT_EQUAL(base_closure.at("self"s).Get(), &base_inst);
-            ASSERT_EQUAL(base_closure.count("self"s), 1U);
-            ASSERT_EQUAL(base_closure.count("arg1"s), 1U);
-            ASSERT(Equal(base_closure.at("arg1"s), ObjectHolder::Own(Number{ 1 }), context));
-            ASSERT_EQUAL(base_closure.count("arg2"s), 1U);
-            ASSERT(Equal(base_closure.at("arg2"s), ObjectHolder::Own(String{ "abc"s }), context));
-            ASSERT_EQUAL(base_closure.count("base_field"s), 0U);
-
-            Closure child_closure;
-            auto child_method_1 = [&child_closure, &context](Closure& closure, Context& ctx) {
-                ASSERT_EQUAL(&context, &ctx);
-                child_closure = closure;
-                return ObjectHolder::Own(String("child"s));
-            };
-            vector<Method> child_methods;
-            child_methods.push_back(
-                { "test"s, {"arg1_child"s, "arg2_child"s}, make_unique<TestMethodBody>(child_method_1) });
-            Class child_class{ "Child"s, std::move(child_methods), &base_class };
-            ClassInstance child_inst{ child_class };
-            ASSERT(child_inst.HasMethod("test"s, 2U));
-            base_closure.clear();
-            res = child_inst.Call(
-                "test"s, { ObjectHolder::Own(String{"value1"s}), ObjectHolder::Own(String{"value2"s}) },
-                context);
-            ASSERT(Equal(res, ObjectHolder::Own(String{ "child"s }), context));
-            ASSERT(base_closure.empty());
-            ASSERT_EQUAL(child_closure.size(), 3U);
-            ASSERT_EQUAL(child_closure.count("self"s), 1U);
-            ASSERT_EQUAL(child_closure.at("self"s).Get(), &child_inst);
-            ASSERT_EQUAL(child_closure.count("arg1_child"s), 1U);
-            ASSERT(Equal(child_closure.at("arg1_child"s), (ObjectHolder::Own(String{ "value1"s })), context));
-            ASSERT_EQUAL(child_closure.count("arg2_child"s), 1U);
-            ASSERT(Equal(child_closure.at("arg2_child"s), (ObjectHolder::Own(String{ "value2"s })), context));
-
-            ASSERT(child_inst.HasMethod("test_2"s, 1U));
-            child_closure.clear();
-            res = child_inst.Call("test_2"s, { ObjectHolder::Own(String{":)"s}) }, context);
-            ASSERT(Equal(res, ObjectHolder::Own(Number{ 456 }), context));
-            ASSERT_EQUAL(base_closure.size(), 2U);
-            ASSERT_EQUAL(base_closure.count("self"s), 1U);
-            ASSERT_EQUAL(base_closure.at("self"s).Get(), &child_inst);
-            ASSERT_EQUAL(base_closure.count("arg1"s), 1U);
-            ASSERT(Equal(base_closure.at("arg1"s), (ObjectHolder::Own(String{ ":)"s })), context));
-
-            ASSERT(!child_inst.HasMethod("test"s, 1U));
-            ASSERT_THROWS(child_inst.Call("test"s, { ObjectHolder::None() }, context), runtime_error);
-        }
-
-        void TestNonowning() {
-            ASSERT_EQUAL(Logger::instance_count, 0);
-            Logger logger(784);
-            {
-                auto oh = ObjectHolder::Share(logger);
-                ASSERT(oh);
-            }
-            ASSERT_EQUAL(Logger::instance_count, 1);
-
-            auto oh = ObjectHolder::Share(logger);
-            ASSERT(oh);
-            ASSERT(oh.Get() == &logger);
-
-            DummyContext context;
-            oh->Print(context.output, context);
-
-            ASSERT_EQUAL(context.output.str(), "784"sv);
-        }
-
-        void TestOwning() {
-            ASSERT_EQUAL(Logger::instance_count, 0);
-            {
-                auto oh = ObjectHolder::Own(Logger());
-                ASSERT(oh);
-                ASSERT_EQUAL(Logger::instance_count, 1);
-            }
-            ASSERT_EQUAL(Logger::instance_count, 0);
-
-            auto oh = ObjectHolder::Own(Logger(312));
-            ASSERT(oh);
-            ASSERT_EQUAL(Logger::instance_count, 1);
-
-            DummyContext context;
-            oh->Print(context.output, context);
-
-            ASSERT_EQUAL(context.output.str(), "312"sv);
-        }
-
-        void TestMove() {
-            {
-                ASSERT_EQUAL(Logger::instance_count, 0);
-                Logger logger;
-
-                auto one = ObjectHolder::Share(logger);
-                ObjectHolder two = std::move(one);
-
-                ASSERT_EQUAL(Logger::instance_count, 1);
-                ASSERT(two.Get() == &logger);
-            }
-            {
-                ASSERT_EQUAL(Logger::instance_count, 0);
-                auto one = ObjectHolder::Own(Logger());
-                ASSERT_EQUAL(Logger::instance_count, 1);
-                Object* stored = one.Get();
-                ObjectHolder two = std::move(one);
-                ASSERT_EQUAL(Logger::instance_count, 1);
-
-                ASSERT(two.Get() == stored);
-                ASSERT(!one);  // NOLINT
-            }
-        }
-
-        void TestNullptr() {
-            ObjectHolder oh;
-            ASSERT(!oh);
-            ASSERT(!oh.Get());
-        }
-
-        void TestIsTrue() {
-            {
-                ASSERT(!IsTrue(ObjectHolder::Own(Bool{ false })));
-                ASSERT(IsTrue(ObjectHolder::Own(Bool{ true })));
-            }
-
-            ASSERT(!IsTrue(ObjectHolder::None()));  // None is false
-
-            // Number equal to 0 is false. The rest are true
-            {
-                ASSERT(!IsTrue(ObjectHolder::Own(Number{ 0 })));
-                ASSERT(IsTrue(ObjectHolder::Own(Number{ 1 })));
-                ASSERT(IsTrue(ObjectHolder::Own(Number{ -1 })));
-                ASSERT(IsTrue(ObjectHolder::Own(Number{ 42 })));
-            }
-
-            // Empty string is equal to false. Non empty string is equal to true
-            {
-                ASSERT(!IsTrue(ObjectHolder::Own(String{ ""s })));
-                ASSERT(IsTrue(ObjectHolder::Own(String{ "0"s })));
-                ASSERT(IsTrue(ObjectHolder::Own(String{ "1"s })));
-                ASSERT(IsTrue(ObjectHolder::Own(String{ "abc"s })));
-                ASSERT(IsTrue(ObjectHolder::Own(String{ "True"s })));
-                ASSERT(IsTrue(ObjectHolder::Own(String{ "False"s })));
-            }
-
-            // Class and ClassInstance objects are converted to false
-            {
-                Class cls{ "Test"s, {}, nullptr };
-                ASSERT(!IsTrue(ObjectHolder::Share(cls)));
-                ASSERT(!IsTrue(ObjectHolder::Own(ClassInstance{ cls })));
-            }
-        }
-
-        void TestComparison() {
-            auto test_equal = [](const ObjectHolder& lhs, const ObjectHolder& rhs, bool equality_result) {
-                DummyContext ctx;
-                ASSERT(Equal(lhs, rhs, ctx) == equality_result);
-                ASSERT(NotEqual(lhs, rhs, ctx) == !equality_result);
-            };
-
-            auto test_less = [](const ObjectHolder& lhs, const ObjectHolder& rhs, bool less_result) {
-                DummyContext ctx;
-                ASSERT(Less(lhs, rhs, ctx) == less_result);
-                ASSERT(GreaterOrEqual(lhs, rhs, ctx) == !less_result);
-            };
-
-            auto test_greater = [](const ObjectHolder& lhs, const ObjectHolder& rhs, bool greater_result) {
-                DummyContext ctx;
-                ASSERT(Greater(lhs, rhs, ctx) == greater_result);
-                ASSERT(LessOrEqual(lhs, rhs, ctx) == !greater_result);
-            };
-
-            auto test_eq_uncomparable = [](const ObjectHolder& lhs, const ObjectHolder& rhs) {
-                DummyContext ctx;
-                ASSERT_THROWS(Equal(lhs, rhs, ctx), runtime_error);
-                ASSERT_THROWS(NotEqual(lhs, rhs, ctx), runtime_error);
-            };
-
-            auto test_lt_uncomparable = [](const ObjectHolder& lhs, const ObjectHolder& rhs) {
-                DummyContext ctx;
-                ASSERT_THROWS(Less(lhs, rhs, ctx), runtime_error);
-                ASSERT_THROWS(GreaterOrEqual(lhs, rhs, ctx), runtime_error);
-            };
-
-            auto test_gt_uncomparable = [](const ObjectHolder& lhs, const ObjectHolder& rhs) {
-                DummyContext ctx;
-                ASSERT_THROWS(Greater(lhs, rhs, ctx), runtime_error);
-                ASSERT_THROWS(LessOrEqual(lhs, rhs, ctx), runtime_error);
-            };
-
-            // Numbers
-            {
-                test_equal(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 3 }), true);
-                test_equal(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 4 }), false);
-                test_equal(ObjectHolder::Own(Number{ 4 }), ObjectHolder::Own(Number{ 3 }), false);
-
-                test_less(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 4 }), true);
-                test_less(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 3 }), false);
-                test_less(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 2 }), false);
-
-                test_greater(ObjectHolder::Own(Number{ 4 }), ObjectHolder::Own(Number{ 2 }), true);
-                test_greater(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 3 }), false);
-                test_greater(ObjectHolder::Own(Number{ 2 }), ObjectHolder::Own(Number{ 3 }), false);
-
-                // Numbers can not be compared to other types
-                test_eq_uncomparable(ObjectHolder::Own(Number{ 4 }), ObjectHolder::Own(String{ "4"s }));
-                test_eq_uncomparable(ObjectHolder::Own(Number{ 0 }), ObjectHolder::Own(Bool{ false }));
-
-                test_lt_uncomparable(ObjectHolder::Own(Number{ 0 }), ObjectHolder::Own(Bool{ false }));
-                test_gt_uncomparable(ObjectHolder::Own(Number{ 0 }), ObjectHolder::Own(String{ "test"s }));
-            }
-
-            // Strings
-            {
-                test_equal(ObjectHolder::Own(String{ ""s }), ObjectHolder::Own(String{ ""s }), true);
-                test_equal(ObjectHolder::Own(String{ "1"s }), ObjectHolder::Own(String{ ""s }), false);
-                test_equal(ObjectHolder::Own(String{ ""s }), ObjectHolder::Own(String{ "1"s }), false);
-                test_equal(ObjectHolder::Own(String{ "Hello"s }), ObjectHolder::Own(String{ "Hello"s }), true);
-                test_equal(ObjectHolder::Own(String{ "Hello"s }), ObjectHolder::Own(String{ "hello"s }), false);
-
-                test_less(ObjectHolder::Own(String{ ""s }), ObjectHolder::Own(String{ "1"s }), true);
-                test_less(ObjectHolder::Own(String{ "abb"s }), ObjectHolder::Own(String{ "abc"s }), true);
-                test_less(ObjectHolder::Own(String{ ""s }), ObjectHolder::Own(String{ ""s }), false);
-                test_less(ObjectHolder::Own(String{ "abc"s }), ObjectHolder::Own(String{ "abc"s }), false);
-                test_less(ObjectHolder::Own(String{ "abc"s }), ObjectHolder::Own(String{ "abb"s }), false);
-
-                test_greater(ObjectHolder::Own(String{ "1"s }), ObjectHolder::Own(String{ ""s }), true);
-                test_greater(ObjectHolder::Own(String{ "abc"s }), ObjectHolder::Own(String{ "abb"s }), true);
-                test_greater(ObjectHolder::Own(String{ ""s }), ObjectHolder::Own(String{ ""s }), false);
-                test_greater(ObjectHolder::Own(String{ "abc"s }), ObjectHolder::Own(String{ "abc"s }), false);
-                test_greater(ObjectHolder::Own(String{ "abb"s }), ObjectHolder::Own(String{ "abc"s }), false);
-
-                // Strings can not be compared to other types
-                test_eq_uncomparable(ObjectHolder::Own(String{ "123"s }), ObjectHolder::Own(Number{ 123 }));
-                test_eq_uncomparable(ObjectHolder::Own(String{ "True"s }), ObjectHolder::Own(Bool{ true }));
-
-                test_lt_uncomparable(ObjectHolder::Own(String{ "123"s }), ObjectHolder::Own(Number{ 123 }));
-                test_lt_uncomparable(ObjectHolder::Own(String{ "True"s }), ObjectHolder::Own(Bool{ true }));
-
-                test_gt_uncomparable(ObjectHolder::Own(String{ "123"s }), ObjectHolder::Own(Number{ 123 }));
-                test_gt_uncomparable(ObjectHolder::Own(String{ "True"s }), ObjectHolder::Own(Bool{ true }));
-            }
-
-            // Booleans
-            {
-                test_equal(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ true }), true);
-                test_equal(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ false }), true);
-                test_equal(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ true }), false);
-                test_equal(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ false }), false);
-
-                test_less(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ true }), true);
-                test_less(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ true }), false);
-                test_less(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ false }), false);
-                test_less(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ false }), false);
-
-                test_greater(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ true }), false);
-                test_greater(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ true }), false);
-                test_greater(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ false }), false);
-                test_greater(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ false }), true);
-
-                // Booleans can not be compared to other types
-                test_eq_uncomparable(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(String{ "true"s }));
-                test_eq_uncomparable(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Number{ 0 }));
-
-                test_lt_uncomparable(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(String{ "true"s }));
-                test_lt_uncomparable(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Number{ 0 }));
-
-                test_gt_uncomparable(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(String{ "true"s }));
-                test_gt_uncomparable(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Number{ 0 }));
-            }
-
-            // None
-            {
-                test_equal(ObjectHolder::None(), ObjectHolder::None(), true);
-
-                test_eq_uncomparable(ObjectHolder::None(), ObjectHolder::Own(Bool{ false }));
-                test_eq_uncomparable(ObjectHolder::None(), ObjectHolder::Own(String{ "None"s }));
-
-                test_lt_uncomparable(ObjectHolder::None(), ObjectHolder::None());
-                test_gt_uncomparable(ObjectHolder::None(), ObjectHolder::None());
-            }
-
-            // Class instances
-            {
-                Closure eq_closure;
-                auto eq_result = ObjectHolder::Own(Bool{ true });
-                auto eq_body = [&eq_closure, &eq_result](Closure& closure, [[maybe_unused]] Context& ctx) {
-                    eq_closure = closure;
-                    return eq_result;
-                };
-
-                Closure lt_closure;
-                auto lt_result = ObjectHolder::Own(Bool{ true });
-                auto lt_body = [&lt_closure, &lt_result](Closure& closure, [[maybe_unused]] Context& ctx) {
-                    lt_closure = closure;
-                    return lt_result;
-                };
-
-                std::vector<Method> cls1_methods;
-                cls1_methods.push_back({ "__eq__"s, {"rhs"s}, std::make_unique<TestMethodBody>(eq_body) });
-                cls1_methods.push_back({ "__lt__"s, {"rhs"s}, std::make_unique<TestMethodBody>(lt_body) });
-                Class cls1{ "Class1"s, std::move(cls1_methods), nullptr };
-                ClassInstance lhs{ cls1 };
-
-                Class cls2{ "Class2"s, {}, nullptr };
-                ClassInstance rhs{ cls2 };
-
-                // Equal / NotEqual
-                eq_result = ObjectHolder::Own(Bool{ true });
-                test_equal(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), true);
-                ASSERT(eq_closure.at("self"s).TryAs<ClassInstance>() == &lhs);
-                ASSERT(eq_closure.at("rhs"s).TryAs<ClassInstance>() == &rhs);
-                ASSERT(lt_closure.empty());
-                eq_result = ObjectHolder::Own(Bool{ false });
-                test_equal(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), false);
-                eq_closure.clear();
-                lt_closure.clear();
-
-                // Less / GreaterOrEqual
-                eq_result = ObjectHolder::Own(Bool{ false });
-                lt_result = ObjectHolder::Own(Bool{ true });
-                test_less(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), true);
-                ASSERT(lt_closure.at("self"s).TryAs<ClassInstance>() == &lhs);
-                ASSERT(lt_closure.at("rhs"s).TryAs<ClassInstance>() == &rhs);
-                ASSERT(eq_closure.empty());
-                eq_result = ObjectHolder::Own(Bool{ true });
-                lt_result = ObjectHolder::Own(Bool{ false });
-                test_less(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), false);
-                eq_closure.clear();
-                lt_closure.clear();
-
-                // Greater / LessOrEqual
-                eq_result = ObjectHolder::Own(Bool{ false });
-                lt_result = ObjectHolder::Own(Bool{ false });
-                test_greater(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), true);
-                ASSERT(eq_closure.at("self"s).TryAs<ClassInstance>() == &lhs);
-                ASSERT(eq_closure.at("rhs"s).TryAs<ClassInstance>() == &rhs);
-                ASSERT(lt_closure.at("self"s).TryAs<ClassInstance>() == &lhs);
-                ASSERT(lt_closure.at("rhs"s).TryAs<ClassInstance>() == &rhs);
-                eq_result = ObjectHolder::Own(Bool{ true });
-                lt_result = ObjectHolder::Own(Bool{ true });
-                test_greater(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), false);
-            }
-        }
-
-        void TestClass() {
-            vector<Method> methods;
-            Closure* passed_closure = nullptr;
-            Context* passed_context = nullptr;
-            auto body = [&passed_closure, &passed_context](Closure& closure, Context& ctx) {
-                passed_closure = &closure;
-                passed_context = &ctx;
-                return ObjectHolder::Own(Number{ 42 });
-            };
-            methods.push_back({ "method"s, {"arg1"s, "arg2"s}, make_unique<TestMethodBody>(body) });
-            Class cls{ "Test"s, move(methods), nullptr };
-            ASSERT_EQUAL(cls.GetName(), "Test"s);
-            ASSERT_EQUAL(cls.GetMethod("missing_method"s), nullptr);
-
-            const Method* method = cls.GetMethod("method"s);
-            ASSERT(method != nullptr);
-            DummyContext ctx;
-            Closure closure;
-            auto result = method->body->Execute(closure, ctx);
-            ASSERT_EQUAL(passed_context, &ctx);
-            ASSERT_EQUAL(passed_closure, &closure);
-            const Number* returned_number = result.TryAs<Number>();
-            ASSERT(returned_number != nullptr && returned_number->GetValue() == 42);
-
-            ostringstream out;
-            cls.Print(out, ctx);
-            ASSERT(ctx.output.str().empty());
-            ASSERT_EQUAL(out.str(), "Class Test"s);
-        }
-
-        void TestClassInstance() {
-            vector<Method> methods;
-
-            Closure passed_closure;
-            auto str_body = [&passed_closure](Closure& closure, [[maybe_unused]] Context& ctx) {
-                passed_closure = closure;
-                return ObjectHolder::Own(String{ "result"s });
-            };
-
-            methods.push_back({ "__str__", {}, make_unique<TestMethodBody>(str_body) });
-
-            Class cls{ "Test"s, move(methods), nullptr };
-            ClassInstance instance{ cls };
-
-            ASSERT_EQUAL(&instance.Fields(), &const_cast<const ClassInstance&>(instance).Fields());
-            ASSERT(instance.HasMethod("__str__"s, 0));
-
-            ostringstream out;
-            DummyContext ctx;
-            instance.Print(out, ctx);
-            ASSERT_EQUAL(out.str(), "result"s);
-
-            ASSERT_THROWS(instance.Call("missing_method"s, {}, ctx), runtime_error);
-        }
-
-    }  // namespace
-
-    void RunObjectsTests(TestRunner& tr) {
-        RUN_TEST(tr, runtime::TestNumber);
-        RUN_TEST(tr, runtime::TestString);
-        RUN_TEST(tr, runtime::TestBool);
-        RUN_TEST(tr, runtime::TestMethodInvocation);
-        RUN_TEST(tr, runtime::TestIsTrue);
-        RUN_TEST(tr, runtime::TestComparison);
-        RUN_TEST(tr, runtime::TestClass);
-        RUN_TEST(tr, runtime::TestClassInstance);
-    }
-
-    void RunObjectHolderTests(TestRunner& tr) {
-        RUN_TEST(tr, runtime::TestNonowning);
-        RUN_TEST(tr, runtime::TestOwning);
-        RUN_TEST(tr, runtime::TestMove);
-        RUN_TEST(tr, runtime::TestNullptr);
-    }
-
+#include "runtime.h"
+
+#include <functional>
+#include <limits>
+#include <thread>
+#include "test_runner_p.h"
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        class Logger : public Object {
+        public:
+            static int instance_count;
+
+            explicit Logger(int value_ = 0)
+                : id_(value_)  //
+            {
+                ++instance_count;
+            }
+
+            Logger(const Logger& rhs)
+                : Object(rhs)
+                , id_(rhs.id_)  //
+            {
+                ++instance_count;
+            }
+
+            Logger(Logger&& rhs) noexcept
+                : id_(rhs.id_)  //
+            {
+                ++instance_count;
+            }
+
+            Logger& operator=(const Logger& /*rhs*/) = default;
+            Logger& operator=(Logger&& /*rhs*/) = default;
+
+            [[nodiscard]] int GetId() const {
+                return id_;
+            }
+
+            ~Logger()  // NOLINT(hicpp-use-override,modernize-use-override)
+            {
+                --instance_count;
+            }
+
+            void Print(ostream& os, [[maybe_unused]] Context& context) override {
+                os << id_;
+            }
+
+        private:
+            int id_;
+        };
+
+        int Logger::instance_count = 0;
+
+        void TestNumber() {
+            Number num(127);
+
+            DummyContext context;
+
+            num.Print(context.output, context);
+            ASSERT_EQUAL(context.output.str(), "127"s);
+            ASSERT_EQUAL(num.GetValue(), 127);
+        }
+
+        void TestString() {
+            String word("hello!"s);
+
+            DummyContext context;
+            word.Print(context.output, context);
+            ASSERT_EQUAL(context.output.str(), "hello!"s);
+            ASSERT_EQUAL(word.GetValue(), "hello!"s);
+        }
+
+        void TestBool() {
+            Bool t(true);
+            ASSERT_EQUAL(t.GetValue(), true);
+
+            DummyContext context;
+            ostringstream out;
+            t.Print(out, context);
+            ASSERT_EQUAL(out.str(), "True"s);
+            out.str({});
+
+            Bool f(false);
+            ASSERT_EQUAL(f.GetValue(), false);
+
+            f.Print(out, context);
+            ASSERT_EQUAL(out.str(), "False"s);
+
+            ASSERT(context.output.str().empty());
+        }
+
+        struct TestMethodBody : Executable {
+            using Fn = std::function<ObjectHolder(Closure& closure, Context& context)>;
+            Fn body;
+
+            explicit TestMethodBody(Fn body)
+                : body(std::move(body)) {
+            }
+
+            ObjectHolder Execute(Closure& closure, Context& context) override {
+                if (body) {
+                    return body(closure, context);
+                }
+                return {};
+            }
+        };
+
+        void TestMethodInvocation() {
+            DummyContext context;
+            Closure base_closure;
+            auto base_method_1 = [&base_closure, &context](Closure& closure, Context& ctx) {
+                ASSERT_EQUAL(&context, &ctx);
+                base_closure = closure;
+                return ObjectHolder::Own(Number{ 123 });
+            };
+            auto base_method_2 = [&base_closure, &context](Closure& closure, Context& ctx) {
+                ASSERT_EQUAL(&context, &ctx);
+                base_closure = closure;
+                return ObjectHolder::Own(Number{ 456 });
+            };
+            vector<Method> base_methods;
+            base_methods.push_back(
+                { "test", {"arg1", "arg2"}, make_unique<TestMethodBody>(base_method_1) });
+            base_methods.push_back({ "test_2", {"arg1"}, make_unique<TestMethodBody>(base_method_2) });
+            Class base_class{ "Base"s, std::move(base_methods), nullptr };
+            ClassInstance base_inst{ base_class };
+            base_inst.Fields()["base_field"] = ObjectHolder::Own(String{ "hello"s });
+            ASSERT(base_inst.HasMethod("test", 2U));
+            auto res = base_inst.Call(
+                "test", { ObjectHolder::Own(Number{1}), ObjectHolder::Own(String{"abc"s}) }, context);
+            ASSERT(Equal(res, ObjectHolder::Own(Number{ 123 }), context));
+            ASSERT_EQUAL(base_closure.size(), 3U);
+            ASSERT_EQUAL(base_closure.count("self"), 1U);
+            ASSERT_EQUAL(base_closure.at("self").Get(), &base_inst);
+            ASSERT_EQUAL(base_closure.count("self"), 1U);
+            ASSERT_EQUAL(base_closure.count("arg1"), 1U);
+            ASSERT(Equal(base_closure.at("arg1"), ObjectHolder::Own(Number{ 1 }), context));
+            ASSERT_EQUAL(base_closure.count("arg2"), 1U);
+            ASSERT(Equal(base_closure.at("arg2"), ObjectHolder::Own(String{ "abc"s }), context));
+            ASSERT_EQUAL(base_closure.count("base_field"), 0U);
+
+            Closure child_closure;
+            auto child_method_1 = [&child_closure, &context](Closure& closure, Context& ctx) {
+                ASSERT_EQUAL(&context, &ctx);
+                child_closure = closure;
+                return ObjectHolder::Own(String("child"s));
+            };
+            vector<Method> child_methods;
+            child_methods.push_back(
+                { "test", {"arg1_child", "arg2_child"}, make_unique<TestMethodBody>(child_method_1) });
+            Class child_class{ "Child"s, std::move(child_methods), &base_class };
+            ClassInstance child_inst{ child_class };
+            ASSERT(child_inst.HasMethod("test", 2U));
+            base_closure.clear();
+            res = child_inst.Call(
+                "test", { ObjectHolder::Own(String{"value1"s}), ObjectHolder::Own(String{"value2"s}) },
+                context);
+            ASSERT(Equal(res, ObjectHolder::Own(String{ "child"s }), context));
+            ASSERT(base_closure.empty());
+            ASSERT_EQUAL(child_closure.size(), 3U);
+            ASSERT_EQUAL(child_closure.count("self"), 1U);
+            ASSERT_EQUAL(child_closure.at("self").Get(), &child_inst);
+            ASSERT_EQUAL(child_closure.count("arg1_child"), 1U);
+            ASSERT(Equal(child_closure.at("arg1_child"), (ObjectHolder::Own(String{ "value1"s })), context));
+            ASSERT_EQUAL(child_closure.count("arg2_child"), 1U);
+            ASSERT(Equal(child_closure.at("arg2_child"), (ObjectHolder::Own(String{ "value2"s })), context));
+
+            ASSERT(child_inst.HasMethod("test_2", 1U));
+            child_closure.clear();
+            res = child_inst.Call("test_2", { ObjectHolder::Own(String{":)"s}) }, context);
+            ASSERT(Equal(res, ObjectHolder::Own(Number{ 456 }), context));
+            ASSERT_EQUAL(base_closure.size(), 2U);
+            ASSERT_EQUAL(base_closure.count("self"), 1U);
+            ASSERT_EQUAL(base_closure.at("self").Get(), &child_inst);
+            ASSERT_EQUAL(base_closure.count("arg1"), 1U);
+            ASSERT(Equal(base_closure.at("arg1"), (ObjectHolder::Own(String{ ":)"s })), context));
+
+            ASSERT(!child_inst.HasMethod("test", 1U));
+            ASSERT_THROWS(child_inst.Call("test", { ObjectHolder::None() }, context), runtime_error);
+        }
+
+        void TestNonowning() {
+            ASSERT_EQUAL(Logger::instance_count, 0);
+            Logger logger(784);
+            {
+                auto oh = ObjectHolder::Share(logger);
+                ASSERT(oh);
+            }
+            ASSERT_EQUAL(Logger::instance_count, 1);
+
+            auto oh = ObjectHolder::Share(logger);
+            ASSERT(oh);
+            ASSERT(oh.Get() == &logger);
+
+            DummyContext context;
+            oh->Print(context.output, context);
+
+            ASSERT_EQUAL(context.output.str(), "784"sv);
+        }
+
+        void TestOwning() {
+            ASSERT_EQUAL(Logger::instance_count, 0);
+            {
+                auto oh = ObjectHolder::Own(Logger());
+                ASSERT(oh);
+                ASSERT_EQUAL(Logger::instance_count, 1);
+            }
+            ASSERT_EQUAL(Logger::instance_count, 0);
+
+            auto oh = ObjectHolder::Own(Logger(312));
+            ASSERT(oh);
+            ASSERT_EQUAL(Logger::instance_count, 1);
+
+            DummyContext context;
+            oh->Print(context.output, context);
+
+            ASSERT_EQUAL(context.output.str(), "312"sv);
+        }
+
+        void TestMove() {
+            {
+                ASSERT_EQUAL(Logger::instance_count, 0);
+                Logger logger;
+
+                auto one = ObjectHolder::Share(logger);
+                ObjectHolder two = std::move(one);
+
+                ASSERT_EQUAL(Logger::instance_count, 1);
+                ASSERT(two.Get() == &logger);
+            }
+            {
+                ASSERT_EQUAL(Logger::instance_count, 0);
+                auto one = ObjectHolder::Own(Logger());
+                ASSERT_EQUAL(Logger::instance_count, 1);
+                Object* stored = one.Get();
+                ObjectHolder two = std::move(one);
+                ASSERT_EQUAL(Logger::instance_count, 1);
+
+                ASSERT(two.Get() == stored);
+                ASSERT(!one);  // NOLINT
+            }
+        }
+
+        void TestCopies() {
+            ASSERT_EQUAL(Logger::instance_count, 0);
+            {
+                auto one = ObjectHolder::Own(Logger(5));
+                ObjectHolder two = one;
+                {
+                    ObjectHolder three;
+                    three = two;
+                    ASSERT(three.Get() == one.Get());
+                }
+                one = ObjectHolder::None();
+                ASSERT_EQUAL(Logger::instance_count, 1);
+                two = ObjectHolder::Own(Number(1));
+                ASSERT_EQUAL(Logger::instance_count, 0);
+            }
+            {
+                // Copies of an object are new objects, freed with their own holders
+                auto one = ObjectHolder::Own(Logger(7));
+                auto two = ObjectHolder::Own(Logger(*one.TryAs<Logger>()));
+                one = {};
+                ASSERT_EQUAL(Logger::instance_count, 1);
+            }
+            ASSERT_EQUAL(Logger::instance_count, 0);
+        }
+
+        void TestSharedAcrossThreads() {
+            ASSERT_EQUAL(Logger::instance_count, 0);
+            {
+                auto shared = ObjectHolder::Own(Logger(9));
+                shared->ShareAcrossThreads();
+                vector<thread> threads;
+                for (int t = 0; t < 4; ++t) {
+                    threads.emplace_back([shared]() {
+                        for (int i = 0; i < 10'000; ++i) {
+                            ObjectHolder copy = shared;
+                            ASSERT(copy.TryAs<Logger>() != nullptr);
+                        }
+                    });
+                }
+                for (thread& t : threads) {
+                    t.join();
+                }
+                ASSERT_EQUAL(Logger::instance_count, 1);
+            }
+            ASSERT_EQUAL(Logger::instance_count, 0);
+        }
+
+        void TestNullptr() {
+            ObjectHolder oh;
+            ASSERT(!oh);
+            ASSERT(!oh.Get());
+        }
+
+        void TestIsTrue() {
+            {
+                ASSERT(!IsTrue(ObjectHolder::Own(Bool{ false })));
+                ASSERT(IsTrue(ObjectHolder::Own(Bool{ true })));
+            }
+
+            ASSERT(!IsTrue(ObjectHolder::None()));  // None is false
+
+            // Number equal to 0 is false. The rest are true
+            {
+                ASSERT(!IsTrue(ObjectHolder::Own(Number{ 0 })));
+                ASSERT(IsTrue(ObjectHolder::Own(Number{ 1 })));
+                ASSERT(IsTrue(ObjectHolder::Own(Number{ -1 })));
+                ASSERT(IsTrue(ObjectHolder::Own(Number{ 42 })));
+            }
+
+            // Empty string is equal to false. Non empty string is equal to true
+            {
+                ASSERT(!IsTrue(ObjectHolder::Own(String{ ""s })));
+                ASSERT(IsTrue(ObjectHolder::Own(String{ "0"s })));
+                ASSERT(IsTrue(ObjectHolder::Own(String{ "1"s })));
+                ASSERT(IsTrue(ObjectHolder::Own(String{ "abc"s })));
+                ASSERT(IsTrue(ObjectHolder::Own(String{ "True"s })));
+                ASSERT(IsTrue(ObjectHolder::Own(String{ "False"s })));
+            }
+
+            // Class and ClassInstance objects are converted to false
+            {
+                Class cls{ "Test"s, {}, nullptr };
+                ASSERT(!IsTrue(ObjectHolder::Share(cls)));
+                ASSERT(!IsTrue(ObjectHolder::Own(ClassInstance{ cls })));
+            }
+        }
+
+        void TestComparison() {
+            auto test_equal = [](const ObjectHolder& lhs, const ObjectHolder& rhs, bool equality_result) {
+                DummyContext ctx;
+                ASSERT(Equal(lhs, rhs, ctx) == equality_result);
+                ASSERT(NotEqual(lhs, rhs, ctx) == !equality_result);
+            };
+
+            auto test_less = [](const ObjectHolder& lhs, const ObjectHolder& rhs, bool less_result) {
+                DummyContext ctx;
+                ASSERT(Less(lhs, rhs, ctx) == less_result);
+                ASSERT(GreaterOrEqual(lhs, rhs, ctx) == !less_result);
+            };
+
+            auto test_greater = [](const ObjectHolder& lhs, const ObjectHolder& rhs, bool greater_result) {
+                DummyContext ctx;
+                ASSERT(Greater(lhs, rhs, ctx) == greater_result);
+                ASSERT(LessOrEqual(lhs, rhs, ctx) == !greater_result);
+            };
+
+            auto test_eq_uncomparable = [](const ObjectHolder& lhs, const ObjectHolder& rhs) {
+                DummyContext ctx;
+                ASSERT_THROWS(Equal(lhs, rhs, ctx), runtime_error);
+                ASSERT_THROWS(NotEqual(lhs, rhs, ctx), runtime_error);
+            };
+
+            auto test_lt_uncomparable = [](const ObjectHolder& lhs, const ObjectHolder& rhs) {
+                DummyContext ctx;
+                ASSERT_THROWS(Less(lhs, rhs, ctx), runtime_error);
+                ASSERT_THROWS(GreaterOrEqual(lhs, rhs, ctx), runtime_error);
+            };
+
+            auto test_gt_uncomparable = [](const ObjectHolder& lhs, const ObjectHolder& rhs) {
+                DummyContext ctx;
+                ASSERT_THROWS(Greater(lhs, rhs, ctx), runtime_error);
+                ASSERT_THROWS(LessOrEqual(lhs, rhs, ctx), runtime_error);
+            };
+
+            // Numbers
+            {
+                test_equal(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 3 }), true);
+                test_equal(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 4 }), false);
+                test_equal(ObjectHolder::Own(Number{ 4 }), ObjectHolder::Own(Number{ 3 }), false);
+
+                test_less(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 4 }), true);
+                test_less(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 3 }), false);
+                test_less(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 2 }), false);
+
+                test_greater(ObjectHolder::Own(Number{ 4 }), ObjectHolder::Own(Number{ 2 }), true);
+                test_greater(ObjectHolder::Own(Number{ 3 }), ObjectHolder::Own(Number{ 3 }), false);
+                test_greater(ObjectHolder::Own(Number{ 2 }), ObjectHolder::Own(Number{ 3 }), false);
+
+                // Numbers can not be compared to other types
+                test_eq_uncomparable(ObjectHolder::Own(Number{ 4 }), ObjectHolder::Own(String{ "4"s }));
+                test_eq_uncomparable(ObjectHolder::Own(Number{ 0 }), ObjectHolder::Own(Bool{ false }));
+
+                test_lt_uncomparable(ObjectHolder::Own(Number{ 0 }), ObjectHolder::Own(Bool{ false }));
+                test_gt_uncomparable(ObjectHolder::Own(Number{ 0 }), ObjectHolder::Own(String{ "test"s }));
+            }
+
+            // Strings
+            {
+                test_equal(ObjectHolder::Own(String{ ""s }), ObjectHolder::Own(String{ ""s }), true);
+                test_equal(ObjectHolder::Own(String{ "1"s }), ObjectHolder::Own(String{ ""s }), false);
+                test_equal(ObjectHolder::Own(String{ ""s }), ObjectHolder::Own(String{ "1"s }), false);
+                test_equal(ObjectHolder::Own(String{ "Hello"s }), ObjectHolder::Own(String{ "Hello"s }), true);
+                test_equal(ObjectHolder::Own(String{ "Hello"s }), ObjectHolder::Own(String{ "hello"s }), false);
+
+                test_less(ObjectHolder::Own(String{ ""s }), ObjectHolder::Own(String{ "1"s }), true);
+                test_less(ObjectHolder::Own(String{ "abb"s }), ObjectHolder::Own(String{ "abc"s }), true);
+                test_less(ObjectHolder::Own(String{ ""s }), ObjectHolder::Own(String{ ""s }), false);
+                test_less(ObjectHolder::Own(String{ "abc"s }), ObjectHolder::Own(String{ "abc"s }), false);
+                test_less(ObjectHolder::Own(String{ "abc"s }), ObjectHolder::Own(String{ "abb"s }), false);
+
+                test_greater(ObjectHolder::Own(String{ "1"s }), ObjectHolder::Own(String{ ""s }), true);
+                test_greater(ObjectHolder::Own(String{ "abc"s }), ObjectHolder::Own(String{ "abb"s }), true);
+                test_greater(ObjectHolder::Own(String{ ""s }), ObjectHolder::Own(String{ ""s }), false);
+                test_greater(ObjectHolder::Own(String{ "abc"s }), ObjectHolder::Own(String{ "abc"s }), false);
+                test_greater(ObjectHolder::Own(String{ "abb"s }), ObjectHolder::Own(String{ "abc"s }), false);
+
+                // Strings can not be compared to other types
+                test_eq_uncomparable(ObjectHolder::Own(String{ "123"s }), ObjectHolder::Own(Number{ 123 }));
+                test_eq_uncomparable(ObjectHolder::Own(String{ "True"s }), ObjectHolder::Own(Bool{ true }));
+
+                test_lt_uncomparable(ObjectHolder::Own(String{ "123"s }), ObjectHolder::Own(Number{ 123 }));
+                test_lt_uncomparable(ObjectHolder::Own(String{ "True"s }), ObjectHolder::Own(Bool{ true }));
+
+                test_gt_uncomparable(ObjectHolder::Own(String{ "123"s }), ObjectHolder::Own(Number{ 123 }));
+                test_gt_uncomparable(ObjectHolder::Own(String{ "True"s }), ObjectHolder::Own(Bool{ true }));
+            }
+
+            // Booleans
+            {
+                test_equal(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ true }), true);
+                test_equal(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ false }), true);
+                test_equal(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ true }), false);
+                test_equal(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ false }), false);
+
+                test_less(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ true }), true);
+                test_less(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ true }), false);
+                test_less(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ false }), false);
+                test_less(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ false }), false);
+
+                test_greater(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ true }), false);
+                test_greater(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ true }), false);
+                test_greater(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Bool{ false }), false);
+                test_greater(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ false }), true);
+
+                // Booleans can not be compared to other types
+                test_eq_uncomparable(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(String{ "true"s }));
+                test_eq_uncomparable(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Number{ 0 }));
+
+                test_lt_uncomparable(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(String{ "true"s }));
+                test_lt_uncomparable(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Number{ 0 }));
+
+                test_gt_uncomparable(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(String{ "true"s }));
+                test_gt_uncomparable(ObjectHolder::Own(Bool{ false }), ObjectHolder::Own(Number{ 0 }));
+            }
+
+            // None
+            {
+                test_equal(ObjectHolder::None(), ObjectHolder::None(), true);
+
+                test_eq_uncomparable(ObjectHolder::None(), ObjectHolder::Own(Bool{ false }));
+                test_eq_uncomparable(ObjectHolder::None(), ObjectHolder::Own(String{ "None"s }));
+
+                test_lt_uncomparable(ObjectHolder::None(), ObjectHolder::None());
+                test_gt_uncomparable(ObjectHolder::None(), ObjectHolder::None());
+            }
+
+            // Class instances
+            {
+                Closure eq_closure;
+                auto eq_result = ObjectHolder::Own(Bool{ true });
+                auto eq_body = [&eq_closure, &eq_result](Closure& closure, [[maybe_unused]] Context& ctx) {
+                    eq_closure = closure;
+                    return eq_result;
+                };
+
+                Closure lt_closure;
+                auto lt_result = ObjectHolder::Own(Bool{ true });
+                auto lt_body = [&lt_closure, &lt_result](Closure& closure, [[maybe_unused]] Context& ctx) {
+                    lt_closure = closure;
+                    return lt_result;
+                };
+
+                std::vector<Method> cls1_methods;
+                cls1_methods.push_back({ "__eq__", {"rhs"}, std::make_unique<TestMethodBody>(eq_body) });
+                cls1_methods.push_back({ "__lt__", {"rhs"}, std::make_unique<TestMethodBody>(lt_body) });
+                Class cls1{ "Class1"s, std::move(cls1_methods), nullptr };
+                ClassInstance lhs{ cls1 };
+
+                Class cls2{ "Class2"s, {}, nullptr };
+                ClassInstance rhs{ cls2 };
+
+                // Equal / NotEqual
+                eq_result = ObjectHolder::Own(Bool{ true });
+                test_equal(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), true);
+                ASSERT(eq_closure.at("self").TryAs<ClassInstance>() == &lhs);
+                ASSERT(eq_closure.at("rhs").TryAs<ClassInstance>() == &rhs);
+                ASSERT(lt_closure.empty());
+                eq_result = ObjectHolder::Own(Bool{ false });
+                test_equal(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), false);
+                eq_closure.clear();
+                lt_closure.clear();
+
+                // Less / GreaterOrEqual
+                eq_result = ObjectHolder::Own(Bool{ false });
+                lt_result = ObjectHolder::Own(Bool{ true });
+                test_less(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), true);
+                ASSERT(lt_closure.at("self").TryAs<ClassInstance>() == &lhs);
+                ASSERT(lt_closure.at("rhs").TryAs<ClassInstance>() == &rhs);
+                ASSERT(eq_closure.empty());
+                eq_result = ObjectHolder::Own(Bool{ true });
+                lt_result = ObjectHolder::Own(Bool{ false });
+                test_less(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), false);
+                eq_closure.clear();
+                lt_closure.clear();
+
+                // Greater / LessOrEqual
+                eq_result = ObjectHolder::Own(Bool{ false });
+                lt_result = ObjectHolder::Own(Bool{ false });
+                test_greater(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), true);
+                ASSERT(eq_closure.at("self").TryAs<ClassInstance>() == &lhs);
+                ASSERT(eq_closure.at("rhs").TryAs<ClassInstance>() == &rhs);
+                ASSERT(lt_closure.at("self").TryAs<ClassInstance>() == &lhs);
+                ASSERT(lt_closure.at("rhs").TryAs<ClassInstance>() == &rhs);
+                eq_result = ObjectHolder::Own(Bool{ true });
+                lt_result = ObjectHolder::Own(Bool{ true });
+                test_greater(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), false);
+            }
+        }
+
+        void TestComparisonCallsEachMethodOnce() {
+            int eq_calls = 0;
+            int lt_calls = 0;
+            auto eq_result = ObjectHolder::Own(Bool{ false });
+            auto lt_result = ObjectHolder::Own(Bool{ false });
+            auto eq_body = [&eq_calls, &eq_result](Closure& /*closure*/, Context& /*ctx*/) {
+                ++eq_calls;
+                return eq_result;
+            };
+            auto lt_body = [&lt_calls, &lt_result](Closure& /*closure*/, Context& /*ctx*/) {
+                ++lt_calls;
+                return lt_result;
+            };
+
+            vector<Method> methods;
+            methods.push_back({ "__eq__", {"rhs"}, make_unique<TestMethodBody>(eq_body) });
+            methods.push_back({ "__lt__", {"rhs"}, make_unique<TestMethodBody>(lt_body) });
+            Class cls{ "Ordered"s, move(methods), nullptr };
+            ClassInstance lhs{ cls };
+            ClassInstance rhs{ cls };
+
+            // Calls of __eq__ and __lt__ for each operator when neither method returns True
+            const pair<Comparator, pair<int, int>> expected_calls[] = {
+                { Comparator::Equal, { 1, 0 } },
+                { Comparator::NotEqual, { 1, 0 } },
+                { Comparator::Less, { 0, 1 } },
+                { Comparator::Greater, { 1, 1 } },
+                { Comparator::LessOrEqual, { 1, 1 } },
+                { Comparator::GreaterOrEqual, { 0, 1 } },
+            };
+            DummyContext ctx;
+            for (const auto& [cmp, calls] : expected_calls) {
+                eq_calls = 0;
+                lt_calls = 0;
+                Compare(cmp, ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), ctx);
+                ASSERT_EQUAL(eq_calls, calls.first);
+                ASSERT_EQUAL(lt_calls, calls.second);
+            }
+
+            // __lt__ returning True decides Greater and LessOrEqual without __eq__
+            lt_result = ObjectHolder::Own(Bool{ true });
+            for (const Comparator cmp : { Comparator::Greater, Comparator::LessOrEqual }) {
+                eq_calls = 0;
+                lt_calls = 0;
+                Compare(cmp, ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), ctx);
+                ASSERT_EQUAL(eq_calls, 0);
+                ASSERT_EQUAL(lt_calls, 1);
+            }
+        }
+
+        void TestCompareValues() {
+            ASSERT(CompareValues(ObjectHolder::Own(Number{ 1 }), ObjectHolder::Own(Number{ 2 })) == -1);
+            ASSERT(CompareValues(ObjectHolder::Own(String{ "b"s }), ObjectHolder::Own(String{ "a"s })) == 1);
+            ASSERT(CompareValues(ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ true })) == 0);
+            ASSERT(!CompareValues(ObjectHolder::Own(Number{ 1 }), ObjectHolder::Own(Bool{ true })));
+            ASSERT(!CompareValues(ObjectHolder::None(), ObjectHolder::None()));
+        }
+
+        void TestObjectKinds() {
+            Class cls{ "Test"s, {}, nullptr };
+            auto instance = ObjectHolder::Own(ClassInstance{ cls });
+            ASSERT(ObjectHolder::None().GetKind() == ObjectKind::None);
+            ASSERT(ObjectHolder::Own(Number{ 1 }).GetKind() == ObjectKind::Number);
+            ASSERT(ObjectHolder::Own(String{ "s"s }).GetKind() == ObjectKind::String);
+            ASSERT(ObjectHolder::Own(Bool{ false }).GetKind() == ObjectKind::Bool);
+            ASSERT(ObjectHolder::Share(cls).GetKind() == ObjectKind::Class);
+            ASSERT(instance.GetKind() == ObjectKind::ClassInstance);
+            ASSERT(ObjectHolder::Own(Logger{}).GetKind() == ObjectKind::Other);
+
+            // TryAs checks the kind for built-in types and the dynamic type otherwise
+            ASSERT(instance.TryAs<ClassInstance>() != nullptr);
+            ASSERT(instance.TryAs<Class>() == nullptr);
+            ASSERT(instance.TryAs<Logger>() == nullptr);
+            ASSERT(ObjectHolder::Own(String{ "s"s }).TryAs<Number>() == nullptr);
+            ASSERT(ObjectHolder::Own(Logger{ 5 }).TryAs<Logger>() != nullptr);
+            ASSERT(ObjectHolder::Own(Logger{ 5 }).TryAs<String>() == nullptr);
+        }
+
+        void TestClass() {
+            vector<Method> methods;
+            Closure* passed_closure = nullptr;
+            Context* passed_context = nullptr;
+            auto body = [&passed_closure, &passed_context](Closure& closure, Context& ctx) {
+                passed_closure = &closure;
+                passed_context = &ctx;
+                return ObjectHolder::Own(Number{ 42 });
+            };
+            methods.push_back({ "method", {"arg1", "arg2"}, make_unique<TestMethodBody>(body) });
+            Class cls{ "Test"s, move(methods), nullptr };
+            ASSERT_EQUAL(cls.GetName(), "Test"s);
+            ASSERT_EQUAL(cls.GetMethod("missing_method"), nullptr);
+
+            const Method* method = cls.GetMethod("method");
+            ASSERT(method != nullptr);
+            DummyContext ctx;
+            Closure closure;
+            auto result = method->body->Execute(closure, ctx);
+            ASSERT_EQUAL(passed_context, &ctx);
+            ASSERT_EQUAL(passed_closure, &closure);
+            const Number* returned_number = result.TryAs<Number>();
+            ASSERT(returned_number != nullptr && returned_number->GetValue() == 42);
+
+            ostringstream out;
+            cls.Print(out, ctx);
+            ASSERT(ctx.output.str().empty());
+            ASSERT_EQUAL(out.str(), "Class Test"s);
+
+            // The method table points into the class, so a moved class builds its own
+            static_assert(!is_copy_constructible_v<Class> && !is_move_assignable_v<Class>);
+            Class moved(std::move(cls));
+            ASSERT_EQUAL(moved.GetMethod("method"), method);
+        }
+
+        void TestClassInstance() {
+            vector<Method> methods;
+
+            Closure passed_closure;
+            auto str_body = [&passed_closure](Closure& closure, [[maybe_unused]] Context& ctx) {
+                passed_closure = closure;
+                return ObjectHolder::Own(String{ "result"s });
+            };
+
+            methods.push_back({ "__str__", {}, make_unique<TestMethodBody>(str_body) });
+
+            Class cls{ "Test"s, move(methods), nullptr };
+            ClassInstance instance{ cls };
+
+            ASSERT_EQUAL(&instance.Fields(), &const_cast<const ClassInstance&>(instance).Fields());
+            ASSERT(instance.HasMethod("__str__", 0));
+
+            ostringstream out;
+            DummyContext ctx;
+            instance.Print(out, ctx);
+            ASSERT_EQUAL(out.str(), "result"s);
+
+            ASSERT_THROWS(instance.Call("missing_method", {}, ctx), runtime_error);
+        }
+
+        void TestSymbol() {
+            const Symbol x{ "x"s };
+            ASSERT(x == Symbol("x"sv));
+            ASSERT(x == Symbol("x"));
+            ASSERT(x != Symbol("y"s));
+            ASSERT_EQUAL(&x.GetName(), &Symbol("x"s).GetName());
+            ASSERT_EQUAL(x.GetName(), "x"s);
+            ASSERT_EQUAL(Symbol().GetName(), ""s);
+
+            ostringstream out;
+            out << x;
+            ASSERT_EQUAL(out.str(), "x"s);
+        }
+
+        void TestInstanceShapes() {
+            Class cls{ "Point"s, {}, nullptr };
+            ClassInstance first{ cls };
+            ClassInstance second{ cls };
+            ASSERT_EQUAL(&first.Fields().GetShape(), &Shape::Empty());
+
+            first.Fields()["x"] = ObjectHolder::Own(Number{ 1 });
+            first.Fields()["y"] = ObjectHolder::Own(Number{ 2 });
+            second.Fields()["x"] = ObjectHolder::Own(Number{ 3 });
+            second.Fields()["y"] = ObjectHolder::Own(Number{ 4 });
+            ASSERT_EQUAL(&first.Fields().GetShape(), &second.Fields().GetShape());
+            ASSERT_EQUAL(first.Fields().GetShape().IndexOf("y"), 1U);
+
+            // Reassignment keeps the shape, another order makes another one
+            second.Fields()["x"] = ObjectHolder::Own(Number{ 5 });
+            ASSERT_EQUAL(&first.Fields().GetShape(), &second.Fields().GetShape());
+            ClassInstance third{ cls };
+            third.Fields()["y"] = ObjectHolder::None();
+            third.Fields()["x"] = ObjectHolder::None();
+            ASSERT(&first.Fields().GetShape() != &third.Fields().GetShape());
+
+            ASSERT_EQUAL(second.Fields().size(), 2U);
+            ASSERT_EQUAL(second.Fields().at("x").TryAs<Number>()->GetValue(), 5);
+            ASSERT(second.Fields().Find("z") == nullptr);
+            ASSERT(second.Fields().find("z") == second.Fields().end());
+            ASSERT_THROWS(second.Fields().at("z"), out_of_range);
+
+            vector<string> names;
+            for (const auto& [name, value] : first.Fields()) {
+                names.push_back(name.GetName() + '=' + to_string(value.TryAs<Number>()->GetValue()));
+            }
+            ASSERT_EQUAL(names, (vector{ "x=1"s, "y=2"s }));
+
+            // Past the linear scan limit fields are found through the index of the shape
+            for (int i = 0; i < 20; ++i) {
+                first.Fields()[Symbol("f" + to_string(i))] = ObjectHolder::Own(Number{ i });
+            }
+            for (int i = 0; i < 20; ++i) {
+                ASSERT_EQUAL(first.Fields().at(Symbol("f" + to_string(i))).TryAs<Number>()->GetValue(), i);
+            }
+            ASSERT_EQUAL(first.Fields().GetShape().IndexOf("x"), 0U);
+        }
+
+        void TestOutputSink() {
+            ostringstream stream;
+            {
+                OutputSink sink(stream, 8);
+                sink.Write("abc"sv);
+                sink.WriteInteger(-42);
+                ASSERT_EQUAL(stream.str(), ""s);
+                // The stream goes through the buffer, so the pieces stay in order
+                sink.GetStream() << 'x';
+                sink.Write('!');
+                ASSERT_EQUAL(stream.str(), "abc-42x!"s);
+                sink.Write("tail"sv);
+                ASSERT_EQUAL(stream.str(), "abc-42x!"s);
+            }
+            ASSERT_EQUAL(stream.str(), "abc-42x!tail"s);
+
+            stream.str({});
+            OutputSink sink(stream);
+            sink.WriteInteger(numeric_limits<int>::min());
+            sink.Write(' ');
+            sink.WriteInteger(0);
+            ASSERT_EQUAL(stream.str(), ""s);
+            sink.Flush();
+            ASSERT_EQUAL(stream.str(), to_string(numeric_limits<int>::min()) + " 0"s);
+            sink.Write("more"sv);
+            sink.SetFlushThreshold(0);
+            ASSERT_EQUAL(stream.str(), to_string(numeric_limits<int>::min()) + " 0more"s);
+        }
+
+        void TestWriteMatchesPrint() {
+            Class cls("Point"s, {}, nullptr);
+            ClassInstance instance(cls);
+            Logger logger(17);
+            vector<ObjectHolder> objects{
+                ObjectHolder::Own(Number{ 0 }), ObjectHolder::Own(Number{ -2147483647 - 1 }),
+                ObjectHolder::Own(Number{ 123456789 }), ObjectHolder::Own(String{ "text"s }),
+                ObjectHolder::Own(Bool{ true }), ObjectHolder::Own(Bool{ false }),
+                ObjectHolder::Share(cls), ObjectHolder::Share(instance), ObjectHolder::Share(logger),
+            };
+            for (const ObjectHolder& object : objects) {
+                DummyContext printed;
+                object->Print(printed.output, printed);
+                DummyContext written;
+                object->Write(written.GetOutput(), written);
+                ASSERT_EQUAL(written.output.str(), printed.output.str());
+            }
+
+            ostringstream stream;
+            {
+                SimpleContext context(stream);
+                objects[3]->Write(context.GetOutput(), context);
+                context.GetOutputStream() << '.';
+                ASSERT_EQUAL(stream.str(), ""s);
+            }
+            ASSERT_EQUAL(stream.str(), "text."s);
+        }
+
+        void TestToString() {
+            DummyContext context;
+            auto text = [&context](const ObjectHolder& object) {
+                return ToString(object, context).TryAs<String>()->GetValue();
+            };
+            ASSERT_EQUAL(text(ObjectHolder::Own(Number{ 0 })), "0"s);
+            ASSERT_EQUAL(text(ObjectHolder::Own(Number{ -905 })), "-905"s);
+            ASSERT_EQUAL(text(ObjectHolder::Own(Number{ numeric_limits<int>::min() })),
+                to_string(numeric_limits<int>::min()));
+            ASSERT_EQUAL(text(ObjectHolder::Own(Bool{ false })), "False"s);
+            ASSERT_EQUAL(text(ObjectHolder::None()), "None"s);
+
+            ASSERT_EQUAL(text(ObjectHolder::Own(String{ "word"s })), "word"s);
+            // The preformatted values are not copied
+            ASSERT_EQUAL(ToString(ObjectHolder::Own(Bool{ true }), context).Get(),
+                ToString(ObjectHolder::Own(Bool{ true }), context).Get());
+            ASSERT_EQUAL(ToString(ObjectHolder::None(), context).Get(), ToString(ObjectHolder::None(), context).Get());
+
+            vector<Method> methods;
+            auto none_body = []([[maybe_unused]] Closure& closure, [[maybe_unused]] Context& ctx) {
+                return ObjectHolder::None();
+            };
+            methods.push_back({ "__str__", {}, make_unique<TestMethodBody>(none_body) });
+            Class cls{ "Nothing"s, move(methods), nullptr };
+            ClassInstance instance{ cls };
+            ASSERT_EQUAL(text(ObjectHolder::Share(instance)), "None"s);
+            ASSERT_EQUAL(text(ObjectHolder::Share(cls)), "Class Nothing"s);
+
+            Class plain{ "Plain"s, {}, nullptr };
+            ClassInstance plain_instance{ plain };
+            Logger logger(5);
+            for (const ObjectHolder& object : { ObjectHolder::Share(plain_instance), ObjectHolder::Share(logger) }) {
+                ostringstream printed;
+                object->Print(printed, context);
+                ASSERT_EQUAL(text(object), printed.str());
+            }
+            ASSERT(context.output.str().empty());
+        }
+
+        void TestStringRopes() {
+            const string piece(100, 'x');
+            String built(""s);
+            string expected;
+            vector<String> prefixes;
+            for (int i = 0; i < 50; ++i) {
+                built = String::Concat(built, String(piece + to_string(i)));
+                expected += piece + to_string(i);
+                ASSERT_EQUAL(built.GetSize(), expected.size());
+                prefixes.push_back(built);
+                if (i % 7 == 0) {
+                    ASSERT_EQUAL(built.GetValue(), expected);
+                }
+            }
+            ASSERT_EQUAL(built.GetValue(), expected);
+
+            // Flattening one string leaves the strings it shares pieces with as they were
+            const String left = String::Concat(prefixes[20], String("L"s));
+            const String right = String::Concat(prefixes[20], String("R"s));
+            ASSERT_EQUAL(right.GetValue(), prefixes[20].GetValue() + 'R');
+            ASSERT_EQUAL(left.GetValue(), prefixes[20].GetValue() + 'L');
+            for (size_t i = 0; i < prefixes.size(); ++i) {
+                ASSERT_EQUAL(prefixes[i].GetValue(), expected.substr(0, prefixes[i].GetSize()));
+            }
+
+            DummyContext context;
+            const auto lhs = ObjectHolder::Own(String::Concat(prefixes[10], String("a"s)));
+            const auto rhs = ObjectHolder::Own(String::Concat(prefixes[10], String("b"s)));
+            ASSERT(Less(lhs, rhs, context));
+            ASSERT(!Equal(lhs, rhs, context));
+            ASSERT(IsTrue(rhs));
+            lhs->Write(context.GetOutput(), context);
+            ASSERT_EQUAL(context.output.str(), prefixes[10].GetValue() + 'a');
+            ASSERT_EQUAL(ToString(lhs, context).TryAs<String>()->GetValue(), context.output.str());
+
+            // A chain that is never read is released without recursion
+            String chain(string(String::MIN_ROPE_SIZE, 'c'));
+            for (int i = 0; i < 300'000; ++i) {
+                chain = String::Concat(chain, String("."s));
+            }
+            ASSERT_EQUAL(chain.GetSize(), String::MIN_ROPE_SIZE + 300'000);
+        }
+
+    }  // namespace
+
+    void RunObjectsTests(TestRunner& tr) {
+        RUN_TEST(tr, runtime::TestNumber);
+        RUN_TEST(tr, runtime::TestString);
+        RUN_TEST(tr, runtime::TestBool);
+        RUN_TEST(tr, runtime::TestMethodInvocation);
+        RUN_TEST(tr, runtime::TestIsTrue);
+        RUN_TEST(tr, runtime::TestComparison);
+        RUN_TEST(tr, runtime::TestComparisonCallsEachMethodOnce);
+        RUN_TEST(tr, runtime::TestCompareValues);
+        RUN_TEST(tr, runtime::TestObjectKinds);
+        RUN_TEST(tr, runtime::TestClass);
+        RUN_TEST(tr, runtime::TestClassInstance);
+        RUN_TEST(tr, runtime::TestSymbol);
+        RUN_TEST(tr, runtime::TestInstanceShapes);
+        RUN_TEST(tr, runtime::TestOutputSink);
+        RUN_TEST(tr, runtime::TestWriteMatchesPrint);
+        RUN_TEST(tr, runtime::TestToString);
+        RUN_TEST(tr, runtime::TestStringRopes);
+    }
+
+    void RunObjectHolderTests(TestRunner& tr) {
+        RUN_TEST(tr, runtime::TestNonowning);
+        RUN_TEST(tr, runtime::TestOwning);
+        RUN_TEST(tr, runtime::TestMove);
+        RUN_TEST(tr, runtime::TestCopies);
+        RUN_TEST(tr, runtime::TestSharedAcrossThreads);
+        RUN_TEST(tr, runtime::TestNullptr);
+    }
+
 }  // namespace runtime
\ No newline at end of file
@@ -0,0 +1,263 @@
+#include "scan.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define MYTHON_SCAN_X86 1
+#endif
+
+using namespace std;
+
+namespace parse::scan {
+
+    namespace {
+        bool IsIdChar(char c) {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        }
+
+        const char* SkipSpacesScalar(const char* begin, const char* end) {
+            while (begin != end && *begin == ' ') {
+                ++begin;
+            }
+            return begin;
+        }
+
+        const char* FindNewlineScalar(const char* begin, const char* end) {
+            while (begin != end && *begin != '\n') {
+                ++begin;
+            }
+            return begin;
+        }
+
+        const char* SkipIdCharsScalar(const char* begin, const char* end) {
+            while (begin != end && IsIdChar(*begin)) {
+                ++begin;
+            }
+            return begin;
+        }
+
+#ifdef MYTHON_SCAN_X86
+        // Bytes are compared as unsigned offsets from the start of each range: x - lo <= hi - lo
+        __m128i InRange16(__m128i bytes, char lo, char hi) {
+            const __m128i offset = _mm_sub_epi8(bytes, _mm_set1_epi8(lo));
+            return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(static_cast<char>(hi - lo))), offset);
+        }
+
+        unsigned IdMask16(__m128i bytes) {
+            // Setting bit 5 folds A-Z onto a-z and moves no other byte into a-z
+            const __m128i alpha = InRange16(_mm_or_si128(bytes, _mm_set1_epi8(0x20)), 'a', 'z');
+            const __m128i digit = InRange16(bytes, '0', '9');
+            const __m128i underscore = _mm_cmpeq_epi8(bytes, _mm_set1_epi8('_'));
+            return static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), underscore)));
+        }
+
+        // mask has a bit set for every byte that continues the run
+        template <unsigned FULL>
+        const char* FirstOutside(const char* block, unsigned mask) {
+            return block + __builtin_ctz(~mask & FULL);
+        }
+
+        constexpr unsigned FULL16 = 0xFFFFU;
+
+        const char* SkipSpacesSse2(const char* begin, const char* end) {
+            const __m128i spaces = _mm_set1_epi8(' ');
+            for (; end - begin >= 16; begin += 16) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                const auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, spaces)));
+                if (mask != FULL16) {
+                    return FirstOutside<FULL16>(begin, mask);
+                }
+            }
+            return SkipSpacesScalar(begin, end);
+        }
+
+        const char* FindNewlineSse2(const char* begin, const char* end) {
+            const __m128i newlines = _mm_set1_epi8('\n');
+            for (; end - begin >= 16; begin += 16) {
+                const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+                const auto mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, newlines)));
+                if (mask != 0) {
+                    return begin + __builtin_ctz(mask);
+                }
+            }
+            return FindNewlineScalar(begin, end);
+        }
+
+        const char* SkipIdCharsSse2(const char* begin, const char* end) {
+            for (; end - begin >= 16; begin += 16) {
+                const unsigned mask = IdMask16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)));
+                if (mask != FULL16) {
+                    return FirstOutside<FULL16>(begin, mask);
+                }
+            }
+            return SkipIdCharsScalar(begin, end);
+        }
+
+#define MYTHON_AVX2 __attribute__((target("avx2")))
+
+        MYTHON_AVX2 __m256i InRange32(__m256i bytes, char lo, char hi) {
+            const __m256i offset = _mm256_sub_epi8(bytes, _mm256_set1_epi8(lo));
+            return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(static_cast<char>(hi - lo))), offset);
+        }
+
+        MYTHON_AVX2 unsigned IdMask32(__m256i bytes) {
+            const __m256i alpha = InRange32(_mm256_or_si256(bytes, _mm256_set1_epi8(0x20)), 'a', 'z');
+            const __m256i digit = InRange32(bytes, '0', '9');
+            const __m256i underscore = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8('_'));
+            return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), underscore)));
+        }
+
+        constexpr unsigned FULL32 = 0xFFFFFFFFU;
+
+        // Most runs in a script are short, so the AVX2 kernels look at one 16-byte block first
+        // and only then switch to 32-byte blocks
+
+        MYTHON_AVX2 const char* SkipSpacesAvx2(const char* begin, const char* end) {
+            if (end - begin < 16) {
+                return SkipSpacesScalar(begin, end);
+            }
+            const auto head = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)), _mm_set1_epi8(' '))));
+            if (head != FULL16) {
+                return FirstOutside<FULL16>(begin, head);
+            }
+            begin += 16;
+            const __m256i spaces = _mm256_set1_epi8(' ');
+            for (; end - begin >= 32; begin += 32) {
+                const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+                const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, spaces)));
+                if (mask != FULL32) {
+                    return FirstOutside<FULL32>(begin, mask);
+                }
+            }
+            return SkipSpacesSse2(begin, end);
+        }
+
+        MYTHON_AVX2 const char* FindNewlineAvx2(const char* begin, const char* end) {
+            if (end - begin < 16) {
+                return FindNewlineScalar(begin, end);
+            }
+            const auto head = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(
+                _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)), _mm_set1_epi8('\n'))));
+            if (head != 0) {
+                return begin + __builtin_ctz(head);
+            }
+            begin += 16;
+            const __m256i newlines = _mm256_set1_epi8('\n');
+            for (; end - begin >= 32; begin += 32) {
+                const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin));
+                const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, newlines)));
+                if (mask != 0) {
+                    return begin + __builtin_ctz(mask);
+                }
+            }
+            return FindNewlineSse2(begin, end);
+        }
+
+        MYTHON_AVX2 const char* SkipIdCharsAvx2(const char* begin, const char* end) {
+            if (end - begin < 16) {
+                return SkipIdCharsScalar(begin, end);
+            }
+            const unsigned head = IdMask16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(begin)));
+            if (head != FULL16) {
+                return FirstOutside<FULL16>(begin, head);
+            }
+            begin += 16;
+            for (; end - begin >= 32; begin += 32) {
+                const unsigned mask = IdMask32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(begin)));
+                if (mask != FULL32) {
+                    return FirstOutside<FULL32>(begin, mask);
+                }
+            }
+            return SkipIdCharsSse2(begin, end);
+        }
+
+#undef MYTHON_AVX2
+#endif
+
+        struct Kernels {
+            Level level;
+            const char* (*skip_spaces)(const char*, const char*);
+            const char* (*find_newline)(const char*, const char*);
+            const char* (*skip_id_chars)(const char*, const char*);
+        };
+
+        constexpr Kernels SCALAR{ Level::Scalar, SkipSpacesScalar, FindNewlineScalar, SkipIdCharsScalar };
+#ifdef MYTHON_SCAN_X86
+        constexpr Kernels SSE2{ Level::Sse2, SkipSpacesSse2, FindNewlineSse2, SkipIdCharsSse2 };
+        constexpr Kernels AVX2{ Level::Avx2, SkipSpacesAvx2, FindNewlineAvx2, SkipIdCharsAvx2 };
+#endif
+
+        const Kernels& GetKernels(Level level) {
+            switch (level) {
+#ifdef MYTHON_SCAN_X86
+            case Level::Avx2:
+                return AVX2;
+            case Level::Sse2:
+                return SSE2;
+#endif
+            default:
+                return SCALAR;
+            }
+        }
+
+        // The kernel tables are constants, so publishing a pointer to one needs no ordering
+        atomic<const Kernels*> active_kernels{ nullptr };
+
+        const Kernels& GetActiveKernels() {
+            const Kernels* kernels = active_kernels.load(memory_order_relaxed);
+            if (!kernels) {
+                // Runs in scripts are a few dozen bytes long, and at that size the AVX2 kernels
+                // measured slower than the SSE2 ones (lexer_bench.cpp), so AVX2 is opt-in
+                kernels = &GetKernels(min(GetBestSupportedLevel(), Level::Sse2));
+                active_kernels.store(kernels, memory_order_relaxed);
+            }
+            return *kernels;
+        }
+    }  // namespace
+
+    const char* SkipSpaces(const char* begin, const char* end) {
+        return GetActiveKernels().skip_spaces(begin, end);
+    }
+
+    const char* FindNewline(const char* begin, const char* end) {
+        return GetActiveKernels().find_newline(begin, end);
+    }
+
+    const char* SkipIdChars(const char* begin, const char* end) {
+        return GetActiveKernels().skip_id_chars(begin, end);
+    }
+
+    Level GetLevel() {
+        return GetActiveKernels().level;
+    }
+
+    Level GetBestSupportedLevel() {
+#ifdef MYTHON_SCAN_X86
+        return __builtin_cpu_supports("avx2") ? Level::Avx2 : Level::Sse2;
+#else
+        return Level::Scalar;
+#endif
+    }
+
+    void SetLevel(Level level) {
+        if (level > GetBestSupportedLevel()) {
+            level = GetBestSupportedLevel();
+        }
+        active_kernels.store(&GetKernels(level), memory_order_relaxed);
+    }
+
+    std::string_view GetLevelName(Level level) {
+        switch (level) {
+        case Level::Sse2:
+            return "SSE2";
+        case Level::Avx2:
+            return "AVX2";
+        default:
+            return "scalar";
+        }
+    }
+
+}  // namespace parse::scan
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string_view>
+
+namespace parse::scan {
+
+    // Byte-run kernels of the lexer. Each takes [begin, end) and returns the first position that
+    // does not belong to the run, end if the whole range does. Vector versions never read past end
+
+    const char* SkipSpaces(const char* begin, const char* end);
+
+    const char* FindNewline(const char* begin, const char* end);
+
+    // Skips [A-Za-z0-9_]
+    const char* SkipIdChars(const char* begin, const char* end);
+
+    enum class Level {
+        Scalar,
+        Sse2,
+        Avx2,
+    };
+
+    // Unless set explicitly, SSE2 is used where the CPU has it and scalar code elsewhere
+    [[nodiscard]] Level GetLevel();
+
+    [[nodiscard]] Level GetBestSupportedLevel();
+
+    // For tests and benchmarks; a level the CPU does not support falls back to the best supported one
+    void SetLevel(Level level);
+
+    [[nodiscard]] std::string_view GetLevelName(Level level);
+
+}  // namespace parse::scan
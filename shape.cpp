@@ -0,0 +1,59 @@
+#include "shape.h"
+
+#include <mutex>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        mutex& GetTransitionMutex() {
+            static mutex transition_mutex;
+            return transition_mutex;
+        }
+    }  // namespace
+
+    Shape::Shape(const Shape& parent, Symbol field) : fields_(parent.fields_) {
+        fields_.push_back(field);
+        if (fields_.size() > LINEAR_SCAN_LIMIT) {
+            index_.reserve(fields_.size());
+            for (size_t i = 0; i < fields_.size(); ++i) {
+                index_.emplace(fields_[i], i);
+            }
+        }
+    }
+
+    const Shape& Shape::Empty() {
+        static const Shape empty;
+        return empty;
+    }
+
+    size_t Shape::IndexOf(Symbol field) const {
+        if (fields_.size() > LINEAR_SCAN_LIMIT) {
+            const auto it = index_.find(field);
+            return it == index_.end() ? NO_FIELD : it->second;
+        }
+        for (size_t i = 0; i < fields_.size(); ++i) {
+            if (fields_[i] == field) {
+                return i;
+            }
+        }
+        return NO_FIELD;
+    }
+
+    const Shape& Shape::WithField(Symbol field) const {
+        // Instances of one class mostly take the same path, so the last transition usually matches
+        if (const Shape* last = last_transition_.load(memory_order_acquire); last && last->fields_.back() == field) {
+            return *last;
+        }
+
+        lock_guard guard(GetTransitionMutex());
+        auto& next = transitions_[field];
+        if (!next) {
+            next.reset(new Shape(*this, field));
+        }
+        last_transition_.store(next.get(), memory_order_release);
+        return *next;
+    }
+
+}  // namespace runtime
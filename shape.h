@@ -0,0 +1,56 @@
+#pragma once
+
+#include "symbol.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace runtime {
+
+    // Hidden class of an instance: the names of its fields in the order they were assigned.
+    // Shapes form a process-wide transition tree rooted at Empty(), so instances that get the
+    // same fields in the same order share one shape and keep only the values themselves.
+    // Shapes are immutable once published and are never freed
+    class Shape {
+    public:
+        static constexpr size_t NO_FIELD = SIZE_MAX;
+
+        Shape(const Shape&) = delete;
+        Shape& operator=(const Shape&) = delete;
+
+        [[nodiscard]] static const Shape& Empty();
+
+        // Index of the field in the values of an instance, NO_FIELD if the shape has no such field
+        [[nodiscard]] size_t IndexOf(Symbol field) const;
+
+        // Shape of an instance after a field missing from this shape is assigned
+        [[nodiscard]] const Shape& WithField(Symbol field) const;
+
+        [[nodiscard]] size_t GetFieldCount() const {
+            return fields_.size();
+        }
+
+        [[nodiscard]] Symbol GetFieldName(size_t index) const {
+            return fields_[index];
+        }
+
+    private:
+        // Up to this many fields a linear scan over interned symbols beats hashing
+        static constexpr size_t LINEAR_SCAN_LIMIT = 8;
+
+        Shape() = default;
+        Shape(const Shape& parent, Symbol field);
+
+        std::vector<Symbol> fields_;
+        std::unordered_map<Symbol, size_t> index_;
+
+        // Guarded by the transition mutex in shape.cpp
+        mutable std::unordered_map<Symbol, std::unique_ptr<Shape>> transitions_;
+        // The most recently taken transition, checked without locking
+        mutable std::atomic<const Shape*> last_transition_{ nullptr };
+    };
+
+}  // namespace runtime
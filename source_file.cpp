@@ -0,0 +1,55 @@
+#include "source_file.h"
+
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MYTHON_HAS_MMAP 1
+#endif
+
+using namespace std;
+
+namespace parse {
+
+    SourceFile::SourceFile(const std::string& path) {
+#ifdef MYTHON_HAS_MMAP
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw SourceFileError("cannot open "s + path);
+        }
+        struct stat info {};
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapping != MAP_FAILED) {
+                mapping_ = mapping;
+                mapping_size_ = static_cast<size_t>(info.st_size);
+                contents_ = string_view(static_cast<const char*>(mapping_), mapping_size_);
+            }
+        }
+        close(fd);
+        if (mapping_ || (S_ISREG(info.st_mode) && info.st_size == 0)) {
+            return;
+        }
+#endif
+        // Pipes, empty files and platforms without mmap
+        ifstream input(path, ios::binary);
+        if (!input) {
+            throw SourceFileError("cannot open "s + path);
+        }
+        buffer_.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+        contents_ = buffer_;
+    }
+
+    SourceFile::~SourceFile() {
+#ifdef MYTHON_HAS_MMAP
+        if (mapping_) {
+            munmap(mapping_, mapping_size_);
+        }
+#endif
+    }
+
+}  // namespace parse
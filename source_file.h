@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace parse {
+
+    class SourceFileError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    // Read-only contents of a whole script file for Lexer(std::string_view).
+    // The file is memory-mapped on POSIX systems and read into memory elsewhere
+    class SourceFile {
+    public:
+        explicit SourceFile(const std::string& path);
+        ~SourceFile();
+
+        SourceFile(const SourceFile&) = delete;
+        SourceFile& operator=(const SourceFile&) = delete;
+
+        [[nodiscard]] std::string_view GetContents() const {
+            return contents_;
+        }
+
+        [[nodiscard]] bool IsMapped() const {
+            return mapping_ != nullptr;
+        }
+
+    private:
+        void* mapping_ = nullptr;
+        size_t mapping_size_ = 0;
+        std::string buffer_;
+        std::string_view contents_;
+    };
+
+}  // namespace parse
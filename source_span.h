@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+namespace parse {
+
+    // 1-based line and byte column in a script; line 0 where the position is not known
+    struct SourcePosition {
+        std::uint32_t line = 0;
+        std::uint32_t column = 0;
+    };
+
+    // From the first character of a token or a construct to the position right after its last one
+    struct SourceSpan {
+        SourcePosition begin;
+        SourcePosition end;
+    };
+
+}  // namespace parse
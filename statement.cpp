@@ -1,287 +1,312 @@
-#include "statement.h"
-
-#include <iostream>
-#include <sstream>
-
-#include <type_traits>
-
-using namespace std;
-
-namespace ast {
-
-    using runtime::Closure;
-    using runtime::Context;
-    using runtime::ObjectHolder;
-
-    namespace {
-        const string ADD_METHOD = "__add__"s;
-        const string INIT_METHOD = "__init__"s;
-    }  // namespace
-
-    ObjectHolder Assignment::Execute(Closure& closure, Context& context) {
-        return closure[var_] = rv_->Execute(closure, context);
-    }
-
-    Assignment::Assignment(std::string var, std::unique_ptr<Statement> rv) : var_(var), rv_(move(rv)) {
-    }
-
-    VariableValue::VariableValue(const std::string& var_name) : value_(var_name) {
-    }
-
-    VariableValue::VariableValue(std::vector<std::string> dotted_ids) : value_(move(dotted_ids)) {
-    }
-
-    ObjectHolder VariableValue::Execute(Closure& closure, Context& context) {
-        if (std::holds_alternative<const string>(value_)) {
-            const string value = std::get<const string>(value_);
-            if (closure.find(value) != closure.end()) {
-                return closure.at(value);
-            }
-        }
-        else if (std::holds_alternative<vector<string>>(value_)) {
-            vector<string>& values = get<vector<string>>(value_);
-            if (values.size() == 1) {
-                return VariableValue{ *values.begin() }.Execute(closure, context);
-            }
-            ObjectHolder ob_h;
-            for (size_t i = 0; i + 1 < values.size(); ++i) {
-                if (closure.find(values.at(i)) != closure.end()) {
-                    const auto& fields = closure.at(values.at(i)).TryAs<runtime::ClassInstance>()->Fields();
-                    if (fields.find(values.at(i + 1)) != fields.end()) {
-                        ob_h = fields.at(values.at(i + 1));
-                    }
-                    else {
-                        throw std::runtime_error("undefined value");
-                    }
-                }
-                else {
-                    throw std::runtime_error("undefined value");
-                }
-            }
-            return ob_h;
-        }
-        throw std::runtime_error("undefined value");
-    }
-
-    unique_ptr<Print> Print::Variable(const std::string& name) {
-        return make_unique<Print>(Print{ make_unique<StringConst>(name) });
-    }
-
-    Print::Print(unique_ptr<Statement> argument) : argument_(move(argument)) {
-    }
-
-    Print::Print(vector<unique_ptr<Statement>> args) : args_(move(args)) {
-    }
-
-    ObjectHolder Print::Execute(Closure& closure, Context& context) {
-        std::ostream& output = context.GetOutputStream();
-        if (argument_) {
-            if (argument_->Execute(closure, context).TryAs<runtime::String>()) {
-                closure.at(argument_->Execute(closure, context).TryAs<runtime::String>()->GetValue())->Print(output, context);
-            }
-        }
-        else if (args_.size()) {
-            bool space_flag = false;
-            for (const unique_ptr<Statement>& arg : args_) {
-                if (space_flag) {
-                    output << ' ';
-                }
-                space_flag = true;
-                ObjectHolder obj_holder = arg->Execute(closure, context);
-                if (!obj_holder) {
-                    output << "None";
-                    continue;
-                }
-                obj_holder->Print(output, context);
-            }
-        }
-        output << '\n';
-        return {};
-    }
-
-    MethodCall::MethodCall(std::unique_ptr<Statement> object, std::string method,
-        std::vector<std::unique_ptr<Statement>> args) : object_(move(object)), method_(move(method)), args_(move(args)) {
-    }
-
-    ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
-        vector<runtime::ObjectHolder> args;
-        for (const auto& arg : args_) {
-            args.push_back(arg->Execute(closure, context));
-        }
-        return object_->Execute(closure, context).TryAs<runtime::ClassInstance>()->Call(method_, args, context);
-    }
-
-    ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
-        ObjectHolder obj_holder = argument_->Execute(closure, context);
-        if (!obj_holder) {
-            return ObjectHolder::Own(runtime::String("None"s));
-        }
-        ostringstream o_stream;
-        obj_holder->Print(o_stream, context);
-        return ObjectHolder::Own(runtime::String(o_stream.str()));
-    }
-
-    ObjectHolder Add::Execute(Closure& closure, Context& context) {
-        ObjectHolder lhs_obj_h = lhs_->Execute(closure, context);
-        ObjectHolder rhs_obj_h = rhs_->Execute(closure, context);
-        ObjectHolder obj_holder;
-        if (obj_holder = AddStatements<int,runtime::Number>(lhs_obj_h, rhs_obj_h); obj_holder) {
-            return obj_holder;
-        }else if (obj_holder = AddStatements<string, runtime::String>(lhs_obj_h, rhs_obj_h); obj_holder) {
-            return obj_holder;
-        }
-        else if (lhs_obj_h.TryAs<runtime::ClassInstance>()) {
-            if (lhs_obj_h.TryAs<runtime::ClassInstance>()->HasMethod(ADD_METHOD, 1U)) {
-                return lhs_obj_h.TryAs<runtime::ClassInstance>()->Call(ADD_METHOD, { rhs_obj_h }, context);
-            }
-        }
-        throw std::runtime_error("diffrent tipes or nullptr"s);
-    }
-
-    ObjectHolder Sub::Execute(Closure& closure, Context& context) {
-        ObjectHolder lhs_obj_h = lhs_->Execute(closure, context);
-        ObjectHolder rhs_obj_h = rhs_->Execute(closure, context);
-        if (lhs_obj_h.TryAs<runtime::ValueObject<int>>() && rhs_obj_h.TryAs<runtime::ValueObject<int>>()) {
-            int lhs = lhs_obj_h.TryAs<runtime::ValueObject<int>>()->GetValue();
-            int rhs = rhs_obj_h.TryAs<runtime::ValueObject<int>>()->GetValue();
-            int result = lhs - rhs;
-            return runtime::ObjectHolder::Own(runtime::Number(result));
-        }
-        throw std::runtime_error("diffrent tipes or nullptr"s);
-    }
-
-    ObjectHolder Mult::Execute(Closure& closure, Context& context) {
-        ObjectHolder lhs_obj_h = lhs_->Execute(closure, context);
-        ObjectHolder rhs_obj_h = rhs_->Execute(closure, context);
-        if (lhs_obj_h.TryAs<runtime::ValueObject<int>>() && rhs_obj_h.TryAs<runtime::ValueObject<int>>()) {
-            int lhs = lhs_obj_h.TryAs<runtime::ValueObject<int>>()->GetValue();
-            int rhs = rhs_obj_h.TryAs<runtime::ValueObject<int>>()->GetValue();
-            int result = lhs * rhs;
-            return runtime::ObjectHolder::Own(runtime::Number(result));
-        }
-        throw std::runtime_error("diffrent tipes or nullptr"s);
-    }
-
-    ObjectHolder Div::Execute(Closure& closure, Context& context) {
-        ObjectHolder lhs_obj_h = lhs_->Execute(closure, context);
-        ObjectHolder rhs_obj_h = rhs_->Execute(closure, context);
-        if (lhs_obj_h.TryAs<runtime::ValueObject<int>>() && rhs_obj_h.TryAs<runtime::ValueObject<int>>()) {
-            if (rhs_obj_h.TryAs<runtime::ValueObject<int>>()->GetValue() == 0) {
-                throw std::runtime_error("diffrent tipes or nullptr"s);
-            }
-            int lhs = lhs_obj_h.TryAs<runtime::ValueObject<int>>()->GetValue();
-            int rhs = rhs_obj_h.TryAs<runtime::ValueObject<int>>()->GetValue();
-            int result = lhs / rhs;
-            return runtime::ObjectHolder::Own(runtime::Number(result));
-        }
-        throw std::runtime_error("diffrent tipes or nullptr"s);
-    }
-
-    ObjectHolder Compound::Execute(Closure& closure, Context& context) {
-        for (unique_ptr<Statement>& stmt : stmts_) {
-            if (Return* return_ptr = dynamic_cast<Return*>(stmt.get()); return_ptr != nullptr) {
-                return return_ptr->Execute(closure, context);
-            }
-            if (IfElse* if_else_ptr = dynamic_cast<IfElse*>(stmt.get()); if_else_ptr != nullptr) {
-                if (ObjectHolder obj_holder = if_else_ptr->Execute(closure, context); obj_holder) {
-                    return obj_holder;
-                }
-            }
-            else {
-                stmt->Execute(closure, context);
-            }
-        }
-        return {};
-    }
-
-    ObjectHolder Return::Execute(Closure& closure, Context& context) {
-        return statement_->Execute(closure, context);
-    }
-
-    ClassDefinition::ClassDefinition(ObjectHolder cls) : cls_(cls) {
-    }
-
-    ObjectHolder ClassDefinition::Execute(Closure& closure, [[maybe_unused]] Context& context) {
-        closure[cls_.TryAs<runtime::Class>()->GetName()] = cls_;
-        return  cls_;
-    }
-
-    FieldAssignment::FieldAssignment(VariableValue object, std::string field_name,
-        std::unique_ptr<Statement> rv) : object_(object), field_name_(field_name), rv_(move(rv)) {
-
-    }
-
-    ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) {
-        return  object_.Execute(closure, context).TryAs<runtime::ClassInstance>()->Fields()[field_name_] = rv_->Execute(closure, context);
-    }
-
-    IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
-        std::unique_ptr<Statement> else_body) : condition_(move(condition)), if_body_(move(if_body)), else_body_(move(else_body)) {
-    }
-
-    ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
-        if (runtime::IsTrue(condition_->Execute(closure, context))) {
-            return if_body_->Execute(closure, context); 
-        }
-        else if (else_body_) {
-            return else_body_->Execute(closure, context);
-        }
-        return {};
-    }
-
-    ObjectHolder Or::Execute(Closure& closure, Context& context) {
-        if (runtime::IsTrue(lhs_->Execute(closure, context))) {
-            return ObjectHolder::Own(runtime::Bool{ true });
-        }
-        else if (runtime::IsTrue(rhs_->Execute(closure, context))) {
-            return ObjectHolder::Own(runtime::Bool{ true });
-        }
-        return ObjectHolder::Own(runtime::Bool{ false });
-    }
-
-    ObjectHolder And::Execute(Closure& closure, Context& context) {
-        if (runtime::IsTrue(lhs_->Execute(closure, context)) ) {
-            if (runtime::IsTrue(rhs_->Execute(closure, context))) {
-                return ObjectHolder::Own(runtime::Bool{ true });
-            }
-        }
-        return ObjectHolder::Own(runtime::Bool{ false });
-    }
-
-    ObjectHolder Not::Execute(Closure& closure, Context& context) {
-        return ObjectHolder::Own(runtime::Bool{ !runtime::IsTrue(argument_->Execute(closure, context)) });
-    }
-
-    Comparison::Comparison(Comparator cmp, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs)
-        : BinaryOperation(std::move(lhs), std::move(rhs)), cmp_(cmp) {
-    }
-
-    ObjectHolder Comparison::Execute(Closure& closure, Context& context) {
-        return ObjectHolder::Own(runtime::Bool{ cmp_(lhs_->Execute(closure, context), rhs_->Execute(closure, context), context) });
-    }
-
-    NewInstance::NewInstance(const runtime::Class& cls, std::vector<std::unique_ptr<Statement>> args) : cls_(cls), args_(move(args)) {
-    }
-
-    NewInstance::NewInstance(const runtime::Class& cls) : cls_(cls) {
-    }
-
-    ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
-        ObjectHolder ob_h = ObjectHolder::Own(runtime::ClassInstance{ cls_ });
-        if (const runtime::Method* class_method = cls_.GetMethod(INIT_METHOD); class_method) {
-            vector<ObjectHolder> args;
-            for (const auto& arg : args_) {
-                args.push_back(arg->Execute(closure, context));
-            }
-            ob_h.TryAs<runtime::ClassInstance>()->Call(class_method->name, args, context);
-        }
-        return ob_h;
-    }
-
-    MethodBody::MethodBody(std::unique_ptr<Statement>&& body) : body_(move(body)) {
-    }
-
-    ObjectHolder MethodBody::Execute(Closure& closure, Context& context) {
-        return body_->Execute(closure, context);
-    }
+#include "statement.h"
+
+#include <iostream>
+
+#include <type_traits>
+
+using namespace std;
+
+namespace ast {
+
+    using runtime::Closure;
+    using runtime::Context;
+    using runtime::ObjectHolder;
+
+    namespace {
+        const runtime::Symbol ADD_METHOD{ "__add__" };
+        const runtime::Symbol INIT_METHOD{ "__init__" };
+
+        // Values of two Number operands; operands of other kinds are a runtime error
+        pair<int, int> NumberOperands(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+            if (lhs.GetKind() != runtime::ObjectKind::Number || rhs.GetKind() != runtime::ObjectKind::Number) {
+                throw std::runtime_error("diffrent tipes or nullptr"s);
+            }
+            return { lhs.TryAs<runtime::Number>()->GetValue(), rhs.TryAs<runtime::Number>()->GetValue() };
+        }
+    }  // namespace
+
+    ObjectHolder Assignment::Execute(Closure& closure, Context& context) {
+        if (slot_ != NO_SLOT) {
+            ObjectHolder value = rv_->Execute(closure, context);
+            closure.SetSlot(slot_, value);
+            return value;
+        }
+        return closure[var_] = rv_->Execute(closure, context);
+    }
+
+    Assignment::Assignment(runtime::Symbol var, std::unique_ptr<Statement> rv) : var_(var), rv_(move(rv)) {
+    }
+
+    VariableValue::VariableValue(runtime::Symbol var_name) : dotted_ids_(1, var_name) {
+    }
+
+    VariableValue::VariableValue(std::vector<runtime::Symbol> dotted_ids) : dotted_ids_(move(dotted_ids)) {
+    }
+
+    VariableValue::VariableValue(const std::vector<std::string>& dotted_ids) : dotted_ids_(dotted_ids.begin(), dotted_ids.end()) {
+    }
+
+    namespace {
+        const ObjectHolder& LookupVariable(runtime::Symbol name, size_t slot, const Closure& closure) {
+            if (slot != NO_SLOT) {
+                return closure.GetSlot(slot);
+            }
+            if (const auto it = closure.find(name); it != closure.end()) {
+                return it->second;
+            }
+            throw std::runtime_error("undefined value");
+        }
+    }  // namespace
+
+    ObjectHolder VariableValue::Execute(Closure& closure, [[maybe_unused]] Context& context) {
+        ObjectHolder ob_h = LookupVariable(dotted_ids_.front(), slot_, closure);
+        for (size_t i = 1; i < dotted_ids_.size(); ++i) {
+            const auto* instance = ob_h.TryAs<runtime::ClassInstance>();
+            if (!instance) {
+                throw std::runtime_error("undefined value");
+            }
+            const ObjectHolder* field = instance->Fields().Find(dotted_ids_[i]);
+            if (!field) {
+                throw std::runtime_error("undefined value");
+            }
+            // Copied first: the instance may be owned by ob_h itself
+            ObjectHolder value = *field;
+            ob_h = std::move(value);
+        }
+        return ob_h;
+    }
+
+    unique_ptr<Print> Print::Variable(const std::string& name) {
+        return make_unique<Print>(Print{ make_unique<StringConst>(name) });
+    }
+
+    Print::Print(unique_ptr<Statement> argument) : argument_(move(argument)) {
+        if (const auto* name = dynamic_cast<const StringConst*>(argument_.get())) {
+            variable_ = runtime::Symbol(name->GetValue().GetValue());
+        }
+    }
+
+    Print::Print(vector<unique_ptr<Statement>> args) : args_(move(args)) {
+    }
+
+    ObjectHolder Print::Execute(Closure& closure, Context& context) {
+        runtime::OutputSink& output = context.GetOutput();
+        if (argument_) {
+            if (variable_) {
+                closure.at(*variable_)->Write(output, context);
+            }
+            else if (const ObjectHolder name = argument_->Execute(closure, context); name.TryAs<runtime::String>()) {
+                closure.at(runtime::Symbol(name.TryAs<runtime::String>()->GetValue()))->Write(output, context);
+            }
+        }
+        else if (args_.size()) {
+            bool space_flag = false;
+            for (const unique_ptr<Statement>& arg : args_) {
+                if (space_flag) {
+                    output.Write(' ');
+                }
+                space_flag = true;
+                ObjectHolder obj_holder = arg->Execute(closure, context);
+                if (!obj_holder) {
+                    output.Write("None"sv);
+                    continue;
+                }
+                obj_holder->Write(output, context);
+            }
+        }
+        output.Write('\n');
+        return {};
+    }
+
+    MethodCall::MethodCall(std::unique_ptr<Statement> object, runtime::Symbol method,
+        std::vector<std::unique_ptr<Statement>> args) : object_(move(object)), method_(move(method)), args_(move(args)) {
+    }
+
+    ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
+        vector<runtime::ObjectHolder> args;
+        args.reserve(args_.size());
+        for (const auto& arg : args_) {
+            args.push_back(arg->Execute(closure, context));
+        }
+        ObjectHolder object = object_->Execute(closure, context);
+        auto* instance = object.TryAs<runtime::ClassInstance>();
+        if (!instance) {
+            throw std::runtime_error("method call on a non-instance value"s);
+        }
+        const runtime::Method* method = cache_.Lookup(instance->GetClass(), method_);
+        if (!method) {
+            throw std::runtime_error("undeclareted method"s);
+        }
+        return instance->Call(*method, args, context);
+    }
+
+    ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
+        return runtime::ToString(argument_->Execute(closure, context), context);
+    }
+
+    ObjectHolder Add::Execute(Closure& closure, Context& context) {
+        ObjectHolder lhs_obj_h = lhs_->Execute(closure, context);
+        ObjectHolder rhs_obj_h = rhs_->Execute(closure, context);
+        const runtime::ObjectKind kind = lhs_obj_h.GetKind();
+        if (kind == runtime::ObjectKind::Number && rhs_obj_h.GetKind() == kind) {
+            return ObjectHolder::Own(runtime::Number(
+                lhs_obj_h.TryAs<runtime::Number>()->GetValue() + rhs_obj_h.TryAs<runtime::Number>()->GetValue()));
+        }
+        if (kind == runtime::ObjectKind::String && rhs_obj_h.GetKind() == kind) {
+            return ObjectHolder::Own(runtime::String::Concat(
+                *lhs_obj_h.TryAs<runtime::String>(), *rhs_obj_h.TryAs<runtime::String>()));
+        }
+        if (kind == runtime::ObjectKind::ClassInstance) {
+            auto* instance = lhs_obj_h.TryAs<runtime::ClassInstance>();
+            if (instance->HasMethod(ADD_METHOD, 1U)) {
+                return instance->Call(ADD_METHOD, { rhs_obj_h }, context);
+            }
+        }
+        throw std::runtime_error("diffrent tipes or nullptr"s);
+    }
+
+    ObjectHolder Sub::Execute(Closure& closure, Context& context) {
+        ObjectHolder lhs_obj_h = lhs_->Execute(closure, context);
+        ObjectHolder rhs_obj_h = rhs_->Execute(closure, context);
+        const auto [lhs, rhs] = NumberOperands(lhs_obj_h, rhs_obj_h);
+        return ObjectHolder::Own(runtime::Number(lhs - rhs));
+    }
+
+    ObjectHolder Mult::Execute(Closure& closure, Context& context) {
+        ObjectHolder lhs_obj_h = lhs_->Execute(closure, context);
+        ObjectHolder rhs_obj_h = rhs_->Execute(closure, context);
+        const auto [lhs, rhs] = NumberOperands(lhs_obj_h, rhs_obj_h);
+        return ObjectHolder::Own(runtime::Number(lhs * rhs));
+    }
+
+    ObjectHolder Div::Execute(Closure& closure, Context& context) {
+        ObjectHolder lhs_obj_h = lhs_->Execute(closure, context);
+        ObjectHolder rhs_obj_h = rhs_->Execute(closure, context);
+        const auto [lhs, rhs] = NumberOperands(lhs_obj_h, rhs_obj_h);
+        if (rhs == 0) {
+            throw std::runtime_error("diffrent tipes or nullptr"s);
+        }
+        return ObjectHolder::Own(runtime::Number(lhs / rhs));
+    }
+
+    ObjectHolder Compound::Execute(Closure& closure, Context& context) {
+        for (unique_ptr<Statement>& stmt : stmts_) {
+            ObjectHolder result = stmt->Execute(closure, context);
+            if (closure.GetCompletion() == runtime::Completion::Return) {
+                return result;
+            }
+        }
+        return {};
+    }
+
+    ObjectHolder Return::Execute(Closure& closure, Context& context) {
+        ObjectHolder result = statement_->Execute(closure, context);
+        closure.SetCompletion(runtime::Completion::Return);
+        return result;
+    }
+
+    ClassDefinition::ClassDefinition(ObjectHolder cls) : cls_(cls), name_(cls_.TryAs<runtime::Class>()->GetName()) {
+    }
+
+    ObjectHolder ClassDefinition::Execute(Closure& closure, [[maybe_unused]] Context& context) {
+        closure[name_] = cls_;
+        return  cls_;
+    }
+
+    FieldAssignment::FieldAssignment(VariableValue object, runtime::Symbol field_name,
+        std::unique_ptr<Statement> rv) : object_(object), field_name_(field_name), rv_(move(rv)) {
+
+    }
+
+    ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) {
+        ObjectHolder value = rv_->Execute(closure, context);
+        ObjectHolder object = object_.Execute(closure, context);
+        auto* instance = object.TryAs<runtime::ClassInstance>();
+        if (!instance) {
+            throw std::runtime_error("field assignment to a non-instance value"s);
+        }
+        return instance->Fields()[field_name_] = std::move(value);
+    }
+
+    IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
+        std::unique_ptr<Statement> else_body) : condition_(move(condition)), if_body_(move(if_body)), else_body_(move(else_body)) {
+    }
+
+    ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
+        if (runtime::IsTrue(condition_->Execute(closure, context))) {
+            return if_body_->Execute(closure, context); 
+        }
+        else if (else_body_) {
+            return else_body_->Execute(closure, context);
+        }
+        return {};
+    }
+
+    ObjectHolder Or::Execute(Closure& closure, Context& context) {
+        if (runtime::IsTrue(lhs_->Execute(closure, context))) {
+            return ObjectHolder::Own(runtime::Bool{ true });
+        }
+        else if (runtime::IsTrue(rhs_->Execute(closure, context))) {
+            return ObjectHolder::Own(runtime::Bool{ true });
+        }
+        return ObjectHolder::Own(runtime::Bool{ false });
+    }
+
+    ObjectHolder And::Execute(Closure& closure, Context& context) {
+        if (runtime::IsTrue(lhs_->Execute(closure, context)) ) {
+            if (runtime::IsTrue(rhs_->Execute(closure, context))) {
+                return ObjectHolder::Own(runtime::Bool{ true });
+            }
+        }
+        return ObjectHolder::Own(runtime::Bool{ false });
+    }
+
+    ObjectHolder Not::Execute(Closure& closure, Context& context) {
+        return ObjectHolder::Own(runtime::Bool{ !runtime::IsTrue(argument_->Execute(closure, context)) });
+    }
+
+    unique_ptr<Comparison> Comparison::Make(runtime::Comparator cmp, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs) {
+        switch (cmp) {
+        case runtime::Comparator::Equal:
+            return make_unique<Equal>(std::move(lhs), std::move(rhs));
+        case runtime::Comparator::NotEqual:
+            return make_unique<NotEqual>(std::move(lhs), std::move(rhs));
+        case runtime::Comparator::Less:
+            return make_unique<Less>(std::move(lhs), std::move(rhs));
+        case runtime::Comparator::Greater:
+            return make_unique<Greater>(std::move(lhs), std::move(rhs));
+        case runtime::Comparator::LessOrEqual:
+            return make_unique<LessOrEqual>(std::move(lhs), std::move(rhs));
+        case runtime::Comparator::GreaterOrEqual:
+            return make_unique<GreaterOrEqual>(std::move(lhs), std::move(rhs));
+        }
+        throw std::runtime_error("unknown comparison"s);
+    }
+
+    NewInstance::NewInstance(const runtime::Class& cls, std::vector<std::unique_ptr<Statement>> args) : cls_(cls), args_(move(args)) {
+    }
+
+    NewInstance::NewInstance(const runtime::Class& cls) : cls_(cls) {
+    }
+
+    ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
+        ObjectHolder ob_h = ObjectHolder::Own(runtime::ClassInstance{ cls_ });
+        if (const runtime::Method* class_method = cls_.GetMethod(INIT_METHOD); class_method) {
+            vector<ObjectHolder> args;
+            for (const auto& arg : args_) {
+                args.push_back(arg->Execute(closure, context));
+            }
+            ob_h.TryAs<runtime::ClassInstance>()->Call(class_method->name, args, context);
+        }
+        return ob_h;
+    }
+
+    MethodBody::MethodBody(std::unique_ptr<Statement>&& body) : body_(move(body)) {
+    }
+
+    ObjectHolder MethodBody::Execute(Closure& closure, Context& context) {
+        ObjectHolder result = body_->Execute(closure, context);
+        closure.SetCompletion(runtime::Completion::Normal);
+        return result;
+    }
 }  // namespace ast
\ No newline at end of file
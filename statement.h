@@ -1,256 +1,473 @@
-
-#pragma once
-
-#include "runtime.h"
-
-#include <functional>
-#include <variant>
-
-namespace ast {
-    using Statement = runtime::Executable;
-
-    template <typename T>
-    class ValueStatement : public Statement {
-    public:
-        explicit ValueStatement(T v)
-            : value_(std::move(v)) {
-        }
-
-        runtime::ObjectHolder Execute(runtime::Closure& /*closure*/,
-            runtime::Context& /*context*/) override {
-            return runtime::ObjectHolder::Share(value_);
-        }
-
-    private:
-        T value_;
-    };
-
-    using NumericConst = ValueStatement<runtime::Number>;
-    using StringConst = ValueStatement<runtime::String>;
-    using BoolConst = ValueStatement<runtime::Bool>;
-
-    class VariableValue : public Statement {
-    public:
-        explicit VariableValue(const std::string& var_name);
-        explicit VariableValue(std::vector<std::string> dotted_ids);
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        std::variant<const std::string, std::vector<std::string>> value_;
-    };
-
-    class Assignment : public Statement {
-    public:
-        Assignment(std::string var, std::unique_ptr<Statement> rv);
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        std::string var_;
-        std::unique_ptr<Statement> rv_;
-    };
-
-    class FieldAssignment : public Statement {
-    public:
-        FieldAssignment(VariableValue object, std::string field_name, std::unique_ptr<Statement> rv);
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        VariableValue object_;
-        std::string field_name_;
-        std::unique_ptr<Statement> rv_;
-    };
-
-    class None : public Statement {
-    public:
-        runtime::ObjectHolder Execute([[maybe_unused]] runtime::Closure& closure,
-            [[maybe_unused]] runtime::Context& context) override {
-            return {};
-        }
-    };
-
-    class Print : public Statement {
-    public:
-        explicit Print(std::unique_ptr<Statement> argument);
-
-        explicit Print(std::vector<std::unique_ptr<Statement>> args);
-
-        static std::unique_ptr<Print> Variable(const std::string& name);
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        std::unique_ptr<Statement> argument_;
-        std::vector<std::unique_ptr<Statement>> args_;
-    };
-
-    class MethodCall : public Statement {
-    public:
-        MethodCall(std::unique_ptr<Statement> object, std::string method,
-            std::vector<std::unique_ptr<Statement>> args);
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        std::unique_ptr<Statement> object_;
-        std::string method_;
-        std::vector<std::unique_ptr<Statement>> args_;
-    };
-
-    class NewInstance : public Statement {
-    public:
-        explicit NewInstance(const runtime::Class& cls);
-        NewInstance(const runtime::Class& cls, std::vector<std::unique_ptr<Statement>> args);
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        const runtime::Class& cls_;
-        std::vector<std::unique_ptr<Statement>> args_;
-    };
-
-    class UnaryOperation : public Statement {
-    public:
-        explicit UnaryOperation(std::unique_ptr<Statement> argument) : argument_(std::move(argument)) {
-        }
-    protected:
-        std::unique_ptr<Statement> argument_;
-    };
-
-    class Stringify : public UnaryOperation {
-    public:
-        using UnaryOperation::UnaryOperation;
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    };
-
-    class BinaryOperation : public Statement {
-    public:
-        BinaryOperation(std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {
-        }
-    protected:
-        std::unique_ptr<Statement> lhs_;
-        std::unique_ptr<Statement> rhs_;
-    };
-
-    class Add : public BinaryOperation {
-    public:
-        using BinaryOperation::BinaryOperation;
-
-        template <typename CheckType, typename ResultType>
-        runtime::ObjectHolder AddStatements(const runtime::ObjectHolder& lhs, const runtime::ObjectHolder& rhs) {
-            if (lhs.TryAs<runtime::ValueObject<CheckType>>() && rhs.TryAs<runtime::ValueObject<CheckType>>()) {
-                CheckType result = lhs.TryAs<runtime::ValueObject<CheckType>>()->GetValue() + rhs.TryAs<runtime::ValueObject<CheckType>>()->GetValue();
-                return runtime::ObjectHolder::Own(ResultType(result));
-            }
-            return {};
-        }
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    };
-
-    class Sub : public BinaryOperation {
-    public:
-        using BinaryOperation::BinaryOperation;
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    };
-
-    class Mult : public BinaryOperation {
-    public:
-        using BinaryOperation::BinaryOperation;
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    };
-
-    class Div : public BinaryOperation {
-    public:
-        using BinaryOperation::BinaryOperation;
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    };
-
-    class Or : public BinaryOperation {
-    public:
-        using BinaryOperation::BinaryOperation;
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    };
-
-    class And : public BinaryOperation {
-    public:
-        using BinaryOperation::BinaryOperation;
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    };
-
-    class Not : public UnaryOperation {
-    public:
-        using UnaryOperation::UnaryOperation;
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    };
-
-    class Compound : public Statement {
-    public:
-        template <typename... Args>
-        explicit Compound(Args&&... args) {
-            (AddStatement(std::move(args)), ...);
-        }
-
-        void AddStatement(std::unique_ptr<Statement> stmt) {
-            stmts_.push_back(std::move(stmt));
-        }
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        std::vector<std::unique_ptr<Statement>> stmts_;
-    };
-
-    class MethodBody : public Statement {
-    public:
-        explicit MethodBody(std::unique_ptr<Statement>&& body);
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        std::unique_ptr<Statement> body_;
-    };
-
-    class Return : public Statement {
-    public:
-        explicit Return(std::unique_ptr<Statement> statement) : statement_(move(statement)) {
-        }
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private: 
-        std::unique_ptr<Statement> statement_;
-    };
-
-    class ClassDefinition : public Statement {
-    public:
-        explicit ClassDefinition(runtime::ObjectHolder cls);
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        runtime::ObjectHolder cls_;
-    };
-
-    class IfElse : public Statement {
-    public:
-        IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
-            std::unique_ptr<Statement> else_body);
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        std::unique_ptr<Statement> condition_;
-        std::unique_ptr<Statement> if_body_;
-        std::unique_ptr<Statement> else_body_;
-    };
-
-    class Comparison : public BinaryOperation {
-    public:
-        using Comparator = std::function<bool(const runtime::ObjectHolder&,
-            const runtime::ObjectHolder&, runtime::Context&)>;
-
-        Comparison(Comparator cmp, std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs);
-
-        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-    private:
-        Comparator cmp_;
-    };
-
+
+#pragma once
+
+#include "runtime.h"
+
+namespace ast {
+    using Statement = runtime::Executable;
+
+    // Frame slot of a variable that was not resolved and is looked up in the closure by name
+    inline constexpr size_t NO_SLOT = static_cast<size_t>(-1);
+
+    template <typename T>
+    class ValueStatement : public Statement {
+    public:
+        explicit ValueStatement(T v)
+            : value_(std::move(v)) {
+        }
+
+        runtime::ObjectHolder Execute(runtime::Closure& /*closure*/,
+            runtime::Context& /*context*/) override {
+            if constexpr (runtime::IS_IMMEDIATE<T>) {
+                return runtime::ObjectHolder::Own(T(value_));
+            }
+            else {
+                return runtime::ObjectHolder::Share(value_);
+            }
+        }
+
+        [[nodiscard]] const T& GetValue() const {
+            return value_;
+        }
+
+    private:
+        T value_;
+    };
+
+    using NumericConst = ValueStatement<runtime::Number>;
+    using StringConst = ValueStatement<runtime::String>;
+    using BoolConst = ValueStatement<runtime::Bool>;
+
+    class VariableValue : public Statement {
+    public:
+        explicit VariableValue(runtime::Symbol var_name);
+        explicit VariableValue(std::vector<runtime::Symbol> dotted_ids);
+        explicit VariableValue(const std::vector<std::string>& dotted_ids);
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] const std::vector<runtime::Symbol>& GetDottedIds() const {
+            return dotted_ids_;
+        }
+
+        [[nodiscard]] size_t GetSlot() const {
+            return slot_;
+        }
+
+        void SetSlot(size_t slot) {
+            slot_ = slot;
+        }
+    private:
+        std::vector<runtime::Symbol> dotted_ids_;
+        size_t slot_ = NO_SLOT;
+    };
+
+    class Assignment : public Statement {
+    public:
+        Assignment(runtime::Symbol var, std::unique_ptr<Statement> rv);
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] runtime::Symbol GetName() const {
+            return var_;
+        }
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetValue() const {
+            return rv_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetValue() {
+            return rv_;
+        }
+
+        [[nodiscard]] size_t GetSlot() const {
+            return slot_;
+        }
+
+        void SetSlot(size_t slot) {
+            slot_ = slot;
+        }
+    private:
+        runtime::Symbol var_;
+        std::unique_ptr<Statement> rv_;
+        size_t slot_ = NO_SLOT;
+    };
+
+    class FieldAssignment : public Statement {
+    public:
+        FieldAssignment(VariableValue object, runtime::Symbol field_name, std::unique_ptr<Statement> rv);
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] const VariableValue& GetObject() const {
+            return object_;
+        }
+
+        [[nodiscard]] VariableValue& GetObject() {
+            return object_;
+        }
+
+        [[nodiscard]] runtime::Symbol GetFieldName() const {
+            return field_name_;
+        }
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetValue() const {
+            return rv_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetValue() {
+            return rv_;
+        }
+    private:
+        VariableValue object_;
+        runtime::Symbol field_name_;
+        std::unique_ptr<Statement> rv_;
+    };
+
+    class None : public Statement {
+    public:
+        runtime::ObjectHolder Execute([[maybe_unused]] runtime::Closure& closure,
+            [[maybe_unused]] runtime::Context& context) override {
+            return {};
+        }
+    };
+
+    class Print : public Statement {
+    public:
+        explicit Print(std::unique_ptr<Statement> argument);
+
+        explicit Print(std::vector<std::unique_ptr<Statement>> args);
+
+        static std::unique_ptr<Print> Variable(const std::string& name);
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetArgument() const {
+            return argument_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetArgument() {
+            return argument_;
+        }
+
+        [[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetArgs() const {
+            return args_;
+        }
+
+        [[nodiscard]] std::vector<std::unique_ptr<Statement>>& GetArgs() {
+            return args_;
+        }
+    private:
+        std::unique_ptr<Statement> argument_;
+        // The name when argument_ is a string constant, interned once when the node is built
+        std::optional<runtime::Symbol> variable_;
+        std::vector<std::unique_ptr<Statement>> args_;
+    };
+
+    class MethodCall : public Statement {
+    public:
+        MethodCall(std::unique_ptr<Statement> object, runtime::Symbol method,
+            std::vector<std::unique_ptr<Statement>> args);
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetObject() const {
+            return object_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetObject() {
+            return object_;
+        }
+
+        [[nodiscard]] runtime::Symbol GetMethod() const {
+            return method_;
+        }
+
+        [[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetArgs() const {
+            return args_;
+        }
+
+        [[nodiscard]] std::vector<std::unique_ptr<Statement>>& GetArgs() {
+            return args_;
+        }
+
+        [[nodiscard]] const runtime::MethodCache::Stats& GetCacheStats() const {
+            return cache_.GetStats();
+        }
+    private:
+        std::unique_ptr<Statement> object_;
+        runtime::Symbol method_;
+        std::vector<std::unique_ptr<Statement>> args_;
+        runtime::MethodCache cache_;
+    };
+
+    class NewInstance : public Statement {
+    public:
+        explicit NewInstance(const runtime::Class& cls);
+        NewInstance(const runtime::Class& cls, std::vector<std::unique_ptr<Statement>> args);
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] const runtime::Class& GetClass() const {
+            return cls_;
+        }
+
+        [[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetArgs() const {
+            return args_;
+        }
+
+        [[nodiscard]] std::vector<std::unique_ptr<Statement>>& GetArgs() {
+            return args_;
+        }
+    private:
+        const runtime::Class& cls_;
+        std::vector<std::unique_ptr<Statement>> args_;
+    };
+
+    class UnaryOperation : public Statement {
+    public:
+        explicit UnaryOperation(std::unique_ptr<Statement> argument) : argument_(std::move(argument)) {
+        }
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetArgument() const {
+            return argument_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetArgument() {
+            return argument_;
+        }
+    protected:
+        std::unique_ptr<Statement> argument_;
+    };
+
+    class Stringify : public UnaryOperation {
+    public:
+        using UnaryOperation::UnaryOperation;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    class BinaryOperation : public Statement {
+    public:
+        BinaryOperation(std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs) : lhs_(std::move(lhs)), rhs_(std::move(rhs)) {
+        }
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetLhs() const {
+            return lhs_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetLhs() {
+            return lhs_;
+        }
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetRhs() const {
+            return rhs_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetRhs() {
+            return rhs_;
+        }
+    protected:
+        std::unique_ptr<Statement> lhs_;
+        std::unique_ptr<Statement> rhs_;
+    };
+
+    class Add : public BinaryOperation {
+    public:
+        using BinaryOperation::BinaryOperation;
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    class Sub : public BinaryOperation {
+    public:
+        using BinaryOperation::BinaryOperation;
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    class Mult : public BinaryOperation {
+    public:
+        using BinaryOperation::BinaryOperation;
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    class Div : public BinaryOperation {
+    public:
+        using BinaryOperation::BinaryOperation;
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    class Or : public BinaryOperation {
+    public:
+        using BinaryOperation::BinaryOperation;
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    class And : public BinaryOperation {
+    public:
+        using BinaryOperation::BinaryOperation;
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    class Not : public UnaryOperation {
+    public:
+        using UnaryOperation::UnaryOperation;
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    };
+
+    class Compound : public Statement {
+    public:
+        template <typename... Args>
+        explicit Compound(Args&&... args) {
+            (AddStatement(std::move(args)), ...);
+        }
+
+        void AddStatement(std::unique_ptr<Statement> stmt) {
+            stmts_.push_back(std::move(stmt));
+        }
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetStatements() const {
+            return stmts_;
+        }
+
+        [[nodiscard]] std::vector<std::unique_ptr<Statement>>& GetStatements() {
+            return stmts_;
+        }
+    private:
+        std::vector<std::unique_ptr<Statement>> stmts_;
+    };
+
+    class MethodBody : public Statement {
+    public:
+        explicit MethodBody(std::unique_ptr<Statement>&& body);
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetBody() const {
+            return body_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetBody() {
+            return body_;
+        }
+    private:
+        std::unique_ptr<Statement> body_;
+    };
+
+    class Return : public Statement {
+    public:
+        explicit Return(std::unique_ptr<Statement> statement) : statement_(move(statement)) {
+        }
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetStatement() const {
+            return statement_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetStatement() {
+            return statement_;
+        }
+    private: 
+        std::unique_ptr<Statement> statement_;
+    };
+
+    class ClassDefinition : public Statement {
+    public:
+        explicit ClassDefinition(runtime::ObjectHolder cls);
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] const runtime::ObjectHolder& GetClass() const {
+            return cls_;
+        }
+
+        [[nodiscard]] runtime::Symbol GetName() const {
+            return name_;
+        }
+    private:
+        runtime::ObjectHolder cls_;
+        runtime::Symbol name_;
+    };
+
+    class IfElse : public Statement {
+    public:
+        IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
+            std::unique_ptr<Statement> else_body);
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetCondition() const {
+            return condition_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetCondition() {
+            return condition_;
+        }
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetIfBody() const {
+            return if_body_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetIfBody() {
+            return if_body_;
+        }
+
+        [[nodiscard]] const std::unique_ptr<Statement>& GetElseBody() const {
+            return else_body_;
+        }
+
+        [[nodiscard]] std::unique_ptr<Statement>& GetElseBody() {
+            return else_body_;
+        }
+    private:
+        std::unique_ptr<Statement> condition_;
+        std::unique_ptr<Statement> if_body_;
+        std::unique_ptr<Statement> else_body_;
+    };
+
+    // Base of the comparison nodes, one class per operator
+    class Comparison : public BinaryOperation {
+    public:
+        [[nodiscard]] static std::unique_ptr<Comparison> Make(runtime::Comparator cmp,
+            std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs);
+
+        [[nodiscard]] runtime::Comparator GetComparator() const {
+            return cmp_;
+        }
+    protected:
+        Comparison(runtime::Comparator cmp, std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs)
+            : BinaryOperation(std::move(lhs), std::move(rhs)), cmp_(cmp) {
+        }
+    private:
+        runtime::Comparator cmp_;
+    };
+
+    template <runtime::Comparator CMP>
+    class ComparisonNode final : public Comparison {
+    public:
+        ComparisonNode(std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs)
+            : Comparison(CMP, std::move(lhs), std::move(rhs)) {
+        }
+
+        runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override {
+            const runtime::ObjectHolder lhs = lhs_->Execute(closure, context);
+            const runtime::ObjectHolder rhs = rhs_->Execute(closure, context);
+            return runtime::ObjectHolder::Own(runtime::Bool{ runtime::Compare<CMP>(lhs, rhs, context) });
+        }
+    };
+
+    using Equal = ComparisonNode<runtime::Comparator::Equal>;
+    using NotEqual = ComparisonNode<runtime::Comparator::NotEqual>;
+    using Less = ComparisonNode<runtime::Comparator::Less>;
+    using Greater = ComparisonNode<runtime::Comparator::Greater>;
+    using LessOrEqual = ComparisonNode<runtime::Comparator::LessOrEqual>;
+    using GreaterOrEqual = ComparisonNode<runtime::Comparator::GreaterOrEqual>;
+
 }  // namespace ast
\ No newline at end of file
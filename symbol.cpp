@@ -0,0 +1,63 @@
+#include "symbol.h"
+
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace runtime {
+
+    namespace {
+        class SymbolTable {
+        public:
+            SymbolTable()
+                : empty_(Intern(string_view{})) {
+            }
+
+            [[nodiscard]] const string* GetEmpty() const {
+                return empty_;
+            }
+
+            const string* Intern(string_view name) {
+                lock_guard guard(mutex_);
+                if (const auto it = index_.find(name); it != index_.end()) {
+                    return it->second;
+                }
+                const string* interned = &names_.emplace_back(name);
+                index_.emplace(*interned, interned);
+                return interned;
+            }
+
+        private:
+            mutex mutex_;
+            deque<string> names_;
+            unordered_map<string_view, const string*> index_;
+            const string* empty_;
+        };
+
+        // Function-local so that symbols in static constants of other translation units are safe
+        SymbolTable& GetSymbolTable() {
+            static SymbolTable table;
+            return table;
+        }
+    }  // namespace
+
+    Symbol::Symbol() : name_(GetSymbolTable().GetEmpty()) {
+    }
+
+    Symbol::Symbol(string_view name) : name_(GetSymbolTable().Intern(name)) {
+    }
+
+    Symbol::Symbol(const string& name) : Symbol(string_view{ name }) {
+    }
+
+    Symbol::Symbol(const char* name) : Symbol(string_view{ name }) {
+    }
+
+    std::ostream& operator<<(std::ostream& os, Symbol symbol) {
+        return os << symbol.GetName();
+    }
+
+}  // namespace runtime
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+namespace runtime {
+
+    // Interned identifier. Each distinct spelling is stored once per process,
+    // so symbols are compared and hashed by address. Interning takes a process-wide lock, so
+    // strings are only converted explicitly; the empty default symbol is made without it
+    class Symbol {
+    public:
+        Symbol();
+        explicit Symbol(std::string_view name);
+        explicit Symbol(const std::string& name);
+        Symbol(const char* name);
+
+        [[nodiscard]] const std::string& GetName() const {
+            return *name_;
+        }
+
+        [[nodiscard]] size_t Hash() const {
+            return std::hash<const std::string*>{}(name_);
+        }
+
+        friend bool operator==(Symbol lhs, Symbol rhs) {
+            return lhs.name_ == rhs.name_;
+        }
+
+        friend bool operator!=(Symbol lhs, Symbol rhs) {
+            return lhs.name_ != rhs.name_;
+        }
+
+    private:
+        const std::string* name_;
+    };
+
+    std::ostream& operator<<(std::ostream& os, Symbol symbol);
+
+}  // namespace runtime
+
+namespace std {
+
+    template <>
+    struct hash<runtime::Symbol> {
+        size_t operator()(runtime::Symbol symbol) const noexcept {
+            return symbol.Hash();
+        }
+    };
+
+}  // namespace std
@@ -0,0 +1,201 @@
+#include "workload.h"
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <string_view>
+
+using namespace std;
+
+namespace workload {
+
+    namespace {
+        constexpr string_view WORDS[] = {
+            "alpha"sv, "beta"sv, "gamma"sv, "delta"sv, "item"sv, "value"sv, "node"sv, "total"sv,
+            "scale"sv, "frame"sv, "index"sv, "label"sv, "state"sv, "count"sv, "left"sv, "right"sv,
+        };
+
+        class Generator {
+        public:
+            explicit Generator(const ProgramShape& shape)
+                : shape_(shape), random_(shape.seed) {
+            }
+
+            string Generate() {
+                for (int unit = 0; out_.size() < shape_.target_size; ++unit) {
+                    if (shape_.max_classes != 0 && classes_ >= shape_.max_classes) {
+                        break;
+                    }
+                    WriteUnit(unit);
+                }
+                return std::move(out_);
+            }
+
+        private:
+            // mt19937_64 is specified to the bit; the standard distributions are not
+            uint64_t Below(uint64_t bound) {
+                return random_() % bound;
+            }
+
+            bool Chance(double probability) {
+                return static_cast<double>(random_() >> 11) * 0x1.0p-53 < probability;
+            }
+
+            string_view Word() {
+                return WORDS[Below(size(WORDS))];
+            }
+
+            string Number(uint64_t bound) {
+                return to_string(Below(bound) + 1);
+            }
+
+            string StringLiteral() {
+                const char quote = Chance(0.5) ? '\'' : '"';
+                string literal(1, quote);
+                literal += Word();
+                if (Chance(0.2)) {
+                    literal += quote == '\'' ? "\\'"sv : "\\\""sv;
+                }
+                literal += ' ';
+                literal += Word();
+                if (Chance(0.1)) {
+                    literal += "\\t"sv;
+                }
+                literal += quote;
+                return literal;
+            }
+
+            void Line(int indent, string_view text) {
+                if (Chance(shape_.comment_density)) {
+                    out_.append(indent * 2, ' ');
+                    out_ += "# "sv;
+                    out_ += Word();
+                    out_ += ' ';
+                    out_ += Word();
+                    out_ += " of the "sv;
+                    out_ += Word();
+                    out_ += '\n';
+                }
+                out_.append(indent * 2, ' ');
+                out_ += text;
+                out_ += '\n';
+                if (Chance(shape_.blank_line_density)) {
+                    out_ += '\n';
+                }
+            }
+
+            static string ClassName(int unit, int level) {
+                return "C"s + to_string(unit) + '_' + to_string(level);
+            }
+
+            static string MethodName(int level, int index) {
+                return "m"s + to_string(level) + '_' + to_string(index);
+            }
+
+            static bool IsRecursive(int index) {
+                return index % 3 == 1;
+            }
+
+            void WriteUnit(int unit) {
+                int depth = max(shape_.inheritance_depth, 1);
+                if (shape_.max_classes != 0) {
+                    depth = static_cast<int>(min<size_t>(depth, shape_.max_classes - classes_));
+                }
+                for (int level = 0; level < depth; ++level) {
+                    WriteClass(unit, level);
+                }
+                classes_ += depth;
+
+                Line(0, "item = "s + ClassName(unit, depth - 1) + '(' + to_string(unit) + ')');
+                for (int level = 0; level < depth; ++level) {
+                    for (int index = 0; index < shape_.methods_per_class; ++index) {
+                        const string argument = IsRecursive(index) ? to_string(shape_.recursion_depth) : Number(9);
+                        Line(0, "print item."s + MethodName(level, index) + '(' + argument + ')');
+                    }
+                }
+                Line(0, "print item"sv);
+                Line(0, "if item.value > "s + Number(100) + " and not item.label == "s + StringLiteral() + ':');
+                Line(1, "print "s + StringLiteral() + ", item.value"s);
+                Line(0, "else:"sv);
+                Line(1, "print "s + StringLiteral());
+                out_ += '\n';
+            }
+
+            void WriteClass(int unit, int level) {
+                string header = "class "s + ClassName(unit, level);
+                if (level > 0) {
+                    header += '(' + ClassName(unit, level - 1) + ')';
+                }
+                Line(0, header + ':');
+                if (level == 0) {
+                    Line(1, "def __init__(value):"sv);
+                    Line(2, "self.value = value"sv);
+                    Line(2, "self.label = "s + StringLiteral());
+                    Line(1, "def __str__():"sv);
+                    Line(2, "return self.label + ' #' + str(self.value)"sv);
+                }
+                for (int index = 0; index < shape_.methods_per_class; ++index) {
+                    if (IsRecursive(index)) {
+                        WriteRecursiveMethod(MethodName(level, index));
+                    }
+                    else {
+                        WriteMethod(MethodName(level, index));
+                    }
+                }
+                if (level > 0 && shape_.methods_per_class == 0) {
+                    // A class needs a body
+                    Line(1, "def empty():"sv);
+                    Line(2, "return None"sv);
+                }
+                out_ += '\n';
+            }
+
+            void WriteRecursiveMethod(const string& name) {
+                Line(1, "def "s + name + "(n):"s);
+                Line(2, "if n > 0:"sv);
+                Line(3, "return self."s + name + "(n - 1) + "s + Number(5));
+                Line(2, "return 0"sv);
+            }
+
+            void WriteMethod(const string& name) {
+                Line(1, "def "s + name + "(x):"s);
+                string last_string;
+                string last_number;
+                for (int i = 0; i < shape_.statements_per_method; ++i) {
+                    if (Chance(shape_.string_density)) {
+                        last_string = "s"s + to_string(i);
+                        Line(2, last_string + " = "s + StringLiteral() + " + str(x)"s);
+                    }
+                    else {
+                        last_number = "n"s + to_string(i);
+                        Line(2, last_number + " = x * "s + Number(20) + " + self.value / "s + Number(7));
+                    }
+                }
+                Line(2, "y = x + "s + (last_number.empty() ? Number(50) : last_number));
+                WriteIfNest(2, shape_.if_nesting);
+                Line(2, last_string.empty() ? "return y"s : "return "s + last_string + " + str(y)"s);
+            }
+
+            void WriteIfNest(int indent, int depth) {
+                if (depth <= 0) {
+                    return;
+                }
+                Line(indent, "if y > "s + Number(100) + ':');
+                Line(indent + 1, "y = y - "s + Number(30));
+                WriteIfNest(indent + 1, depth - 1);
+                Line(indent, "else:"sv);
+                Line(indent + 1, "y = y * "s + Number(3) + " + 1"s);
+            }
+
+            const ProgramShape& shape_;
+            mt19937_64 random_;
+            string out_;
+            size_t classes_ = 0;
+        };
+    }  // namespace
+
+    string GenerateProgram(const ProgramShape& shape) {
+        return Generator(shape).Generate();
+    }
+
+}  // namespace workload
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace workload {
+
+    // Shape of a generated program. The program is a run of units until it reaches target_size
+    // bytes, or max_classes classes when that is set. A unit is a chain of inheritance_depth
+    // classes, each adding methods_per_class methods, and top-level code that creates an instance
+    // of the last class of the chain and calls every method it has
+    struct ProgramShape {
+        std::uint64_t seed = 1;
+        std::size_t target_size = 64 * 1024;
+        // 0 for no limit but target_size
+        std::size_t max_classes = 0;
+
+        int inheritance_depth = 2;
+        int methods_per_class = 3;
+        // Statements of a method body besides its if/else nest and return
+        int statements_per_method = 3;
+        // Depth of the if/else nest in every method that is not recursive
+        int if_nesting = 2;
+        // Number of self-calls of the recursive methods, one in every three methods
+        int recursion_depth = 20;
+
+        // Chance of a statement working on strings instead of numbers, from 0 to 1
+        double string_density = 0.3;
+        // Chance of a comment line before a statement and of a blank line after one
+        double comment_density = 0.1;
+        double blank_line_density = 0.1;
+    };
+
+    // A valid Mython program of the given shape that runs to completion and prints. The same
+    // shape gives the same program on every platform; another seed gives another program
+    std::string GenerateProgram(const ProgramShape& shape);
+
+}  // namespace workload
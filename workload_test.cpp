@@ -0,0 +1,114 @@
+#include "lexer.h"
+#include "optimize.h"
+#include "parse.h"
+#include "workload.h"
+
+#include "test_runner_p.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace workload {
+
+    namespace {
+        string Run(string_view program) {
+            parse::Lexer lexer(program);
+            auto tree = ParseProgram(lexer);
+            runtime::DummyContext context;
+            runtime::Closure closure;
+            tree->Execute(closure, context);
+            return context.output.str();
+        }
+
+        size_t CountLines(const string& program, char first) {
+            size_t count = 0;
+            size_t line_begin = 0;
+            while (line_begin < program.size()) {
+                const size_t line_end = min(program.find('\n', line_begin), program.size());
+                const size_t text = program.find_first_not_of(' ', line_begin);
+                if (text < line_end ? program[text] == first : first == '\n') {
+                    ++count;
+                }
+                line_begin = line_end + 1;
+            }
+            return count;
+        }
+    }  // namespace
+
+    void TestGenerationIsDeterministic() {
+        ProgramShape shape;
+        shape.target_size = 8 * 1024;
+        const string program = GenerateProgram(shape);
+        ASSERT_EQUAL(GenerateProgram(shape), program);
+        ASSERT(program.size() >= shape.target_size);
+        ASSERT(program.size() < shape.target_size * 2);
+
+        shape.seed = 2;
+        ASSERT(GenerateProgram(shape) != program);
+    }
+
+    void TestGeneratedProgramsRun() {
+        vector<ProgramShape> shapes(6);
+        shapes[1].inheritance_depth = 6;
+        shapes[1].methods_per_class = 1;
+        shapes[2].if_nesting = 8;
+        shapes[2].statements_per_method = 0;
+        shapes[3].recursion_depth = 200;
+        shapes[3].string_density = 1;
+        shapes[4].methods_per_class = 0;
+        shapes[4].comment_density = 1;
+        shapes[4].blank_line_density = 1;
+        shapes[5].inheritance_depth = 1;
+        shapes[5].string_density = 0;
+        shapes[5].comment_density = 0;
+        shapes[5].blank_line_density = 0;
+        for (ProgramShape& shape : shapes) {
+            shape.target_size = 16 * 1024;
+            const string program = GenerateProgram(shape);
+            const string output = Run(program);
+            ASSERT(!output.empty());
+
+            // The corpus is also a check of the passes over the tree
+            parse::Lexer lexer(program);
+            auto tree = ParseProgram(lexer);
+            ast::Optimize(tree);
+            runtime::DummyContext context;
+            runtime::Closure closure;
+            tree->Execute(closure, context);
+            ASSERT_EQUAL(context.output.str(), output);
+        }
+    }
+
+    void TestShapeControlsProgram() {
+        ProgramShape shape;
+        shape.max_classes = 7;
+        shape.inheritance_depth = 3;
+        shape.target_size = 1024 * 1024;
+        string program = GenerateProgram(shape);
+        ASSERT_EQUAL(CountLines(program, 'c'), 7U);
+        ASSERT(program.find("class C2_0:"s) != string::npos);
+        ASSERT(program.find("class C1_2(C1_1):"s) != string::npos);
+        ASSERT(program.find("class C2_1"s) == string::npos);
+        Run(program);
+
+        shape.comment_density = 0;
+        shape.blank_line_density = 0;
+        program = GenerateProgram(shape);
+        ASSERT_EQUAL(CountLines(program, '#'), 0U);
+        const size_t blank_lines = CountLines(program, '\n');
+        shape.comment_density = 0.5;
+        shape.blank_line_density = 0.5;
+        program = GenerateProgram(shape);
+        ASSERT(CountLines(program, '#') > 10);
+        ASSERT(CountLines(program, '\n') > blank_lines + 10);
+        Run(program);
+    }
+
+    void RunWorkloadTests(TestRunner& tr) {
+        RUN_TEST(tr, workload::TestGenerationIsDeterministic);
+        RUN_TEST(tr, workload::TestGeneratedProgramsRun);
+        RUN_TEST(tr, workload::TestShapeControlsProgram);
+    }
+
+}  // namespace workload